@@ -0,0 +1,101 @@
+#include "Benchmark.h"
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="minTimeMs">time every case runs at least, after a warm-up iteration</param>
+/// <param name="filter">only cases whose name contains the filter run - empty runs all of them</param>
+Benchmark::Benchmark(size_t minTimeMs, const std::string& filter) {
+	this->minTime = std::chrono::milliseconds(minTimeMs);
+	this->filter = filter;
+	this->sink = 0;
+}
+
+/// <summary>
+/// Returns whether a case runs under the filter
+/// </summary>
+/// <param name="name"></param>
+/// <returns></returns>
+bool Benchmark::isSelected(const std::string& name) const {
+	return this->filter.empty() || name.find(this->filter) != std::string::npos;
+}
+
+/// <summary>
+/// Runs a case until the minimum time passes, doubling the iterations of every round, and keeps the
+/// measurement of the last round
+/// </summary>
+/// <param name="name"></param>
+/// <param name="bytes">bytes processed by an iteration - 0 for a latency case</param>
+/// <param name="alignment">offset of the buffer from an aligned address</param>
+/// <param name="operation">a single iteration - returns a value depending on its work, so it is not optimized away</param>
+void Benchmark::run(const std::string& name, size_t bytes, size_t alignment, const std::function<uint64_t()>& operation) {
+
+	if (!this->isSelected(name))
+		return;
+
+	try {
+		// a warm-up iteration fills the caches and lets lazy initialization happen outside the measurement
+		this->sink += operation();
+
+		uint64_t iterations = 1;
+		std::chrono::duration<double, std::nano> elapsed(0);
+		while (true) {
+			auto start = std::chrono::steady_clock::now();
+			for (uint64_t i = 0; i < iterations; i++)
+				this->sink += operation();
+			elapsed = std::chrono::steady_clock::now() - start;
+
+			if (elapsed >= this->minTime)
+				break;
+			iterations *= 2;
+		}
+
+		BenchmarkResult result = { name, bytes, alignment, iterations, elapsed.count() / iterations, 0 };
+		if (bytes > 0)
+			result.mbPerSecond = (double)bytes / (1024 * 1024) / (result.nsPerOp / 1e9);
+		this->results.push_back(result);
+
+		// progress goes to the error stream, so the results can be redirected alone
+		std::cerr << name << " bytes=" << bytes << " alignment=" << alignment << ": " << std::fixed
+			<< std::setprecision(1) << result.nsPerOp << " ns/op";
+		if (bytes > 0)
+			std::cerr << ", " << result.mbPerSecond << " MB/s";
+		std::cerr << std::endl;
+	}
+
+	catch (std::exception& e)
+	{
+		std::cerr << "Exception: " << e.what() << std::endl;
+	}
+}
+
+/// <summary>
+/// Writes the results in json
+/// </summary>
+/// <param name="out"></param>
+void Benchmark::writeJson(std::ostream& out) const {
+
+	out << "{" << std::endl << "  \"benchmarks\": [" << std::endl;
+	for (size_t i = 0; i < this->results.size(); i++) {
+		const BenchmarkResult& result = this->results[i];
+		out << "    {\"name\": \"" << result.name << "\", \"bytes\": " << result.bytes << ", \"alignment\": "
+			<< result.alignment << ", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << std::fixed
+			<< std::setprecision(1) << result.nsPerOp << ", \"mb_per_s\": " << std::setprecision(2)
+			<< result.mbPerSecond << "}" << (i + 1 < this->results.size() ? "," : "") << std::endl;
+	}
+	out << "  ]" << std::endl << "}" << std::endl;
+}
+
+/// <summary>
+/// Writes the results in csv, with a header line
+/// </summary>
+/// <param name="out"></param>
+void Benchmark::writeCsv(std::ostream& out) const {
+
+	out << "name,bytes,alignment,iterations,ns_per_op,mb_per_s" << std::endl;
+	for (const BenchmarkResult& result : this->results) {
+		out << result.name << "," << result.bytes << "," << result.alignment << "," << result.iterations << ","
+			<< std::fixed << std::setprecision(1) << result.nsPerOp << "," << std::setprecision(2) << result.mbPerSecond
+			<< std::endl;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+const size_t DEFAULT_MIN_TIME_MS = 200;
+
+/// <summary>
+/// Measurement of a single benchmark case
+/// </summary>
+struct BenchmarkResult {
+	std::string name;
+	size_t bytes;
+	size_t alignment;
+	uint64_t iterations;
+	double nsPerOp;
+	double mbPerSecond;
+};
+
+/// <summary>
+/// Runs benchmark cases and writes their results in a machine readable format (json or csv),
+/// one case per line so results of two builds can be diffed
+/// </summary>
+class Benchmark {
+
+private:
+	// members
+	std::chrono::milliseconds minTime;
+	std::string filter;
+	std::vector<BenchmarkResult> results;
+	uint64_t sink;
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	/// <param name="minTimeMs">time every case runs at least, after a warm-up iteration</param>
+	/// <param name="filter">only cases whose name contains the filter run - empty runs all of them</param>
+	Benchmark(size_t minTimeMs, const std::string& filter);
+
+	/// <summary>
+	/// Returns whether a case runs under the filter
+	/// </summary>
+	/// <param name="name"></param>
+	/// <returns></returns>
+	bool isSelected(const std::string& name) const;
+
+	/// <summary>
+	/// Runs a case until the minimum time passes, doubling the iterations of every round, and keeps the
+	/// measurement of the last round
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="bytes">bytes processed by an iteration - 0 for a latency case</param>
+	/// <param name="alignment">offset of the buffer from an aligned address</param>
+	/// <param name="operation">a single iteration - returns a value depending on its work, so it is not optimized away</param>
+	void run(const std::string& name, size_t bytes, size_t alignment, const std::function<uint64_t()>& operation);
+
+	/// <summary>
+	/// Writes the results in json
+	/// </summary>
+	/// <param name="out"></param>
+	void writeJson(std::ostream& out) const;
+
+	/// <summary>
+	/// Writes the results in csv, with a header line
+	/// </summary>
+	/// <param name="out"></param>
+	void writeCsv(std::ostream& out) const;
+};
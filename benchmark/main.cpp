@@ -0,0 +1,172 @@
+#include "Benchmark.h"
+#include "crc.h"
+#include "AESWrapper.h"
+#include "Base64Wrapper.h"
+#include "RSAWrapper.h"
+#include <random>
+#include <memory>
+
+const size_t BUFFER_ALIGNMENT = 64;
+const size_t DEFAULT_MAX_BUFFER_SIZE = 64 * 1024 * 1024;	// the 1GB size holds several GB at once, so it is opt-in
+const size_t MAX_BUFFER_SIZE = 1024 * 1024 * 1024;
+const size_t SIZE_STEP = 16;
+const size_t MIN_BUFFER_SIZE = 64;
+const size_t ALIGNMENTS[] = { 0, 1 };
+
+/// <summary>
+/// Options of a benchmark run
+/// </summary>
+struct BenchmarkOptions {
+	size_t minTimeMs = DEFAULT_MIN_TIME_MS;
+	size_t maxSize = DEFAULT_MAX_BUFFER_SIZE;
+	std::string filter;
+	std::string format = "json";
+	std::string outPath;
+};
+
+/// <summary>
+/// Parses command line arguments into options
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <param name="options"></param>
+/// <returns>true if all the arguments are valid, false otherwise</returns>
+bool parseOptions(int argc, char* argv[], BenchmarkOptions& options) {
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+
+		try {
+			if (arg == "--min-time")
+				options.minTimeMs = std::stoul(value);
+			else if (arg == "--max-size")
+				options.maxSize = std::min((size_t)std::stoull(value), MAX_BUFFER_SIZE);
+			else if (arg == "--filter")
+				options.filter = value;
+			else if (arg == "--format" && (value == "json" || value == "csv"))
+				options.format = value;
+			else if (arg == "--out")
+				options.outPath = value;
+			else
+				return false;
+		}
+		catch (std::exception&) {
+			return false;
+		}
+	}
+
+	// every option is followed by its value
+	return argc % 2 == 1;
+}
+
+/// <summary>
+/// Benchmarks throughput of the cksum, encryption and encoding of file content, and latency of the RSA key exchange
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int main(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		std::cout << "Usage: benchmark [--min-time <ms>] [--max-size <bytes>] [--filter <name>] [--format json|csv] "
+			"[--out <path>]" << std::endl;
+		std::cout << "  --max-size <bytes>\tlargest buffer, up to " << MAX_BUFFER_SIZE << " (default "
+			<< DEFAULT_MAX_BUFFER_SIZE << ")" << std::endl;
+		return 1;
+	}
+
+	Benchmark benchmark(options.minTimeMs, options.filter);
+
+	// a single buffer of random bytes serves all the sizes - aligned, so its offsets give the alignments to measure
+	std::vector<char> storage(options.maxSize + 2 * BUFFER_ALIGNMENT);
+	char* aligned = storage.data() + (BUFFER_ALIGNMENT - (uintptr_t)storage.data() % BUFFER_ALIGNMENT) % BUFFER_ALIGNMENT;
+	std::mt19937 random(0);
+	for (char& c : storage)
+		c = (char)random();
+
+	const unsigned char key[AESWrapper::DEFAULT_KEYLENGTH] = { 0 };
+	AESWrapper aes(key, AESWrapper::DEFAULT_KEYLENGTH);
+
+	for (size_t size = MIN_BUFFER_SIZE; size <= options.maxSize; size *= SIZE_STEP) {
+
+		for (size_t alignment : ALIGNMENTS) {
+			char* buffer = aligned + alignment;
+
+			benchmark.run("crc_update", size, alignment, [buffer, size]() {
+				CRC crc;
+				crc.update((unsigned char*)buffer, (uint32_t)size);
+				return (uint64_t)crc.digest();
+			});
+
+			benchmark.run("aes_encrypt", size, alignment, [&aes, buffer, size]() {
+				return (uint64_t)aes.encrypt(buffer, (unsigned int)size).size();
+			});
+
+			if (benchmark.isSelected("aes_decrypt")) {
+				// the cipher is placed at the same offset from an aligned address as the plain content
+				std::string cipher = aes.encrypt(buffer, (unsigned int)size);
+				std::vector<char> cipherStorage(cipher.size() + 2 * BUFFER_ALIGNMENT);
+				char* cipherBuffer = cipherStorage.data() + alignment
+					+ (BUFFER_ALIGNMENT - (uintptr_t)cipherStorage.data() % BUFFER_ALIGNMENT) % BUFFER_ALIGNMENT;
+				std::copy(cipher.begin(), cipher.end(), cipherBuffer);
+				size_t cipherSize = cipher.size();
+				cipher.clear();
+				cipher.shrink_to_fit();
+
+				benchmark.run("aes_decrypt", size, alignment, [&aes, cipherBuffer, cipherSize]() {
+					return (uint64_t)aes.decrypt(cipherBuffer, (unsigned int)cipherSize).size();
+				});
+			}
+		}
+
+		// the base64 wrapper takes strings, which are always allocated aligned
+		if (benchmark.isSelected("base64")) {
+			std::string plain(aligned, size);
+			benchmark.run("base64_encode", size, 0, [&plain]() {
+				return (uint64_t)Base64Wrapper::encode(plain).size();
+			});
+
+			std::string encoded = Base64Wrapper::encode(plain);
+			plain.clear();
+			plain.shrink_to_fit();
+			benchmark.run("base64_decode", size, 0, [&encoded]() {
+				return (uint64_t)Base64Wrapper::decode(encoded).size();
+			});
+		}
+	}
+
+	// the key exchange - the client generates a key pair, and decrypts the AES key the server encrypted with its public key
+	benchmark.run("rsa_keygen", 0, 0, []() {
+		RSAPrivateWrapper rsapriv;
+		return (uint64_t)rsapriv.getPublicKey().size();
+	});
+
+	if (benchmark.isSelected("rsa_encrypt") || benchmark.isSelected("rsa_decrypt")) {
+		RSAPrivateWrapper rsapriv;
+		RSAPublicWrapper rsapub(rsapriv.getPublicKey());
+		std::string aesKey((const char*)key, AESWrapper::DEFAULT_KEYLENGTH);
+		std::string cipher = rsapub.encrypt(aesKey);
+
+		benchmark.run("rsa_encrypt", 0, 0, [&rsapub, &aesKey]() {
+			return (uint64_t)rsapub.encrypt(aesKey).size();
+		});
+		benchmark.run("rsa_decrypt", 0, 0, [&rsapriv, &cipher]() {
+			return (uint64_t)rsapriv.decrypt(cipher).size();
+		});
+	}
+
+	if (options.outPath.empty()) {
+		options.format == "csv" ? benchmark.writeCsv(std::cout) : benchmark.writeJson(std::cout);
+		return 0;
+	}
+
+	std::ofstream out(options.outPath);
+	if (!out.is_open()) {
+		std::cout << "Cannot open " << options.outPath << std::endl;
+		return 1;
+	}
+	options.format == "csv" ? benchmark.writeCsv(out) : benchmark.writeJson(out);
+	return 0;
+}
@@ -0,0 +1,192 @@
+#include "ClientMetrics.h"
+
+std::atomic<uint64_t> ClientMetrics::bytesSent(0);
+std::atomic<uint64_t> ClientMetrics::bytesReceived(0);
+std::atomic<uint64_t> ClientMetrics::retransmittedBytes(0);
+std::atomic<uint64_t> ClientMetrics::connectFailures(0);
+std::atomic<int64_t> ClientMetrics::inFlightRequests(0);
+std::mutex ClientMetrics::mutex;
+std::map<std::string, uint64_t> ClientMetrics::filesByStatus;
+std::map<unsigned short, uint64_t> ClientMetrics::cksumFailuresByTrial;
+ClientMetrics::LatencySummary ClientMetrics::connectLatency;
+ClientMetrics::LatencySummary ClientMetrics::keyExchangeLatency;
+std::string ClientMetrics::textfilePath;
+
+/// <summary>
+/// Sets the path of the file the metrics are written to
+/// </summary>
+/// <param name="path"></param>
+void ClientMetrics::setTextfilePath(const std::string& path) {
+	std::lock_guard<std::mutex> lock(mutex);
+	textfilePath = path;
+}
+
+/// <summary>
+/// Counts bytes written to the server
+/// </summary>
+/// <param name="bytes"></param>
+void ClientMetrics::addBytesSent(uint64_t bytes) {
+	bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Counts bytes read from the server
+/// </summary>
+/// <param name="bytes"></param>
+void ClientMetrics::addBytesReceived(uint64_t bytes) {
+	bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Counts content bytes sent again - after a failed cksum or a broken connection
+/// </summary>
+/// <param name="bytes"></param>
+void ClientMetrics::addRetransmittedBytes(uint64_t bytes) {
+	retransmittedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Sets the number of requests waiting for a response
+/// </summary>
+/// <param name="count"></param>
+void ClientMetrics::setInFlightRequests(int64_t count) {
+	inFlightRequests.store(count, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Records a connection attempt to the server
+/// </summary>
+/// <param name="latency"></param>
+/// <param name="isConnected"></param>
+void ClientMetrics::recordConnect(std::chrono::steady_clock::duration latency, bool isConnected) {
+
+	if (!isConnected) {
+		connectFailures.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	connectLatency.sumSeconds += std::chrono::duration<double>(latency).count();
+	connectLatency.count++;
+}
+
+/// <summary>
+/// Records a key exchange which got the AES key
+/// </summary>
+/// <param name="latency"></param>
+void ClientMetrics::recordKeyExchange(std::chrono::steady_clock::duration latency) {
+	std::lock_guard<std::mutex> lock(mutex);
+	keyExchangeLatency.sumSeconds += std::chrono::duration<double>(latency).count();
+	keyExchangeLatency.count++;
+}
+
+/// <summary>
+/// Counts a file of a batch by its final status
+/// </summary>
+/// <param name="status"></param>
+void ClientMetrics::recordFile(const std::string& status) {
+	std::lock_guard<std::mutex> lock(mutex);
+	filesByStatus[status]++;
+}
+
+/// <summary>
+/// Counts a cksum failure of a file by the number of times the file was sent
+/// </summary>
+/// <param name="trial"></param>
+void ClientMetrics::recordCksumFailure(unsigned short trial) {
+	std::lock_guard<std::mutex> lock(mutex);
+	cksumFailuresByTrial[trial]++;
+}
+
+/// <summary>
+/// Writes the help and type lines of a metric
+/// </summary>
+/// <param name="out"></param>
+/// <param name="name"></param>
+/// <param name="type"></param>
+/// <param name="help"></param>
+void ClientMetrics::writeHeader(std::ostream& out, const std::string& name, const std::string& type, const std::string& help) {
+	out << "# HELP " << name << " " << help << std::endl;
+	out << "# TYPE " << name << " " << type << std::endl;
+}
+
+/// <summary>
+/// Writes all the metrics in the Prometheus text format
+/// </summary>
+/// <param name="out"></param>
+void ClientMetrics::write(std::ostream& out) {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	writeHeader(out, "upload_client_bytes_sent_total", "counter", "Bytes written to the server.");
+	out << "upload_client_bytes_sent_total " << bytesSent.load() << std::endl;
+
+	writeHeader(out, "upload_client_bytes_received_total", "counter", "Bytes read from the server.");
+	out << "upload_client_bytes_received_total " << bytesReceived.load() << std::endl;
+
+	writeHeader(out, "upload_client_retransmitted_bytes_total", "counter",
+		"Content bytes sent again after a failed cksum or a broken connection.");
+	out << "upload_client_retransmitted_bytes_total " << retransmittedBytes.load() << std::endl;
+
+	writeHeader(out, "upload_client_files_total", "counter", "Files of batches by their final status.");
+	for (const auto& entry : filesByStatus)
+		out << "upload_client_files_total{status=\"" << entry.first << "\"} " << entry.second << std::endl;
+
+	writeHeader(out, "upload_client_cksum_failures_total", "counter",
+		"Cksum failures by the number of times the file was sent.");
+	for (const auto& entry : cksumFailuresByTrial)
+		out << "upload_client_cksum_failures_total{trial=\"" << entry.first << "\"} " << entry.second << std::endl;
+
+	writeHeader(out, "upload_client_in_flight_requests", "gauge", "Requests waiting for a response from the server.");
+	out << "upload_client_in_flight_requests " << inFlightRequests.load() << std::endl;
+
+	writeHeader(out, "upload_client_connect_failures_total", "counter", "Connection attempts which failed.");
+	out << "upload_client_connect_failures_total " << connectFailures.load() << std::endl;
+
+	writeHeader(out, "upload_client_connect_seconds", "summary", "Time to resolve the server and connect to it.");
+	out << "upload_client_connect_seconds_sum " << connectLatency.sumSeconds << std::endl;
+	out << "upload_client_connect_seconds_count " << connectLatency.count << std::endl;
+
+	writeHeader(out, "upload_client_key_exchange_seconds", "summary",
+		"Time to generate an RSA key pair and get the AES key from the server.");
+	out << "upload_client_key_exchange_seconds_sum " << keyExchangeLatency.sumSeconds << std::endl;
+	out << "upload_client_key_exchange_seconds_count " << keyExchangeLatency.count << std::endl;
+}
+
+/// <summary>
+/// Writes the metrics to their file, if it is set - through a temporary file which replaces it,
+/// so the collector never reads a partly written file
+/// </summary>
+/// <returns>false if the file couldn't be written</returns>
+bool ClientMetrics::flush() {
+
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		path = textfilePath;
+	}
+	if (path.empty())
+		return true;
+
+	try {
+		// the collector reads only files ending with .prom, so the temporary one is skipped
+		std::string temporaryPath = path + ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ofstream::trunc);
+			if (!out.is_open()) {
+				Logger::error("Cannot write metrics", { { "path", temporaryPath } });
+				return false;
+			}
+			write(out);
+		}
+
+		std::filesystem::rename(temporaryPath, path);
+		return true;
+	}
+
+	catch (std::exception& e)
+	{
+		std::cerr << "Exception: " << e.what() << std::endl;
+		return false;
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include "Logger.h"
+
+/// <summary>
+/// Counters and gauges of the uploads of the process, written in the Prometheus text format to a file
+/// for the textfile collector of node_exporter
+/// </summary>
+class ClientMetrics {
+
+private:
+	/// <summary>
+	/// Sum and count of observed latencies - a summary without quantiles
+	/// </summary>
+	struct LatencySummary {
+		double sumSeconds = 0;
+		uint64_t count = 0;
+	};
+
+	// members
+	static std::atomic<uint64_t> bytesSent;
+	static std::atomic<uint64_t> bytesReceived;
+	static std::atomic<uint64_t> retransmittedBytes;
+	static std::atomic<uint64_t> connectFailures;
+	static std::atomic<int64_t> inFlightRequests;
+	static std::mutex mutex;
+	static std::map<std::string, uint64_t> filesByStatus;
+	static std::map<unsigned short, uint64_t> cksumFailuresByTrial;
+	static LatencySummary connectLatency;
+	static LatencySummary keyExchangeLatency;
+	static std::string textfilePath;
+
+	/// <summary>
+	/// Writes the help and type lines of a metric
+	/// </summary>
+	/// <param name="out"></param>
+	/// <param name="name"></param>
+	/// <param name="type"></param>
+	/// <param name="help"></param>
+	static void writeHeader(std::ostream& out, const std::string& name, const std::string& type, const std::string& help);
+
+public:
+	/// <summary>
+	/// Sets the path of the file the metrics are written to
+	/// </summary>
+	/// <param name="path"></param>
+	static void setTextfilePath(const std::string& path);
+
+	/// <summary>
+	/// Counts bytes written to the server
+	/// </summary>
+	/// <param name="bytes"></param>
+	static void addBytesSent(uint64_t bytes);
+
+	/// <summary>
+	/// Counts bytes read from the server
+	/// </summary>
+	/// <param name="bytes"></param>
+	static void addBytesReceived(uint64_t bytes);
+
+	/// <summary>
+	/// Counts content bytes sent again - after a failed cksum or a broken connection
+	/// </summary>
+	/// <param name="bytes"></param>
+	static void addRetransmittedBytes(uint64_t bytes);
+
+	/// <summary>
+	/// Sets the number of requests waiting for a response
+	/// </summary>
+	/// <param name="count"></param>
+	static void setInFlightRequests(int64_t count);
+
+	/// <summary>
+	/// Records a connection attempt to the server
+	/// </summary>
+	/// <param name="latency"></param>
+	/// <param name="isConnected"></param>
+	static void recordConnect(std::chrono::steady_clock::duration latency, bool isConnected);
+
+	/// <summary>
+	/// Records a key exchange which got the AES key
+	/// </summary>
+	/// <param name="latency"></param>
+	static void recordKeyExchange(std::chrono::steady_clock::duration latency);
+
+	/// <summary>
+	/// Counts a file of a batch by its final status
+	/// </summary>
+	/// <param name="status"></param>
+	static void recordFile(const std::string& status);
+
+	/// <summary>
+	/// Counts a cksum failure of a file by the number of times the file was sent
+	/// </summary>
+	/// <param name="trial"></param>
+	static void recordCksumFailure(unsigned short trial);
+
+	/// <summary>
+	/// Writes all the metrics in the Prometheus text format
+	/// </summary>
+	/// <param name="out"></param>
+	static void write(std::ostream& out);
+
+	/// <summary>
+	/// Writes the metrics to their file, if it is set - through a temporary file which replaces it,
+	/// so the collector never reads a partly written file
+	/// </summary>
+	/// <returns>false if the file couldn't be written</returns>
+	static bool flush();
+};
@@ -0,0 +1,319 @@
+#include "ClientOptions.h"
+
+/// <summary>
+/// Ctor
+/// </summary>
+ClientOptions::ClientOptions() {
+	this->windowSize = DEFAULT_WINDOW_SIZE;
+	this->compressionCodec = CODEC_NONE;
+	this->watchDebounceMs = 0;
+	this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+	this->memoryBudget = DEFAULT_MEMORY_BUDGET;
+	this->sessionRate = 0;
+	this->globalRate = 0;
+	this->burstBytes = 0;
+	this->adaptiveRate = false;
+	this->connectTimeoutMs = CONNECT_TIMEOUT_MS;
+	this->ioTimeoutMs = IO_TIMEOUT_MS;
+	this->maxReconnects = DEFAULT_MAX_RECONNECTS;
+	this->reconnectBackoffMs = DEFAULT_RECONNECT_BACKOFF_MS;
+	this->logLevel = LogLevel::Info;
+	this->logFormat = LogFormat::Text;
+	this->lazyInit = false;
+}
+
+/// <summary>
+/// Parses command line arguments into options
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <param name="options"></param>
+/// <returns>true if all the arguments are valid, false otherwise</returns>
+bool ClientOptions::parse(int argc, char* argv[], ClientOptions& options) {
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+
+		// every option is followed by its value
+		if (i + 1 >= argc) {
+			std::cout << "Missing value of option " << arg << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+
+		if (arg == "--window") {
+			if (!parsePositive(value, options.windowSize))
+				return false;
+		}
+		else if (arg == "--compress") {
+			if (!parseCodec(value, options.compressionCodec))
+				return false;
+		}
+		else if (arg == "--threads") {
+			if (!parsePositive(value, options.threadCount))
+				return false;
+		}
+		else if (arg == "--memory") {
+			size_t megabytes = 0;
+			if (!parsePositive(value, megabytes))
+				return false;
+			options.memoryBudget = megabytes * 1024 * 1024;
+		}
+		else if (arg == "--rate" || arg == "--global-rate" || arg == "--burst") {
+			size_t kilobytes = 0;
+			if (!parsePositive(value, kilobytes))
+				return false;
+			size_t& target = arg == "--rate" ? options.sessionRate
+				: arg == "--global-rate" ? options.globalRate : options.burstBytes;
+			target = kilobytes * 1024;
+		}
+		else if (arg == "--rate-mode") {
+			if (!parseRateMode(value, options.adaptiveRate))
+				return false;
+		}
+		else if (arg == "--connect-timeout") {
+			if (!parsePositive(value, options.connectTimeoutMs))
+				return false;
+		}
+		else if (arg == "--io-timeout") {
+			if (!parsePositive(value, options.ioTimeoutMs))
+				return false;
+		}
+		else if (arg == "--reconnects") {
+			if (!parseCount(value, options.maxReconnects))
+				return false;
+		}
+		else if (arg == "--backoff") {
+			if (!parsePositive(value, options.reconnectBackoffMs))
+				return false;
+		}
+		else if (arg == "--latency-report") {
+			options.latencyReportPath = value;
+		}
+		else if (arg == "--trace") {
+			options.tracePath = value;
+		}
+		else if (arg == "--metrics") {
+			options.metricsPath = value;
+		}
+		else if (arg == "--startup-profile") {
+			options.startupProfilePath = value;
+		}
+		else if (arg == "--init") {
+			if (!parseInitMode(value, options.lazyInit))
+				return false;
+		}
+		else if (arg == "--log-level") {
+			if (!parseLogLevel(value, options.logLevel))
+				return false;
+		}
+		else if (arg == "--log-format") {
+			if (!parseLogFormat(value, options.logFormat))
+				return false;
+		}
+		else if (arg == "--watch") {
+			if (!parsePositive(value, options.watchDebounceMs))
+				return false;
+		}
+		else {
+			std::cout << "Unknown option " << arg << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Prints usage of command line arguments
+/// </summary>
+void ClientOptions::printUsage() {
+	std::cout << "Usage: client [options]" << std::endl;
+	std::cout << "  --window <count>\tnumber of files in flight before waiting for a response (default "
+		<< DEFAULT_WINDOW_SIZE << ")" << std::endl;
+	std::cout << "  --compress <codec>\tcompression of file content before encryption: none, zlib (default none)"
+		<< std::endl;
+	std::cout << "  --threads <count>\tnumber of threads which read, compress, encrypt and cksum files (default number "
+		"of cores)" << std::endl;
+	std::cout << "  --memory <MB>\t\tmemory for file content being prepared or waiting to be sent (default "
+		<< DEFAULT_MEMORY_BUDGET / (1024 * 1024) << ")" << std::endl;
+	std::cout << "  --rate <KB/s>\t\tlimit of bytes sent on the connection (default unlimited)" << std::endl;
+	std::cout << "  --global-rate <KB/s>\tlimit of bytes sent on all the connections of the process together (default "
+		"unlimited)" << std::endl;
+	std::cout << "  --burst <KB>\t\tbytes that may be sent at once after an idle period (default a tenth of a second "
+		"of the rate)" << std::endl;
+	std::cout << "  --rate-mode <mode>\tfixed, or adaptive to back off while the round trip time grows (default fixed)"
+		<< std::endl;
+	std::cout << "  --connect-timeout <ms>\tdeadline of resolving the server and connecting to it (default "
+		<< CONNECT_TIMEOUT_MS << ")" << std::endl;
+	std::cout << "  --io-timeout <ms>\ttime a read or write on the connection may go without moving a byte (default " << IO_TIMEOUT_MS
+		<< ")" << std::endl;
+	std::cout << "  --reconnects <count>\tattempts to connect again after the connection broke, 0 to give up right "
+		"away (default " << DEFAULT_MAX_RECONNECTS << ")" << std::endl;
+	std::cout << "  --backoff <ms>\t\tdelay before the first attempt to connect again, doubled for every next attempt "
+		"(default " << DEFAULT_RECONNECT_BACKOFF_MS << ")" << std::endl;
+	std::cout << "  --latency-report <path>\ttime the read, compress, encrypt, cksum, send and server wait of files, and "
+		"write their latency histograms to <path> (- for the console) at exit and on SIGUSR1" << std::endl;
+	std::cout << "  --trace <path>\t\trecord the steps of the session and write them to <path> as a Chrome trace, "
+		"to open in Perfetto" << std::endl;
+	std::cout << "  --metrics <path>\twrite counters and gauges of the uploads to <path> in the Prometheus text format, "
+		"after every batch and at exit" << std::endl;
+	std::cout << "  --startup-profile <path>\ttime the steps from the start of the process to its first byte on the wire, "
+		"and write them to <path> (- for the console) at exit" << std::endl;
+	std::cout << "  --init <mode>\t\teager connects and exchanges keys at start, lazy only once there are files to send, "
+		"generating the keys while connecting (default eager)" << std::endl;
+	std::cout << "  --log-level <level>\tdebug, info, warning, error or off - debug adds a record per step of every file "
+		"(default info)" << std::endl;
+	std::cout << "  --log-format <format>\ttext (message and key=value fields) or json (an object per line) (default text)"
+		<< std::endl;
+	std::cout << "  --watch <ms>\t\tkeep running, and upload files written in the directories of transfer.info once "
+		"they are not written for <ms> milliseconds" << std::endl;
+}
+
+/// <summary>
+/// Parses a positive number argument
+/// </summary>
+/// <param name="str"></param>
+/// <param name="result"></param>
+/// <returns>true if the argument is a positive number, false otherwise</returns>
+bool ClientOptions::parsePositive(const std::string& str, size_t& result) {
+
+	try {
+		if (str.empty() || !std::isdigit((unsigned char)str[0])) {
+			std::cout << "Invalid value: " << str << std::endl;
+			return false;
+		}
+
+		size_t position = 0;
+		unsigned long long value = std::stoull(str, &position);
+
+		if (position != str.length() || value == 0) {
+			std::cout << "Invalid value: " << str << std::endl;
+			return false;
+		}
+
+		result = (size_t)value;
+		return true;
+	}
+
+	catch (std::exception&)
+	{
+		std::cout << "Invalid value: " << str << std::endl;
+		return false;
+	}
+}
+
+/// <summary>
+/// Parses a count argument, which may be 0
+/// </summary>
+/// <param name="str"></param>
+/// <param name="result"></param>
+/// <returns>true if the argument is a number, false otherwise</returns>
+bool ClientOptions::parseCount(const std::string& str, size_t& result) {
+
+	if (str == "0") {
+		result = 0;
+		return true;
+	}
+
+	return parsePositive(str, result);
+}
+
+/// <summary>
+/// Parses a compression codec argument
+/// </summary>
+/// <param name="str"></param>
+/// <param name="result"></param>
+/// <returns>true if the argument names a known codec, false otherwise</returns>
+bool ClientOptions::parseCodec(const std::string& str, uint8_t& result) {
+
+	if (str == CompressionWrapper::getCodecName(CODEC_NONE))
+		result = CODEC_NONE;
+	else if (str == CompressionWrapper::getCodecName(CODEC_ZLIB))
+		result = CODEC_ZLIB;
+	else {
+		std::cout << "Invalid codec: " << str << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Parses a rate mode argument
+/// </summary>
+/// <param name="str"></param>
+/// <param name="adaptive"></param>
+/// <returns>true if the argument is fixed or adaptive, false otherwise</returns>
+bool ClientOptions::parseRateMode(const std::string& str, bool& adaptive) {
+
+	if (str == "fixed")
+		adaptive = false;
+	else if (str == "adaptive")
+		adaptive = true;
+	else {
+		std::cout << "Invalid rate mode: " << str << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Parses a log level argument
+/// </summary>
+/// <param name="str"></param>
+/// <param name="result"></param>
+/// <returns>true if the argument names a level, false otherwise</returns>
+bool ClientOptions::parseLogLevel(const std::string& str, LogLevel& result) {
+
+	for (LogLevel level : { LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error, LogLevel::Off }) {
+		if (str == Logger::getLevelName(level)) {
+			result = level;
+			return true;
+		}
+	}
+
+	std::cout << "Invalid log level: " << str << std::endl;
+	return false;
+}
+
+/// <summary>
+/// Parses a log format argument
+/// </summary>
+/// <param name="str"></param>
+/// <param name="result"></param>
+/// <returns>true if the argument names a format, false otherwise</returns>
+bool ClientOptions::parseLogFormat(const std::string& str, LogFormat& result) {
+
+	if (str == Logger::getFormatName(LogFormat::Text))
+		result = LogFormat::Text;
+	else if (str == Logger::getFormatName(LogFormat::Json))
+		result = LogFormat::Json;
+	else {
+		std::cout << "Invalid log format: " << str << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Parses an init mode argument
+/// </summary>
+/// <param name="str"></param>
+/// <param name="lazy"></param>
+/// <returns>true if the argument is eager or lazy, false otherwise</returns>
+bool ClientOptions::parseInitMode(const std::string& str, bool& lazy) {
+
+	if (str == "eager")
+		lazy = false;
+	else if (str == "lazy")
+		lazy = true;
+	else {
+		std::cout << "Invalid init mode: " << str << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdlib>
+#include <iostream>
+#include <cctype>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include "CompressionWrapper.h"
+#include "UploadScheduler.h"
+#include "SocketHandler.h"
+#include "Logger.h"
+
+const size_t DEFAULT_WINDOW_SIZE = 4;
+const size_t DEFAULT_MAX_RECONNECTS = 5;
+const size_t DEFAULT_RECONNECT_BACKOFF_MS = 500;
+
+class ClientOptions {
+
+public:
+	// members
+	size_t windowSize;
+	uint8_t compressionCodec;
+	size_t watchDebounceMs;
+	size_t threadCount;
+	size_t memoryBudget;
+	size_t sessionRate;
+	size_t globalRate;
+	size_t burstBytes;
+	bool adaptiveRate;
+	size_t connectTimeoutMs;
+	size_t ioTimeoutMs;
+	size_t maxReconnects;
+	size_t reconnectBackoffMs;
+	std::string latencyReportPath;
+	std::string tracePath;
+	std::string metricsPath;
+	std::string startupProfilePath;
+	bool lazyInit;
+	LogLevel logLevel;
+	LogFormat logFormat;
+
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	ClientOptions();
+
+	/// <summary>
+	/// Parses command line arguments into options
+	/// </summary>
+	/// <param name="argc"></param>
+	/// <param name="argv"></param>
+	/// <param name="options"></param>
+	/// <returns>true if all the arguments are valid, false otherwise</returns>
+	static bool parse(int argc, char* argv[], ClientOptions& options);
+
+	/// <summary>
+	/// Prints usage of command line arguments
+	/// </summary>
+	static void printUsage();
+
+private:
+
+	/// <summary>
+	/// Parses a positive number argument
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="result"></param>
+	/// <returns>true if the argument is a positive number, false otherwise</returns>
+	static bool parsePositive(const std::string& str, size_t& result);
+
+	/// <summary>
+	/// Parses a count argument, which may be 0
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="result"></param>
+	/// <returns>true if the argument is a number, false otherwise</returns>
+	static bool parseCount(const std::string& str, size_t& result);
+
+	/// <summary>
+	/// Parses a compression codec argument
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="result"></param>
+	/// <returns>true if the argument names a known codec, false otherwise</returns>
+	static bool parseCodec(const std::string& str, uint8_t& result);
+
+	/// <summary>
+	/// Parses a rate mode argument
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="adaptive"></param>
+	/// <returns>true if the argument is fixed or adaptive, false otherwise</returns>
+	static bool parseRateMode(const std::string& str, bool& adaptive);
+
+	/// <summary>
+	/// Parses a log level argument
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="result"></param>
+	/// <returns>true if the argument names a level, false otherwise</returns>
+	static bool parseLogLevel(const std::string& str, LogLevel& result);
+
+	/// <summary>
+	/// Parses a log format argument
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="result"></param>
+	/// <returns>true if the argument names a format, false otherwise</returns>
+	static bool parseLogFormat(const std::string& str, LogFormat& result);
+
+	/// <summary>
+	/// Parses an init mode argument
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="lazy"></param>
+	/// <returns>true if the argument is eager or lazy, false otherwise</returns>
+	static bool parseInitMode(const std::string& str, bool& lazy);
+};
@@ -0,0 +1,52 @@
+#include "CompressionWrapper.h"
+#include <algorithm>
+#include <stdexcept>
+
+
+std::string CompressionWrapper::compress(const char* content, size_t length, uint8_t codec)
+{
+	if (codec != CODEC_ZLIB)
+		return std::string(content, length);
+
+	std::string compressed;
+	CryptoPP::ZlibCompressor compressor(new CryptoPP::StringSink(compressed));
+
+	// feeding the compressor chunk by chunk, it streams its output to the sink as it goes
+	for (size_t offset = 0; offset < length; offset += COMPRESSION_CHUNK_SIZE) {
+		size_t chunkSize = std::min(COMPRESSION_CHUNK_SIZE, length - offset);
+		compressor.Put((const CryptoPP::byte*)content + offset, chunkSize);
+	}
+	compressor.MessageEnd();
+
+	return compressed;
+}
+
+std::string CompressionWrapper::decompress(const char* content, size_t length, uint8_t codec)
+{
+	if (codec == CODEC_NONE)
+		return std::string(content, length);
+	if (codec != CODEC_ZLIB)
+		throw std::invalid_argument("unknown codec " + std::to_string(codec));
+
+	std::string decompressed;
+	CryptoPP::ZlibDecompressor decompressor(new CryptoPP::StringSink(decompressed));
+	for (size_t offset = 0; offset < length; offset += COMPRESSION_CHUNK_SIZE) {
+		size_t chunkSize = std::min(COMPRESSION_CHUNK_SIZE, length - offset);
+		decompressor.Put((const CryptoPP::byte*)content + offset, chunkSize);
+	}
+	decompressor.MessageEnd();
+
+	return decompressed;
+}
+
+std::string CompressionWrapper::getCodecName(uint8_t codec)
+{
+	switch (codec) {
+	case CODEC_NONE:
+		return "none";
+	case CODEC_ZLIB:
+		return "zlib";
+	default:
+		return "unknown";
+	}
+}
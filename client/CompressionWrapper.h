@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <zlib.h>
+
+const uint8_t CODEC_NONE = 0;
+const uint8_t CODEC_ZLIB = 1;
+const size_t COMPRESSION_CHUNK_SIZE = 64 * 1024;
+
+
+class CompressionWrapper
+{
+public:
+	static std::string compress(const char* content, size_t length, uint8_t codec);
+	static std::string decompress(const char* content, size_t length, uint8_t codec);
+	static std::string getCodecName(uint8_t codec);
+};
@@ -0,0 +1,156 @@
+#include "DeltaEncoder.h"
+
+/// <summary>
+/// Parses block size and block signatures of the copy of a file saved in server
+/// </summary>
+/// <param name="payload"></param>
+/// <param name="blockSize"></param>
+/// <param name="signatures"></param>
+/// <returns>false if the payload is malformed</returns>
+bool DeltaEncoder::parseSignatures(std::string_view payload, size_t& blockSize, std::vector<BlockSignature>& signatures) {
+
+	// block size and number of blocks in variable length encoding, then weak checksum and strong hash of each block
+	size_t offset = 0;
+	uint64_t size = 0;
+	uint64_t count = 0;
+	if (!Varint::read(payload, offset, size) || !Varint::read(payload, offset, count) || size == 0)
+		return false;
+
+	const size_t signatureLength = sizeof(uint32_t) + STRONG_HASH_LENGTH;
+	if ((payload.size() - offset) / signatureLength < count)
+		return false;
+
+	blockSize = (size_t)size;
+	signatures.clear();
+	signatures.reserve((size_t)count);
+
+	for (uint64_t i = 0; i < count; i++) {
+		BlockSignature signature;
+		memcpy(&signature.weak, payload.data() + offset, sizeof(uint32_t));
+		signature.strong.assign(payload.substr(offset + sizeof(uint32_t), STRONG_HASH_LENGTH));
+		signatures.push_back(std::move(signature));
+		offset += signatureLength;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Encodes content as instructions to rebuild it from the copy saved in server -
+/// copies of blocks the server already has and literal bytes it doesn't
+/// </summary>
+/// <param name="content"></param>
+/// <param name="contentSize"></param>
+/// <param name="blockSize"></param>
+/// <param name="signatures"></param>
+/// <param name="literalBytes">number of bytes that are sent as they are</param>
+/// <returns>block size followed by the instructions</returns>
+std::string DeltaEncoder::encode(const char* content, size_t contentSize, size_t blockSize,
+	const std::vector<BlockSignature>& signatures, size_t& literalBytes) {
+
+	std::string delta;
+	Varint::append(delta, blockSize);
+	literalBytes = 0;
+
+	// blocks of the copy in server by their weak checksum
+	std::unordered_map<uint32_t, std::vector<size_t>> blocksByWeak;
+	for (size_t i = 0; i < signatures.size(); i++)
+		blocksByWeak[signatures[i].weak].push_back(i);
+
+	const unsigned char* data = (const unsigned char*)content;
+	size_t position = 0;
+	size_t literalStart = 0;
+
+	// a run of consecutive blocks is sent as a single copy
+	size_t copyStart = 0;
+	size_t copyCount = 0;
+
+	RollingChecksum rolling;
+	if (contentSize >= blockSize)
+		rolling.reset(data, blockSize);
+
+	while (position + blockSize <= contentSize) {
+
+		// the strong hash is calculated only for windows whose weak checksum matches a block
+		size_t matchedBlock = signatures.size();
+		auto candidates = blocksByWeak.find(rolling.digest());
+		if (candidates != blocksByWeak.end()) {
+			std::string strong = HashWrapper::strongHash(content + position, blockSize);
+			for (size_t block : candidates->second) {
+				if (signatures[block].strong == strong) {
+					matchedBlock = block;
+					break;
+				}
+			}
+		}
+
+		if (matchedBlock == signatures.size()) {
+			// no match - sliding the window by one byte, the byte that left it will be sent as a literal
+			if (position + blockSize < contentSize)
+				rolling.roll(data[position], data[position + blockSize]);
+			position++;
+			continue;
+		}
+
+		// sending the bytes before the matched block as they are
+		if (position > literalStart) {
+			if (copyCount > 0) {
+				appendCopy(delta, copyStart, copyCount);
+				copyCount = 0;
+			}
+			appendLiteral(delta, content + literalStart, position - literalStart);
+			literalBytes += position - literalStart;
+		}
+
+		// extending the current run of blocks or starting a new one
+		if (copyCount > 0 && copyStart + copyCount == matchedBlock)
+			copyCount++;
+		else {
+			if (copyCount > 0)
+				appendCopy(delta, copyStart, copyCount);
+			copyStart = matchedBlock;
+			copyCount = 1;
+		}
+
+		// jumping over the matched block
+		position += blockSize;
+		literalStart = position;
+		if (position + blockSize <= contentSize)
+			rolling.reset(data + position, blockSize);
+	}
+
+	if (copyCount > 0)
+		appendCopy(delta, copyStart, copyCount);
+
+	// the rest of the content, shorter than a block or without a match, is sent as it is
+	if (contentSize > literalStart) {
+		appendLiteral(delta, content + literalStart, contentSize - literalStart);
+		literalBytes += contentSize - literalStart;
+	}
+
+	return delta;
+}
+
+/// <summary>
+/// Appends literal bytes instruction
+/// </summary>
+/// <param name="delta"></param>
+/// <param name="content"></param>
+/// <param name="length"></param>
+void DeltaEncoder::appendLiteral(std::string& delta, const char* content, size_t length) {
+	delta.push_back((char)DELTA_OP_LITERAL);
+	Varint::append(delta, length);
+	delta.append(content, length);
+}
+
+/// <summary>
+/// Appends copy of consecutive blocks instruction
+/// </summary>
+/// <param name="delta"></param>
+/// <param name="firstBlock"></param>
+/// <param name="blockCount"></param>
+void DeltaEncoder::appendCopy(std::string& delta, size_t firstBlock, size_t blockCount) {
+	delta.push_back((char)DELTA_OP_COPY);
+	Varint::append(delta, firstBlock);
+	Varint::append(delta, blockCount);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "RollingChecksum.h"
+#include "HashWrapper.h"
+#include "Varint.h"
+
+const uint8_t DELTA_OP_COPY = 0;
+const uint8_t DELTA_OP_LITERAL = 1;
+
+/// <summary>
+/// Signature of a block of the copy of a file saved in server
+/// </summary>
+struct BlockSignature {
+	uint32_t weak;
+	std::string strong;
+};
+
+class DeltaEncoder {
+
+public:
+	/// <summary>
+	/// Parses block size and block signatures of the copy of a file saved in server
+	/// </summary>
+	/// <param name="payload"></param>
+	/// <param name="blockSize"></param>
+	/// <param name="signatures"></param>
+	/// <returns>false if the payload is malformed</returns>
+	static bool parseSignatures(std::string_view payload, size_t& blockSize, std::vector<BlockSignature>& signatures);
+
+	/// <summary>
+	/// Encodes content as instructions to rebuild it from the copy saved in server -
+	/// copies of blocks the server already has and literal bytes it doesn't
+	/// </summary>
+	/// <param name="content"></param>
+	/// <param name="contentSize"></param>
+	/// <param name="blockSize"></param>
+	/// <param name="signatures"></param>
+	/// <param name="literalBytes">number of bytes that are sent as they are</param>
+	/// <returns>block size followed by the instructions</returns>
+	static std::string encode(const char* content, size_t contentSize, size_t blockSize,
+		const std::vector<BlockSignature>& signatures, size_t& literalBytes);
+
+private:
+	/// <summary>
+	/// Appends literal bytes instruction
+	/// </summary>
+	/// <param name="delta"></param>
+	/// <param name="content"></param>
+	/// <param name="length"></param>
+	static void appendLiteral(std::string& delta, const char* content, size_t length);
+
+	/// <summary>
+	/// Appends copy of consecutive blocks instruction
+	/// </summary>
+	/// <param name="delta"></param>
+	/// <param name="firstBlock"></param>
+	/// <param name="blockCount"></param>
+	static void appendCopy(std::string& delta, size_t firstBlock, size_t blockCount);
+};
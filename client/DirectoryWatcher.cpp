@@ -0,0 +1,232 @@
+#include "DirectoryWatcher.h"
+
+/// <summary>
+/// Ctor
+/// </summary>
+DirectoryWatcher::DirectoryWatcher() {
+#ifdef __linux__
+	this->inotifyFd = inotify_init1(IN_CLOEXEC);
+#endif
+}
+
+/// <summary>
+/// Dtor
+/// </summary>
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __linux__
+	if (this->inotifyFd >= 0)
+		close(this->inotifyFd);
+#endif
+}
+
+/// <summary>
+/// Starts watching a directory and its sub-directories
+/// </summary>
+/// <param name="directoryPath"></param>
+/// <returns></returns>
+bool DirectoryWatcher::addDirectory(const std::string& directoryPath) {
+
+	try {
+		if (!std::filesystem::is_directory(directoryPath))
+			return false;
+
+		if (!this->watchDirectory(directoryPath))
+			return false;
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directoryPath)) {
+			if (entry.is_directory() && !this->watchDirectory(entry.path().string()))
+				return false;
+		}
+
+		return true;
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		return false;
+	}
+}
+
+/// <summary>
+/// Starts watching a single directory
+/// </summary>
+/// <param name="directoryPath"></param>
+/// <returns></returns>
+bool DirectoryWatcher::watchDirectory(const std::string& directoryPath) {
+
+	this->directories.push_back(directoryPath);
+
+#ifdef __linux__
+	// a file is queued when it is written or moved into the directory, a new directory is watched as well
+	int watch = inotify_add_watch(this->inotifyFd, directoryPath.c_str(),
+		IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (watch < 0) {
+		Logger::error("Failed watching directory", { { "directory", directoryPath } });
+		return false;
+	}
+
+	this->watchedPaths[watch] = directoryPath;
+#else
+	// the files which already exist are the baseline of the next scan
+	for (const auto& entry : std::filesystem::directory_iterator(directoryPath)) {
+		if (entry.is_regular_file())
+			this->snapshot[entry.path().string()] = { entry.last_write_time(), entry.file_size() };
+	}
+#endif
+
+	return true;
+}
+
+/// <summary>
+/// Waits until files are written, and then until no file was written for the debounce interval
+/// </summary>
+/// <param name="debounceMs">quiet interval after the last write</param>
+/// <param name="changedFiles">paths of the files written since the last call, sorted</param>
+/// <returns>false if watching failed</returns>
+bool DirectoryWatcher::waitForChanges(size_t debounceMs, std::vector<std::string>& changedFiles) {
+
+	try {
+		changedFiles.clear();
+
+#ifdef __linux__
+		if (this->inotifyFd < 0)
+			return false;
+
+		pollfd pollFd = { this->inotifyFd, POLLIN, 0 };
+
+		// blocking until the first write, then until the files are quiet for the debounce interval
+		while (this->pendingFiles.empty()) {
+			if (poll(&pollFd, 1, -1) < 0)
+				return false;
+			this->readEvents();
+		}
+
+		while (true) {
+			int ready = poll(&pollFd, 1, (int)debounceMs);
+			if (ready < 0)
+				return false;
+			if (ready == 0)
+				break;
+			this->readEvents();
+		}
+#else
+		// scanning until the first write, then until a scan finds nothing new for the debounce interval
+		auto lastChange = std::chrono::steady_clock::now();
+		while (this->pendingFiles.empty()
+			|| std::chrono::steady_clock::now() - lastChange < std::chrono::milliseconds(debounceMs)) {
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+			if (this->scanDirectories())
+				lastChange = std::chrono::steady_clock::now();
+		}
+#endif
+
+		// a queued file that was deleted before it got quiet is not reported
+		for (const std::string& filePath : this->pendingFiles) {
+			if (std::filesystem::is_regular_file(filePath))
+				changedFiles.push_back(filePath);
+		}
+		this->pendingFiles.clear();
+
+		return true;
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		return false;
+	}
+}
+
+#ifdef __linux__
+/// <summary>
+/// Reads the pending inotify events and queues the files they refer to
+/// </summary>
+/// <returns>true if any file was queued</returns>
+bool DirectoryWatcher::readEvents() {
+
+	alignas(inotify_event) char buffer[64 * 1024];
+	ssize_t length = read(this->inotifyFd, buffer, sizeof(buffer));
+	if (length <= 0)
+		return false;
+
+	bool queued = false;
+	for (char* position = buffer; position < buffer + length;) {
+		inotify_event* event = (inotify_event*)position;
+		position += sizeof(inotify_event) + event->len;
+
+		auto watched = this->watchedPaths.find(event->wd);
+		if (event->len == 0 || watched == this->watchedPaths.end())
+			continue;
+
+		std::string path = (std::filesystem::path(watched->second) / event->name).string();
+
+		// a new directory is watched, and the files written into it before the watch started are queued
+		if (event->mask & IN_ISDIR) {
+			if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+				this->addDirectory(path);
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+					if (entry.is_regular_file())
+						this->pendingFiles.insert(entry.path().string());
+				}
+				queued = true;
+			}
+			continue;
+		}
+
+		this->pendingFiles.insert(path);
+		queued = true;
+	}
+
+	return queued;
+}
+#else
+/// <summary>
+/// Scans the watched directories and queues the files that were created or modified since the last scan
+/// </summary>
+/// <returns>true if any file was queued</returns>
+bool DirectoryWatcher::scanDirectories() {
+
+	bool queued = false;
+
+	for (const std::string& directoryPath : std::vector<std::string>(this->directories)) {
+		if (!std::filesystem::is_directory(directoryPath))
+			continue;
+
+		for (const auto& entry : std::filesystem::directory_iterator(directoryPath)) {
+			std::string path = entry.path().string();
+
+			// a new sub-directory is watched from now on, all of its files are new
+			if (entry.is_directory()) {
+				if (std::find(this->directories.begin(), this->directories.end(), path) == this->directories.end()) {
+					this->directories.push_back(path);
+					for (const auto& file : std::filesystem::recursive_directory_iterator(path)) {
+						if (file.is_directory())
+							this->directories.push_back(file.path().string());
+						else if (file.is_regular_file()) {
+							this->snapshot[file.path().string()] = { file.last_write_time(), file.file_size() };
+							this->pendingFiles.insert(file.path().string());
+							queued = true;
+						}
+					}
+				}
+				continue;
+			}
+
+			if (!entry.is_regular_file())
+				continue;
+
+			std::pair<std::filesystem::file_time_type, uintmax_t> state = { entry.last_write_time(), entry.file_size() };
+			auto known = this->snapshot.find(path);
+			if (known == this->snapshot.end() || known->second != state) {
+				this->snapshot[path] = state;
+				this->pendingFiles.insert(path);
+				queued = true;
+			}
+		}
+	}
+
+	return queued;
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdlib>
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include "Logger.h"
+#include <map>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+const size_t POLL_INTERVAL_MS = 500;
+
+class DirectoryWatcher {
+
+private:
+	// members
+	std::vector<std::string> directories;
+	std::set<std::string> pendingFiles;
+
+#ifdef __linux__
+	int inotifyFd;
+	std::map<int, std::string> watchedPaths;
+
+	/// <summary>
+	/// Reads the pending inotify events and queues the files they refer to
+	/// </summary>
+	/// <returns>true if any file was queued</returns>
+	bool readEvents();
+#else
+	std::map<std::string, std::pair<std::filesystem::file_time_type, uintmax_t>> snapshot;
+
+	/// <summary>
+	/// Scans the watched directories and queues the files that were created or modified since the last scan
+	/// </summary>
+	/// <returns>true if any file was queued</returns>
+	bool scanDirectories();
+#endif
+
+	/// <summary>
+	/// Starts watching a single directory
+	/// </summary>
+	/// <param name="directoryPath"></param>
+	/// <returns></returns>
+	bool watchDirectory(const std::string& directoryPath);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	DirectoryWatcher();
+
+	/// <summary>
+	/// Dtor
+	/// </summary>
+	~DirectoryWatcher();
+
+	/// <summary>
+	/// Starts watching a directory and its sub-directories
+	/// </summary>
+	/// <param name="directoryPath"></param>
+	/// <returns></returns>
+	bool addDirectory(const std::string& directoryPath);
+
+	/// <summary>
+	/// Waits until files are written, and then until no file was written for the debounce interval
+	/// </summary>
+	/// <param name="debounceMs">quiet interval after the last write</param>
+	/// <param name="changedFiles">paths of the files written since the last call, sorted</param>
+	/// <returns>false if watching failed</returns>
+	bool waitForChanges(size_t debounceMs, std::vector<std::string>& changedFiles);
+};
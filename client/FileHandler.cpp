@@ -1,5 +1,11 @@
 #include "FileHandler.h"
 
+/// <summary>
+/// Ctor
+/// </summary>
+FileHandler::FileHandler() : opens(0) {
+}
+
 /// <summary>
 /// Reads a specified line from file
 /// </summary>
@@ -18,6 +24,8 @@ bool FileHandler::readLine(std::string filePath, size_t lineNumber, std::string&
 		// opening the file
 		if (!file.is_open())
 			file.open(filePath);
+		if (file.is_open())
+			this->opens++;
 
 		// looping over lines in the file
 		while (!file.eof())
@@ -38,8 +46,7 @@ bool FileHandler::readLine(std::string filePath, size_t lineNumber, std::string&
 
 		// if desired line is less than total number of lines of the file:
 		if (lineCount < lineNumber) {
-			std::cout << "Line not found." << std::endl;
-			std::cout << "File Contains " << lineCount << " lines" << std::endl;
+			Logger::error("Line not found", { { "path", filePath }, { "line", lineNumber }, { "lines", lineCount } });
 			isSuccessful = false;
 		}
 
@@ -49,7 +56,7 @@ bool FileHandler::readLine(std::string filePath, size_t lineNumber, std::string&
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;;
 	}
 
@@ -60,6 +67,94 @@ bool FileHandler::readLine(std::string filePath, size_t lineNumber, std::string&
 	return isSuccessful;
 }
 
+/// <summary>
+/// Reads all lines of a file starting from a specified line number
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="fromLine"></param>
+/// <param name="destination"></param>
+/// <returns></returns>
+bool FileHandler::readLines(std::string filePath, size_t fromLine, std::vector<std::string>& destination) {
+
+	bool isSuccessful = false;
+
+	std::ifstream file;
+	size_t lineCount = 1;
+
+	try {
+
+		if (!std::filesystem::exists(filePath))
+			return false;
+
+		file.open(filePath);
+		if (file.is_open())
+			this->opens++;
+
+		// reading the file line by line and keeping only the lines from the desired line onwards
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (lineCount >= fromLine)
+				destination.push_back(line);
+
+			lineCount++;
+		}
+
+		isSuccessful = true;
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		isSuccessful = false;
+	}
+
+	// closing the file if open
+	if (file.is_open())
+		file.close();
+
+	return isSuccessful;
+}
+
+/// <summary>
+/// Lists all regular files inside a directory and its sub-directories
+/// </summary>
+/// <param name="directoryPath"></param>
+/// <param name="destination"></param>
+/// <returns></returns>
+bool FileHandler::listFiles(std::string directoryPath, std::vector<std::string>& destination) {
+
+	bool isSuccessful = false;
+
+	try {
+
+		if (!std::filesystem::is_directory(directoryPath))
+			return false;
+
+		std::vector<std::string> files;
+
+		// walking the directory tree and collecting the paths of regular files only
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directoryPath)) {
+			if (entry.is_regular_file())
+				files.push_back(entry.path().string());
+		}
+
+		// sorting the paths so a directory is always uploaded in the same order
+		std::sort(files.begin(), files.end());
+		destination.insert(destination.end(), files.begin(), files.end());
+
+		isSuccessful = true;
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		isSuccessful = false;
+	}
+
+	return isSuccessful;
+}
+
 /// <summary>
 /// Reads all file to a buffer
 /// </summary>
@@ -82,23 +177,26 @@ bool FileHandler::readFile(std::string filePath, char** destination) {
 		}
 
 		// finding the size of the file
-		uint32_t fileSize = (uint32_t)std::filesystem::file_size(filePath);
+		uint64_t fileSize = std::filesystem::file_size(filePath);
 
 		// creating the new stream buffer with the relevant size
-		*destination = new char[fileSize];
+		*destination = new char[(size_t)fileSize];
 
 		// opening the file according to its path
 		file.open(filePath, std::fstream::binary);
+		if (file.is_open())
+			this->opens++;
 
 		// reading the file into the destination buffer, according to the size of the file
 		file.read(*destination, fileSize);
+		this->readCounter.record(fileSize, (size_t)file.gcount());
 
 		isSuccesful = true;
 	}
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 
 		if (destination != nullptr)
 			delete[] destination;
@@ -113,6 +211,49 @@ bool FileHandler::readFile(std::string filePath, char** destination) {
 	return isSuccesful;
 }
 
+/// <summary>
+/// Reads a part of a file to a string
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="offset"></param>
+/// <param name="length"></param>
+/// <param name="destination"></param>
+/// <returns>false if the file couldn't be read or is shorter than the part</returns>
+bool FileHandler::readChunk(std::string filePath, uint64_t offset, size_t length, std::string& destination) {
+
+	bool isSuccessful = false;
+
+	std::ifstream file;
+
+	try {
+
+		file.open(filePath, std::fstream::binary);
+		if (!file.is_open())
+			return false;
+		this->opens++;
+
+		// reading only the part of the file, so a large file is never held in memory as a whole
+		destination.resize(length);
+		file.seekg((std::streamoff)offset);
+		file.read(&destination[0], length);
+		this->readCounter.record(length, (size_t)file.gcount());
+
+		isSuccessful = (size_t)file.gcount() == length;
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		isSuccessful = false;
+	}
+
+	// closing the stream file if open
+	if (file.is_open())
+		file.close();
+
+	return isSuccessful;
+}
+
 /// <summary>
 /// Writes lines 
 /// </summary>
@@ -131,6 +272,8 @@ bool FileHandler::writeLines(std::string filePath, std::string source) {
 			// opening the file and starting writing from the end of file 
 			// (appending and not deleting previous content)
 			file.open(filePath, std::ios_base::app);
+		if (file.is_open())
+			this->opens++;
 
 		// writing the source to the end of the file
 		file << source << std::endl;
@@ -139,7 +282,7 @@ bool FileHandler::writeLines(std::string filePath, std::string source) {
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -174,6 +317,8 @@ bool FileHandler::writeLines(std::string filePath, size_t lineNumber, std::strin
 
 		// opening file for reading
 		readFile.open(filePath);
+		if (readFile.is_open())
+			this->opens++;
 
 		// reading lines and pushing into vector
 		while (std::getline(readFile, line))
@@ -190,6 +335,8 @@ bool FileHandler::writeLines(std::string filePath, size_t lineNumber, std::strin
 
 		// opening the file for writing, use ofstream::trunc to erase file and replace with vector
 		writeFile.open(filePath, std::ofstream::trunc);
+		if (writeFile.is_open())
+			this->opens++;
 
 		// iterating vector and writing to the file the lines with the new line
 		for (int i = 0; i < lines.size(); i++) {
@@ -200,7 +347,7 @@ bool FileHandler::writeLines(std::string filePath, size_t lineNumber, std::strin
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -213,4 +360,19 @@ bool FileHandler::writeLines(std::string filePath, size_t lineNumber, std::strin
 		writeFile.close();
 
 	return isSuccessful;
-}
\ No newline at end of file
+}
+/// <summary>
+/// Returns number of files opened
+/// </summary>
+/// <returns></returns>
+uint64_t FileHandler::getOpens() {
+	return this->opens.load();
+}
+
+/// <summary>
+/// Returns the counts of reads of file content into memory
+/// </summary>
+/// <returns></returns>
+const IoCounter& FileHandler::getReadCounter() {
+	return this->readCounter;
+}
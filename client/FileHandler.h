@@ -5,11 +5,26 @@
 #include <boost/asio.hpp>
 #include <fstream>
 #include <filesystem>
+#include <vector>
+#include <algorithm>
+#include "Logger.h"
+#include "IoCounter.h"
+#include <atomic>
 
 
 class FileHandler {
 
+private:
+	// members
+	std::atomic<uint64_t> opens;
+	IoCounter readCounter;
+
 public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	FileHandler();
+
 	
 	/// <summary>
 	/// Reads a specified line from file
@@ -19,6 +34,23 @@ public:
 	/// <returns></returns>
 	bool readLine(std::string filePath, size_t lineNumber, std::string& destination);
 
+	/// <summary>
+	/// Reads all lines of a file starting from a specified line number
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <param name="fromLine"></param>
+	/// <param name="destination"></param>
+	/// <returns></returns>
+	bool readLines(std::string filePath, size_t fromLine, std::vector<std::string>& destination);
+
+	/// <summary>
+	/// Lists all regular files inside a directory and its sub-directories
+	/// </summary>
+	/// <param name="directoryPath"></param>
+	/// <param name="destination"></param>
+	/// <returns></returns>
+	bool listFiles(std::string directoryPath, std::vector<std::string>& destination);
+
 
 	/// <summary>
 	/// Reads all file to a buffer
@@ -28,6 +60,16 @@ public:
 	/// <returns></returns>
 	bool readFile(std::string filePath, char** destination);
 
+	/// <summary>
+	/// Reads a part of a file to a string
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <param name="offset"></param>
+	/// <param name="length"></param>
+	/// <param name="destination"></param>
+	/// <returns>false if the file couldn't be read or is shorter than the part</returns>
+	bool readChunk(std::string filePath, uint64_t offset, size_t length, std::string& destination);
+
 	/// <summary>
 	/// Writes lines 
 	/// </summary>
@@ -45,4 +87,16 @@ public:
 	/// <param name="source"></param>
 	/// <returns></returns>
 	bool writeLines(std::string filePath, size_t lineNumber, std::string source);
+
+	/// <summary>
+	/// Returns number of files opened
+	/// </summary>
+	/// <returns></returns>
+	uint64_t getOpens();
+
+	/// <summary>
+	/// Returns the counts of reads of file content into memory
+	/// </summary>
+	/// <returns></returns>
+	const IoCounter& getReadCounter();
 };
\ No newline at end of file
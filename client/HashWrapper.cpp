@@ -0,0 +1,11 @@
+#include "HashWrapper.h"
+
+
+std::string HashWrapper::strongHash(const char* data, size_t length)
+{
+	CryptoPP::byte digest[CryptoPP::SHA256::DIGESTSIZE];
+	CryptoPP::SHA256().CalculateDigest(digest, (const CryptoPP::byte*)data, length);
+
+	// a truncated SHA-256 is strong enough to confirm a block which already matched its weak checksum
+	return std::string((const char*)digest, STRONG_HASH_LENGTH);
+}
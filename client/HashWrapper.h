@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <sha.h>
+
+const size_t STRONG_HASH_LENGTH = 16;
+
+
+class HashWrapper
+{
+public:
+	static std::string strongHash(const char* data, size_t length);
+};
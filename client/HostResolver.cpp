@@ -0,0 +1,98 @@
+#include "HostResolver.h"
+
+std::mutex HostResolver::cacheMutex;
+std::map<std::string, HostResolver::CachedEndpoints> HostResolver::cache;
+
+/// <summary>
+/// Resolves a host and port to endpoints ordered for connection racing - from the cache if they are there
+/// </summary>
+/// <param name="io_context"></param>
+/// <param name="host">host name or literal address</param>
+/// <param name="port"></param>
+/// <param name="timeout">how long to wait for the name server</param>
+/// <param name="endpoints"></param>
+/// <returns>false if the host couldn't be resolved in time</returns>
+bool HostResolver::resolve(boost::asio::io_context& io_context, const std::string& host, const std::string& port,
+	std::chrono::milliseconds timeout, std::vector<tcp::endpoint>& endpoints) {
+
+	std::string key = host + ":" + port;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto it = cache.find(key);
+		if (it != cache.end() && it->second.expiry > std::chrono::steady_clock::now()) {
+			endpoints = it->second.endpoints;
+			return true;
+		}
+	}
+
+	// resolving asynchronously, so an unresponsive name server is given up on after the timeout
+	tcp::resolver resolver(io_context);
+	boost::system::error_code result = boost::asio::error::would_block;
+	std::vector<tcp::endpoint> resolved;
+	resolver.async_resolve(host, port, [&result, &resolved](const boost::system::error_code& error,
+		tcp::resolver::results_type results) {
+		result = error;
+		for (const auto& entry : results)
+			resolved.push_back(entry.endpoint());
+	});
+
+	io_context.restart();
+	io_context.run_for(timeout);
+	if (result == boost::asio::error::would_block) {
+		resolver.cancel();
+		io_context.restart();
+		io_context.run();
+		Logger::error("Resolving host timed out", { { "host", host } });
+		return false;
+	}
+
+	if (result || resolved.empty()) {
+		Logger::error("Cannot resolve host", { { "host", host }, { "error", result.message() } });
+		return false;
+	}
+
+	endpoints = interleaveFamilies(resolved);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache[key] = { endpoints, std::chrono::steady_clock::now() + std::chrono::seconds(DNS_CACHE_TTL_SECONDS) };
+	return true;
+}
+
+/// <summary>
+/// Drops the cached endpoints of a host and port, so the next connection resolves them again
+/// </summary>
+/// <param name="host"></param>
+/// <param name="port"></param>
+void HostResolver::invalidate(const std::string& host, const std::string& port) {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.erase(host + ":" + port);
+}
+
+/// <summary>
+/// Orders endpoints for connection racing - alternating address families, starting with the family of
+/// the first endpoint the system prefers
+/// </summary>
+/// <param name="endpoints"></param>
+/// <returns></returns>
+std::vector<tcp::endpoint> HostResolver::interleaveFamilies(const std::vector<tcp::endpoint>& endpoints) {
+
+	std::vector<tcp::endpoint> preferred;
+	std::vector<tcp::endpoint> other;
+	bool preferV6 = endpoints.front().address().is_v6();
+	for (const tcp::endpoint& endpoint : endpoints) {
+		if (endpoint.address().is_v6() == preferV6)
+			preferred.push_back(endpoint);
+		else
+			other.push_back(endpoint);
+	}
+
+	std::vector<tcp::endpoint> ordered;
+	for (size_t i = 0; i < std::max(preferred.size(), other.size()); i++) {
+		if (i < preferred.size())
+			ordered.push_back(preferred[i]);
+		if (i < other.size())
+			ordered.push_back(other[i]);
+	}
+
+	return ordered;
+}
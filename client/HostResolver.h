@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <boost/asio.hpp>
+#include "Logger.h"
+
+using boost::asio::ip::tcp;
+
+const size_t DNS_CACHE_TTL_SECONDS = 300;
+
+/// <summary>
+/// Resolves host names to endpoints, caching the answers for all the connections of the process
+/// </summary>
+class HostResolver {
+
+private:
+	/// <summary>
+	/// Endpoints of a host and port, and when they stop being used
+	/// </summary>
+	struct CachedEndpoints {
+		std::vector<tcp::endpoint> endpoints;
+		std::chrono::steady_clock::time_point expiry;
+	};
+
+	// members
+	static std::mutex cacheMutex;
+	static std::map<std::string, CachedEndpoints> cache;
+
+	/// <summary>
+	/// Orders endpoints for connection racing - alternating address families, starting with the family of
+	/// the first endpoint the system prefers
+	/// </summary>
+	/// <param name="endpoints"></param>
+	/// <returns></returns>
+	static std::vector<tcp::endpoint> interleaveFamilies(const std::vector<tcp::endpoint>& endpoints);
+
+public:
+	/// <summary>
+	/// Resolves a host and port to endpoints ordered for connection racing - from the cache if they are there
+	/// </summary>
+	/// <param name="io_context"></param>
+	/// <param name="host">host name or literal address</param>
+	/// <param name="port"></param>
+	/// <param name="timeout">how long to wait for the name server</param>
+	/// <param name="endpoints"></param>
+	/// <returns>false if the host couldn't be resolved in time</returns>
+	static bool resolve(boost::asio::io_context& io_context, const std::string& host, const std::string& port,
+		std::chrono::milliseconds timeout, std::vector<tcp::endpoint>& endpoints);
+
+	/// <summary>
+	/// Drops the cached endpoints of a host and port, so the next connection resolves them again
+	/// </summary>
+	/// <param name="host"></param>
+	/// <param name="port"></param>
+	static void invalidate(const std::string& host, const std::string& port);
+};
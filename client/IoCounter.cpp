@@ -0,0 +1,114 @@
+#include "IoCounter.h"
+#include <iomanip>
+
+/// <summary>
+/// Ctor
+/// </summary>
+IoCounter::IoCounter() : calls(0), bytes(0), shortCalls(0) {
+	for (std::atomic<uint64_t>& bucket : this->buckets)
+		bucket = 0;
+}
+
+/// <summary>
+/// Returns the histogram bucket of a number of bytes
+/// </summary>
+/// <param name="size"></param>
+/// <returns></returns>
+size_t IoCounter::bucketOf(uint64_t size) {
+
+	size_t bucket = 0;
+	while (size > 0 && bucket < IO_SIZE_BUCKETS - 1) {
+		size >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/// <summary>
+/// Returns a number of bytes in the shortest unit, such as 64K
+/// </summary>
+/// <param name="size"></param>
+/// <returns></returns>
+std::string IoCounter::formatSize(uint64_t size) {
+
+	const char* units[] = { "", "K", "M", "G" };
+	size_t unit = 0;
+	while (size >= 1024 && size % 1024 == 0 && unit < 3) {
+		size /= 1024;
+		unit++;
+	}
+
+	return std::to_string(size) + units[unit];
+}
+
+/// <summary>
+/// Records a call
+/// </summary>
+/// <param name="requested">bytes the call was asked to move</param>
+/// <param name="transferred">bytes the call moved</param>
+void IoCounter::record(size_t requested, size_t transferred) {
+
+	this->calls.fetch_add(1, std::memory_order_relaxed);
+	this->bytes.fetch_add(transferred, std::memory_order_relaxed);
+	if (transferred < requested)
+		this->shortCalls.fetch_add(1, std::memory_order_relaxed);
+	this->buckets[bucketOf(transferred)].fetch_add(1, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Returns number of calls
+/// </summary>
+/// <returns></returns>
+uint64_t IoCounter::getCalls() const {
+	return this->calls.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Returns number of bytes of all the calls
+/// </summary>
+/// <returns></returns>
+uint64_t IoCounter::getBytes() const {
+	return this->bytes.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Returns number of calls which moved less than they were asked to
+/// </summary>
+/// <returns></returns>
+uint64_t IoCounter::getShortCalls() const {
+	return this->shortCalls.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Writes the counts in a line, followed by a line of the non-empty buckets of the histogram
+/// </summary>
+/// <param name="out"></param>
+/// <param name="name"></param>
+void IoCounter::write(std::ostream& out, const std::string& name) const {
+
+	uint64_t calls = this->getCalls();
+	uint64_t bytes = this->getBytes();
+
+	out << std::left << std::setw(16) << name + ":" << std::right << calls << " calls, " << bytes << " bytes";
+	if (calls > 0)
+		out << ", " << bytes / calls << " bytes/call";
+	out << ", " << this->getShortCalls() << " short" << std::endl;
+
+	if (calls == 0)
+		return;
+
+	// every bucket as the range of sizes it counts, e.g. "4K-8K: 12" for calls of 4096 to 8191 bytes
+	out << std::setw(16) << "" << "bytes/call";
+	for (size_t bucket = 0; bucket < IO_SIZE_BUCKETS; bucket++) {
+		uint64_t count = this->buckets[bucket].load(std::memory_order_relaxed);
+		if (count == 0)
+			continue;
+
+		if (bucket == 0)
+			out << " 0: " << count;
+		else
+			out << " " << formatSize(1ull << (bucket - 1)) << "-" << formatSize(1ull << bucket) << ": " << count;
+	}
+	out << std::endl;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <array>
+#include <atomic>
+#include <iostream>
+
+const size_t IO_SIZE_BUCKETS = 34;	// bucket 0 counts calls of 0 bytes, bucket i calls of [2^(i-1), 2^i) bytes
+
+/// <summary>
+/// Counts the calls of one kind of I/O or copy - how many, how many bytes, how many moved less than asked,
+/// and a histogram of bytes per call in powers of two. Safe to record from several threads
+/// </summary>
+class IoCounter {
+
+private:
+	// members
+	std::atomic<uint64_t> calls;
+	std::atomic<uint64_t> bytes;
+	std::atomic<uint64_t> shortCalls;
+	std::array<std::atomic<uint64_t>, IO_SIZE_BUCKETS> buckets;
+
+	/// <summary>
+	/// Returns the histogram bucket of a number of bytes
+	/// </summary>
+	/// <param name="size"></param>
+	/// <returns></returns>
+	static size_t bucketOf(uint64_t size);
+
+	/// <summary>
+	/// Returns a number of bytes in the shortest unit, such as 64K
+	/// </summary>
+	/// <param name="size"></param>
+	/// <returns></returns>
+	static std::string formatSize(uint64_t size);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	IoCounter();
+
+	IoCounter(const IoCounter&) = delete;
+	IoCounter& operator=(const IoCounter&) = delete;
+
+	/// <summary>
+	/// Records a call
+	/// </summary>
+	/// <param name="requested">bytes the call was asked to move</param>
+	/// <param name="transferred">bytes the call moved</param>
+	void record(size_t requested, size_t transferred);
+
+	/// <summary>
+	/// Returns number of calls
+	/// </summary>
+	/// <returns></returns>
+	uint64_t getCalls() const;
+
+	/// <summary>
+	/// Returns number of bytes of all the calls
+	/// </summary>
+	/// <returns></returns>
+	uint64_t getBytes() const;
+
+	/// <summary>
+	/// Returns number of calls which moved less than they were asked to
+	/// </summary>
+	/// <returns></returns>
+	uint64_t getShortCalls() const;
+
+	/// <summary>
+	/// Writes the counts in a line, followed by a line of the non-empty buckets of the histogram
+	/// </summary>
+	/// <param name="out"></param>
+	/// <param name="name"></param>
+	void write(std::ostream& out, const std::string& name) const;
+};
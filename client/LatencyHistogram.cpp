@@ -0,0 +1,113 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Ctor
+/// </summary>
+LatencyHistogram::LatencyHistogram() {
+	for (std::atomic<uint64_t>& bucket : this->buckets)
+		bucket.store(0);
+	this->count.store(0);
+	this->sum.store(0);
+	this->max.store(0);
+}
+
+/// <summary>
+/// Returns index of the bucket of a value
+/// </summary>
+/// <param name="value"></param>
+/// <returns></returns>
+size_t LatencyHistogram::bucketOf(uint64_t value) {
+
+	// the first 64 values have a bucket each
+	if (value < SUB_BUCKET_COUNT)
+		return (size_t)value;
+
+	// above them, every power of two is split into 64 buckets - the 6 bits below the highest bit pick the bucket
+	size_t magnitude = 0;
+	while ((value >> (magnitude + SUB_BUCKET_BITS + 1)) != 0)
+		magnitude++;
+
+	return (magnitude + 1) * SUB_BUCKET_COUNT + (size_t)((value >> magnitude) - SUB_BUCKET_COUNT);
+}
+
+/// <summary>
+/// Returns the highest value of a bucket
+/// </summary>
+/// <param name="index"></param>
+/// <returns></returns>
+uint64_t LatencyHistogram::highestOf(size_t index) {
+
+	if (index < SUB_BUCKET_COUNT)
+		return index;
+
+	size_t magnitude = index / SUB_BUCKET_COUNT - 1;
+	uint64_t subBucket = SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT;
+	return ((subBucket + 1) << magnitude) - 1;
+}
+
+/// <summary>
+/// Records a latency
+/// </summary>
+/// <param name="latency"></param>
+void LatencyHistogram::record(std::chrono::steady_clock::duration latency) {
+
+	uint64_t value = (uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+	value = std::min(value, ((uint64_t)1 << MAX_LATENCY_BITS) - 1);
+
+	// the counters are independent - a report taken while recording may be off by the latencies being recorded
+	this->buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+	this->count.fetch_add(1, std::memory_order_relaxed);
+	this->sum.fetch_add(value, std::memory_order_relaxed);
+
+	uint64_t previous = this->max.load(std::memory_order_relaxed);
+	while (value > previous && !this->max.compare_exchange_weak(previous, value, std::memory_order_relaxed));
+}
+
+/// <summary>
+/// Returns number of recorded latencies
+/// </summary>
+/// <returns></returns>
+uint64_t LatencyHistogram::getCount() const {
+	return this->count.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Returns the latency in microseconds below which a fraction of the recorded latencies are
+/// </summary>
+/// <param name="fraction"></param>
+/// <returns>the highest value of its bucket, so it is never below the real latency</returns>
+uint64_t LatencyHistogram::percentile(double fraction) const {
+
+	uint64_t total = this->getCount();
+	if (total == 0)
+		return 0;
+
+	// nearest rank - the smallest latency that at least the fraction of the latencies are not above
+	uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(fraction * total));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+		seen += this->buckets[i].load(std::memory_order_relaxed);
+		if (seen >= rank)
+			return std::min(highestOf(i), this->max.load(std::memory_order_relaxed));
+	}
+
+	return this->max.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Writes a line of count, mean, p50/p90/p99/p999 and max latency in microseconds
+/// </summary>
+/// <param name="out"></param>
+/// <param name="name"></param>
+void LatencyHistogram::write(std::ostream& out, const std::string& name) const {
+
+	uint64_t total = this->getCount();
+	uint64_t mean = total > 0 ? this->sum.load(std::memory_order_relaxed) / total : 0;
+
+	out << std::left << std::setw(14) << name << std::right << std::setw(10) << total << std::setw(12) << mean
+		<< std::setw(12) << this->percentile(0.5) << std::setw(12) << this->percentile(0.9) << std::setw(12)
+		<< this->percentile(0.99) << std::setw(12) << this->percentile(0.999) << std::setw(12)
+		<< this->max.load(std::memory_order_relaxed) << std::endl;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+const size_t SUB_BUCKET_BITS = 6;
+const size_t SUB_BUCKET_COUNT = (size_t)1 << SUB_BUCKET_BITS;
+const size_t MAX_LATENCY_BITS = 41;
+const size_t LATENCY_BUCKET_COUNT = (MAX_LATENCY_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+/// <summary>
+/// Histogram of latencies in microseconds, in the layout of an HDR histogram - every power of two is split into
+/// 64 linear buckets, so every value is kept within 1.6% of its size, from 1 microsecond to about 25 days.
+/// Its buckets are allocated with it and counted atomically, so threads record into it without locking
+/// </summary>
+class LatencyHistogram {
+
+private:
+	// members
+	std::array<std::atomic<uint64_t>, LATENCY_BUCKET_COUNT> buckets;
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> sum;
+	std::atomic<uint64_t> max;
+
+	/// <summary>
+	/// Returns index of the bucket of a value
+	/// </summary>
+	/// <param name="value"></param>
+	/// <returns></returns>
+	static size_t bucketOf(uint64_t value);
+
+	/// <summary>
+	/// Returns the highest value of a bucket
+	/// </summary>
+	/// <param name="index"></param>
+	/// <returns></returns>
+	static uint64_t highestOf(size_t index);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	LatencyHistogram();
+
+	/// <summary>
+	/// Records a latency
+	/// </summary>
+	/// <param name="latency"></param>
+	void record(std::chrono::steady_clock::duration latency);
+
+	/// <summary>
+	/// Returns number of recorded latencies
+	/// </summary>
+	/// <returns></returns>
+	uint64_t getCount() const;
+
+	/// <summary>
+	/// Returns the latency in microseconds below which a fraction of the recorded latencies are
+	/// </summary>
+	/// <param name="fraction"></param>
+	/// <returns>the highest value of its bucket, so it is never below the real latency</returns>
+	uint64_t percentile(double fraction) const;
+
+	/// <summary>
+	/// Writes a line of count, mean, p50/p90/p99/p999 and max latency in microseconds
+	/// </summary>
+	/// <param name="out"></param>
+	/// <param name="name"></param>
+	void write(std::ostream& out, const std::string& name) const;
+};
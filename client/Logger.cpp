@@ -0,0 +1,452 @@
+#include "Logger.h"
+#include <cstring>
+#include <algorithm>
+#include <ctime>
+#include <cstdio>
+
+std::atomic<LogLevel> Logger::minLevel(LogLevel::Info);
+LogFormat Logger::recordFormat = LogFormat::Text;
+std::unique_ptr<Logger::Slot[]> Logger::ring;
+std::atomic<size_t> Logger::enqueuePosition(0);
+std::atomic<size_t> Logger::writtenPosition(0);
+size_t Logger::dequeuePosition = 0;
+std::atomic<bool> Logger::isRunning(false);
+std::atomic<bool> Logger::isWriterIdle(false);
+bool Logger::stopWriter = false;
+std::thread Logger::writer;
+std::mutex Logger::writerMutex;
+std::condition_variable Logger::writerWakeup;
+std::mutex Logger::consoleMutex;
+
+/// <summary>
+/// Ctor of a string field
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+LogField::LogField(const char* key, std::string_view value)
+	: key(key), type(Type::String), signedValue(0), unsignedValue(0), stringValue(value) {
+}
+
+/// <summary>
+/// Ctor of a string field
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+LogField::LogField(const char* key, const std::string& value) : LogField(key, std::string_view(value)) {
+}
+
+/// <summary>
+/// Ctor of a string field
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+LogField::LogField(const char* key, const char* value) : LogField(key, std::string_view(value ? value : "")) {
+}
+
+/// <summary>
+/// Starts the writer thread - records of lower level than the given one are dropped.
+/// Until started (and after stopped), records are written by the thread that logs them
+/// </summary>
+/// <param name="level"></param>
+/// <param name="format"></param>
+void Logger::start(LogLevel level, LogFormat format) {
+
+	if (isRunning)
+		stop();
+
+	minLevel = level;
+	recordFormat = format;
+	if (level == LogLevel::Off)
+		return;
+
+	// a slot may be written at the position equal to its sequence, and holds a record once its sequence is one more
+	if (!ring)
+		ring.reset(new Slot[LOG_RING_CAPACITY]);
+	for (size_t i = 0; i < LOG_RING_CAPACITY; i++)
+		ring[i].sequence.store(i, std::memory_order_relaxed);
+	enqueuePosition = 0;
+	writtenPosition = 0;
+	dequeuePosition = 0;
+	stopWriter = false;
+
+	isRunning = true;
+	writer = std::thread(&Logger::writeRecords);
+}
+
+/// <summary>
+/// Writes the records left and stops the writer thread
+/// </summary>
+void Logger::stop() {
+
+	if (!isRunning)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		stopWriter = true;
+	}
+	writerWakeup.notify_one();
+	writer.join();
+
+	// records logged while the writer was stopping are written by their threads from now on
+	isRunning = false;
+	drain();
+}
+
+/// <summary>
+/// Waits until all the records logged so far are written - before writing to the console directly
+/// </summary>
+void Logger::flush() {
+
+	if (!isRunning)
+		return;
+
+	size_t target = enqueuePosition.load();
+	while (writtenPosition.load() < target && isRunning) {
+		writerWakeup.notify_one();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+/// <summary>
+/// Returns true if records of a level are written
+/// </summary>
+/// <param name="level"></param>
+/// <returns></returns>
+bool Logger::isEnabled(LogLevel level) {
+	return level >= minLevel.load(std::memory_order_relaxed) && level != LogLevel::Off;
+}
+
+/// <summary>
+/// Logs a record
+/// </summary>
+/// <param name="level"></param>
+/// <param name="message">a string literal - only its address is kept</param>
+/// <param name="fields"></param>
+void Logger::log(LogLevel level, const char* message, std::initializer_list<LogField> fields) {
+
+	if (!isEnabled(level))
+		return;
+
+	if (isRunning) {
+		enqueue(level, message, fields);
+		return;
+	}
+
+	// no writer thread - the record is written right away
+	LogRecord record;
+	fill(record, level, message, fields);
+	std::string line;
+	format(record, line);
+
+	std::lock_guard<std::mutex> lock(consoleMutex);
+	std::ostream& out = level >= LogLevel::Error ? std::cerr : std::cout;
+	out << line << std::flush;
+}
+
+/// <summary>
+/// Logs a debug record
+/// </summary>
+/// <param name="message">a string literal - only its address is kept</param>
+/// <param name="fields"></param>
+void Logger::debug(const char* message, std::initializer_list<LogField> fields) {
+	log(LogLevel::Debug, message, fields);
+}
+
+/// <summary>
+/// Logs an info record
+/// </summary>
+/// <param name="message">a string literal - only its address is kept</param>
+/// <param name="fields"></param>
+void Logger::info(const char* message, std::initializer_list<LogField> fields) {
+	log(LogLevel::Info, message, fields);
+}
+
+/// <summary>
+/// Logs a warning record
+/// </summary>
+/// <param name="message">a string literal - only its address is kept</param>
+/// <param name="fields"></param>
+void Logger::warning(const char* message, std::initializer_list<LogField> fields) {
+	log(LogLevel::Warning, message, fields);
+}
+
+/// <summary>
+/// Logs an error record
+/// </summary>
+/// <param name="message">a string literal - only its address is kept</param>
+/// <param name="fields"></param>
+void Logger::error(const char* message, std::initializer_list<LogField> fields) {
+	log(LogLevel::Error, message, fields);
+}
+
+/// <summary>
+/// Copies a record into the ring, waiting for the writer if the ring is full
+/// </summary>
+/// <param name="level"></param>
+/// <param name="message"></param>
+/// <param name="fields"></param>
+void Logger::enqueue(LogLevel level, const char* message, std::initializer_list<LogField> fields) {
+
+	// claiming the next free slot - several threads may race for it, the one whose compare exchange succeeds owns it
+	Slot* slot = nullptr;
+	size_t position = enqueuePosition.load(std::memory_order_relaxed);
+	while (true) {
+		slot = &ring[position & (LOG_RING_CAPACITY - 1)];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+		if (difference == 0) {
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0) {
+			// the ring is full - records are not dropped, the thread waits for the writer to free a slot
+			writerWakeup.notify_one();
+			std::this_thread::yield();
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+		else {
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	fill(slot->record, level, message, fields);
+	slot->sequence.store(position + 1, std::memory_order_release);
+
+	// the writer is woken only if it sleeps - otherwise it finds the record on its next pass
+	if (isWriterIdle.load()) {
+		std::lock_guard<std::mutex> lock(writerMutex);
+		writerWakeup.notify_one();
+	}
+}
+
+/// <summary>
+/// Builds a record
+/// </summary>
+/// <param name="record"></param>
+/// <param name="level"></param>
+/// <param name="message"></param>
+/// <param name="fields"></param>
+void Logger::fill(LogRecord& record, LogLevel level, const char* message, std::initializer_list<LogField> fields) {
+
+	record.time = std::chrono::system_clock::now();
+	record.level = level;
+	record.message = message;
+	record.fieldCount = 0;
+
+	size_t textSize = 0;
+	for (const LogField& field : fields) {
+		if (record.fieldCount == MAX_LOG_FIELDS)
+			break;
+
+		RecordField& recordField = record.fields[record.fieldCount++];
+		recordField.key = field.key;
+		recordField.type = field.type;
+		recordField.signedValue = field.signedValue;
+		recordField.unsignedValue = field.unsignedValue;
+
+		// the value of a string is copied, since the caller may free it right after logging
+		size_t size = 0;
+		if (field.type == LogField::Type::String) {
+			size = std::min(field.stringValue.size(), LOG_TEXT_SIZE - textSize);
+			memcpy(record.text + textSize, field.stringValue.data(), size);
+		}
+		recordField.textOffset = (uint16_t)textSize;
+		recordField.textSize = (uint16_t)size;
+		textSize += size;
+	}
+}
+
+/// <summary>
+/// Writes the records of the ring until the logger is stopped
+/// </summary>
+void Logger::writeRecords() {
+
+	while (true) {
+		if (drain() > 0)
+			continue;
+
+		std::unique_lock<std::mutex> lock(writerMutex);
+		if (stopWriter)
+			break;
+
+		// a record put after the ring was found empty wakes the writer, at worst it is found at the timeout
+		isWriterIdle = true;
+		writerWakeup.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_IDLE_MS));
+		isWriterIdle = false;
+	}
+
+	drain();
+}
+
+/// <summary>
+/// Formats all the records in the ring and writes them out
+/// </summary>
+/// <returns>number of records written</returns>
+size_t Logger::drain() {
+
+	std::string out;
+	std::string err;
+	size_t count = 0;
+
+	std::lock_guard<std::mutex> lock(consoleMutex);
+	if (!ring)
+		return 0;
+
+	while (true) {
+		Slot& slot = ring[dequeuePosition & (LOG_RING_CAPACITY - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+			break;
+
+		// errors go to the standard error - what was formatted for the standard output before them is written first
+		if (slot.record.level >= LogLevel::Error) {
+			if (!out.empty()) {
+				std::cout << out;
+				out.clear();
+			}
+			format(slot.record, err);
+		}
+		else {
+			if (!err.empty()) {
+				std::cout << std::flush;
+				std::cerr << err;
+				err.clear();
+			}
+			format(slot.record, out);
+		}
+
+		// the slot is free to be written once the ring wraps around to it
+		slot.sequence.store(dequeuePosition + LOG_RING_CAPACITY, std::memory_order_release);
+		dequeuePosition++;
+		count++;
+	}
+
+	if (count == 0)
+		return 0;
+
+	std::cout << out << std::flush;
+	std::cerr << err << std::flush;
+	writtenPosition = dequeuePosition;
+	return count;
+}
+
+/// <summary>
+/// Formats a record as a line, in the format of the logger
+/// </summary>
+/// <param name="record"></param>
+/// <param name="line"></param>
+void Logger::format(const LogRecord& record, std::string& line) {
+
+	if (recordFormat == LogFormat::Json) {
+		// time in UTC with milliseconds
+		std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+		long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+			record.time.time_since_epoch()).count() % 1000;
+		std::tm utc;
+#ifdef _WIN32
+		gmtime_s(&utc, &seconds);
+#else
+		gmtime_r(&seconds, &utc);
+#endif
+		char time[64];
+		snprintf(time, sizeof(time), "%04d-%02d-%02dT%02d:%02d:%02d.%03lldZ", utc.tm_year + 1900, utc.tm_mon + 1,
+			utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, milliseconds);
+
+		line += "{\"time\":\"";
+		line += time;
+		line += "\",\"level\":\"";
+		line += getLevelName(record.level);
+		line += "\",\"message\":";
+		appendString(record.message, line);
+	}
+	else {
+		line += record.message;
+	}
+
+	for (size_t i = 0; i < record.fieldCount; i++) {
+		const RecordField& field = record.fields[i];
+		if (recordFormat == LogFormat::Json) {
+			line += ",\"";
+			line += field.key;
+			line += "\":";
+		}
+		else {
+			line += " ";
+			line += field.key;
+			line += "=";
+		}
+
+		if (field.type == LogField::Type::Signed)
+			line += std::to_string(field.signedValue);
+		else if (field.type == LogField::Type::Unsigned)
+			line += std::to_string(field.unsignedValue);
+		else
+			appendString(std::string_view(record.text + field.textOffset, field.textSize), line);
+	}
+
+	if (recordFormat == LogFormat::Json)
+		line += "}";
+	line += "\n";
+}
+
+/// <summary>
+/// Appends a string to a line, quoted and escaped if the format needs it
+/// </summary>
+/// <param name="str"></param>
+/// <param name="line"></param>
+void Logger::appendString(std::string_view str, std::string& line) {
+
+	// a text value is quoted only if it could not be told apart from the next field otherwise
+	bool isQuoted = recordFormat == LogFormat::Json || str.empty()
+		|| str.find_first_of(" \"=\t\r\n") != std::string_view::npos;
+	if (!isQuoted) {
+		line += str;
+		return;
+	}
+
+	line += "\"";
+	for (char c : str) {
+		switch (c) {
+		case '"': line += "\\\""; break;
+		case '\\': line += "\\\\"; break;
+		case '\n': line += "\\n"; break;
+		case '\r': line += "\\r"; break;
+		case '\t': line += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20) {
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				line += escaped;
+			}
+			else {
+				line += c;
+			}
+		}
+	}
+	line += "\"";
+}
+
+/// <summary>
+/// Returns the name of a level
+/// </summary>
+/// <param name="level"></param>
+/// <returns></returns>
+std::string Logger::getLevelName(LogLevel level) {
+	switch (level) {
+	case LogLevel::Debug: return "debug";
+	case LogLevel::Info: return "info";
+	case LogLevel::Warning: return "warning";
+	case LogLevel::Error: return "error";
+	default: return "off";
+	}
+}
+
+/// <summary>
+/// Returns the name of a format
+/// </summary>
+/// <param name="format"></param>
+/// <returns></returns>
+std::string Logger::getFormatName(LogFormat format) {
+	return format == LogFormat::Json ? "json" : "text";
+}
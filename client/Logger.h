@@ -0,0 +1,269 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+
+const size_t LOG_RING_CAPACITY = 4096;	// power of two
+const size_t MAX_LOG_FIELDS = 6;
+const size_t LOG_TEXT_SIZE = 256;	// bytes of the string fields of a record, longer strings are cut
+const size_t LOG_WRITER_IDLE_MS = 50;
+
+/// <summary>
+/// Levels of log records - records below the level of the logger are dropped before they are built
+/// </summary>
+enum class LogLevel {
+	Debug,
+	Info,
+	Warning,
+	Error,
+	Off
+};
+
+/// <summary>
+/// Layouts of written log records
+/// </summary>
+enum class LogFormat {
+	Text,	// the message followed by key=value of every field
+	Json	// a json object per line, with time, level, message and the fields
+};
+
+/// <summary>
+/// A key and value of a log record. The value is only referenced - it is copied into the record by the logger
+/// </summary>
+class LogField {
+
+public:
+	enum class Type {
+		Signed,
+		Unsigned,
+		String
+	};
+
+	// members
+	const char* key;
+	Type type;
+	int64_t signedValue;
+	uint64_t unsignedValue;
+	std::string_view stringValue;
+
+	/// <summary>
+	/// Ctor of a number field
+	/// </summary>
+	/// <param name="key"></param>
+	/// <param name="value"></param>
+	template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+	LogField(const char* key, T value) : key(key), signedValue(0), unsignedValue(0) {
+		if (std::is_signed<T>::value) {
+			this->type = Type::Signed;
+			this->signedValue = (int64_t)value;
+		}
+		else {
+			this->type = Type::Unsigned;
+			this->unsignedValue = (uint64_t)value;
+		}
+	}
+
+	/// <summary>
+	/// Ctor of a string field
+	/// </summary>
+	/// <param name="key"></param>
+	/// <param name="value"></param>
+	LogField(const char* key, std::string_view value);
+
+	/// <summary>
+	/// Ctor of a string field
+	/// </summary>
+	/// <param name="key"></param>
+	/// <param name="value"></param>
+	LogField(const char* key, const std::string& value);
+
+	/// <summary>
+	/// Ctor of a string field
+	/// </summary>
+	/// <param name="key"></param>
+	/// <param name="value"></param>
+	LogField(const char* key, const char* value);
+};
+
+/// <summary>
+/// Writes log records of all the threads of the process from a background thread.
+/// Threads put their records in a lock-free ring and go on - formatting and console I/O happen on the writer thread,
+/// which writes all the records it finds at once and flushes once per batch
+/// </summary>
+class Logger {
+
+private:
+	/// <summary>
+	/// A field copied into a record - a string value is kept in the text of its record
+	/// </summary>
+	struct RecordField {
+		const char* key;
+		LogField::Type type;
+		int64_t signedValue;
+		uint64_t unsignedValue;
+		uint16_t textOffset;
+		uint16_t textSize;
+	};
+
+	/// <summary>
+	/// A log record as put in the ring
+	/// </summary>
+	struct LogRecord {
+		std::chrono::system_clock::time_point time;
+		LogLevel level;
+		const char* message;
+		size_t fieldCount;
+		RecordField fields[MAX_LOG_FIELDS];
+		char text[LOG_TEXT_SIZE];
+	};
+
+	/// <summary>
+	/// A slot of the ring - its sequence tells whether it is free to be written or holds a record to be written out
+	/// </summary>
+	struct Slot {
+		std::atomic<size_t> sequence;
+		LogRecord record;
+	};
+
+	// members
+	static std::atomic<LogLevel> minLevel;
+	static LogFormat recordFormat;
+	static std::unique_ptr<Slot[]> ring;
+	static std::atomic<size_t> enqueuePosition;
+	static std::atomic<size_t> writtenPosition;
+	static size_t dequeuePosition;
+	static std::atomic<bool> isRunning;
+	static std::atomic<bool> isWriterIdle;
+	static bool stopWriter;
+	static std::thread writer;
+	static std::mutex writerMutex;
+	static std::condition_variable writerWakeup;
+	static std::mutex consoleMutex;
+
+	/// <summary>
+	/// Copies a record into the ring, waiting for the writer if the ring is full
+	/// </summary>
+	/// <param name="level"></param>
+	/// <param name="message"></param>
+	/// <param name="fields"></param>
+	static void enqueue(LogLevel level, const char* message, std::initializer_list<LogField> fields);
+
+	/// <summary>
+	/// Builds a record
+	/// </summary>
+	/// <param name="record"></param>
+	/// <param name="level"></param>
+	/// <param name="message"></param>
+	/// <param name="fields"></param>
+	static void fill(LogRecord& record, LogLevel level, const char* message, std::initializer_list<LogField> fields);
+
+	/// <summary>
+	/// Writes the records of the ring until the logger is stopped
+	/// </summary>
+	static void writeRecords();
+
+	/// <summary>
+	/// Formats all the records in the ring and writes them out
+	/// </summary>
+	/// <returns>number of records written</returns>
+	static size_t drain();
+
+	/// <summary>
+	/// Formats a record as a line, in the format of the logger
+	/// </summary>
+	/// <param name="record"></param>
+	/// <param name="line"></param>
+	static void format(const LogRecord& record, std::string& line);
+
+	/// <summary>
+	/// Appends a string to a line, quoted and escaped if the format needs it
+	/// </summary>
+	/// <param name="str"></param>
+	/// <param name="line"></param>
+	static void appendString(std::string_view str, std::string& line);
+
+public:
+	/// <summary>
+	/// Starts the writer thread - records of lower level than the given one are dropped.
+	/// Until started (and after stopped), records are written by the thread that logs them
+	/// </summary>
+	/// <param name="level"></param>
+	/// <param name="format"></param>
+	static void start(LogLevel level, LogFormat format);
+
+	/// <summary>
+	/// Writes the records left and stops the writer thread
+	/// </summary>
+	static void stop();
+
+	/// <summary>
+	/// Waits until all the records logged so far are written - before writing to the console directly
+	/// </summary>
+	static void flush();
+
+	/// <summary>
+	/// Returns true if records of a level are written
+	/// </summary>
+	/// <param name="level"></param>
+	/// <returns></returns>
+	static bool isEnabled(LogLevel level);
+
+	/// <summary>
+	/// Logs a record
+	/// </summary>
+	/// <param name="level"></param>
+	/// <param name="message">a string literal - only its address is kept</param>
+	/// <param name="fields"></param>
+	static void log(LogLevel level, const char* message, std::initializer_list<LogField> fields = {});
+
+	/// <summary>
+	/// Logs a debug record
+	/// </summary>
+	/// <param name="message">a string literal - only its address is kept</param>
+	/// <param name="fields"></param>
+	static void debug(const char* message, std::initializer_list<LogField> fields = {});
+
+	/// <summary>
+	/// Logs an info record
+	/// </summary>
+	/// <param name="message">a string literal - only its address is kept</param>
+	/// <param name="fields"></param>
+	static void info(const char* message, std::initializer_list<LogField> fields = {});
+
+	/// <summary>
+	/// Logs a warning record
+	/// </summary>
+	/// <param name="message">a string literal - only its address is kept</param>
+	/// <param name="fields"></param>
+	static void warning(const char* message, std::initializer_list<LogField> fields = {});
+
+	/// <summary>
+	/// Logs an error record
+	/// </summary>
+	/// <param name="message">a string literal - only its address is kept</param>
+	/// <param name="fields"></param>
+	static void error(const char* message, std::initializer_list<LogField> fields = {});
+
+	/// <summary>
+	/// Returns the name of a level
+	/// </summary>
+	/// <param name="level"></param>
+	/// <returns></returns>
+	static std::string getLevelName(LogLevel level);
+
+	/// <summary>
+	/// Returns the name of a format
+	/// </summary>
+	/// <param name="format"></param>
+	/// <returns></returns>
+	static std::string getFormatName(LogFormat format);
+};
@@ -0,0 +1,185 @@
+#include "PhaseProfiler.h"
+
+#ifdef _WIN32
+const int PROFILE_SIGNAL = SIGBREAK;
+#else
+const int PROFILE_SIGNAL = SIGUSR1;
+#endif
+
+std::atomic<bool> PhaseProfiler::enabled(false);
+std::array<LatencyHistogram, (size_t)UploadPhase::Count> PhaseProfiler::histograms;
+std::string PhaseProfiler::reportPath;
+std::mutex PhaseProfiler::reportMutex;
+volatile std::sig_atomic_t PhaseProfiler::reportRequested = 0;
+std::thread PhaseProfiler::signalWatcher;
+std::mutex PhaseProfiler::watcherMutex;
+std::condition_variable PhaseProfiler::watcherStopped;
+bool PhaseProfiler::stopWatcher = false;
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="phase"></param>
+PhaseProfiler::Span::Span(UploadPhase phase) {
+	this->phase = phase;
+
+	// reading the clock only while profiling or tracing, so a disabled span costs two loads
+	this->isTimed = PhaseProfiler::isEnabled() || TraceRecorder::isEnabled();
+	if (this->isTimed)
+		this->start = std::chrono::steady_clock::now();
+}
+
+/// <summary>
+/// Dtor
+/// </summary>
+PhaseProfiler::Span::~Span() {
+
+	if (!this->isTimed)
+		return;
+
+	auto end = std::chrono::steady_clock::now();
+	PhaseProfiler::record(this->phase, end - this->start);
+	TraceRecorder::recordComplete(getPhaseName(this->phase), "file", this->start, end);
+}
+
+/// <summary>
+/// Starts timing phases, and writing a report to a path (or to standard output if the path is "-")
+/// whenever the process gets SIGUSR1 (SIGBREAK on Windows) and at stop
+/// </summary>
+/// <param name="path"></param>
+void PhaseProfiler::start(const std::string& path) {
+
+	if (enabled.exchange(true))
+		return;
+
+	reportPath = path;
+	stopWatcher = false;
+	reportRequested = 0;
+	std::signal(PROFILE_SIGNAL, PhaseProfiler::onSignal);
+	signalWatcher = std::thread(PhaseProfiler::watchSignal);
+}
+
+/// <summary>
+/// Stops timing phases and writes the final report
+/// </summary>
+void PhaseProfiler::stop() {
+
+	if (!enabled.exchange(false))
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(watcherMutex);
+		stopWatcher = true;
+	}
+	watcherStopped.notify_all();
+	signalWatcher.join();
+	std::signal(PROFILE_SIGNAL, SIG_DFL);
+
+	dump();
+}
+
+/// <summary>
+/// Returns true if phases are timed
+/// </summary>
+/// <returns></returns>
+bool PhaseProfiler::isEnabled() {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Records the latency of a phase
+/// </summary>
+/// <param name="phase"></param>
+/// <param name="latency"></param>
+void PhaseProfiler::record(UploadPhase phase, std::chrono::steady_clock::duration latency) {
+	if (isEnabled())
+		histograms[(size_t)phase].record(latency);
+}
+
+/// <summary>
+/// Returns the name of a phase
+/// </summary>
+/// <param name="phase"></param>
+/// <returns></returns>
+std::string PhaseProfiler::getPhaseName(UploadPhase phase) {
+
+	switch (phase) {
+	case UploadPhase::Read:
+		return "read";
+	case UploadPhase::Compress:
+		return "compress";
+	case UploadPhase::Encrypt:
+		return "encrypt";
+	case UploadPhase::Cksum:
+		return "cksum";
+	case UploadPhase::Send:
+		return "send";
+	case UploadPhase::ServerWait:
+		return "server_wait";
+	default:
+		return "unknown";
+	}
+}
+
+/// <summary>
+/// Writes count, mean, percentiles and max latency of every phase
+/// </summary>
+/// <param name="out"></param>
+void PhaseProfiler::writeReport(std::ostream& out) {
+
+	out << std::left << std::setw(14) << "phase" << std::right << std::setw(10) << "count" << std::setw(12) << "mean us"
+		<< std::setw(12) << "p50 us" << std::setw(12) << "p90 us" << std::setw(12) << "p99 us" << std::setw(12)
+		<< "p999 us" << std::setw(12) << "max us" << std::endl;
+
+	for (size_t i = 0; i < (size_t)UploadPhase::Count; i++)
+		histograms[i].write(out, getPhaseName((UploadPhase)i));
+}
+
+/// <summary>
+/// Writes the report to its path
+/// </summary>
+void PhaseProfiler::dump() {
+
+	std::lock_guard<std::mutex> lock(reportMutex);
+
+	// the report is written to the console directly - after the records logged before it
+	if (reportPath == "-") {
+		Logger::flush();
+		std::cout << std::endl << "Latency of upload phases:" << std::endl;
+		writeReport(std::cout);
+		return;
+	}
+
+	// every report replaces the previous one - the histograms are cumulative
+	std::ofstream out(reportPath, std::ofstream::trunc);
+	if (!out.is_open()) {
+		Logger::error("Cannot write latency report", { { "path", reportPath } });
+		return;
+	}
+	writeReport(out);
+}
+
+/// <summary>
+/// Signal handler - only marks that a report is wanted, the report is written by the watcher thread
+/// </summary>
+/// <param name="signal"></param>
+void PhaseProfiler::onSignal(int signal) {
+	reportRequested = 1;
+
+	// some platforms reset the handler once it is called
+	std::signal(signal, PhaseProfiler::onSignal);
+}
+
+/// <summary>
+/// Writes a report whenever the process is signalled, until the profiler is stopped
+/// </summary>
+void PhaseProfiler::watchSignal() {
+
+	std::unique_lock<std::mutex> lock(watcherMutex);
+	while (!watcherStopped.wait_for(lock, std::chrono::milliseconds(PROFILE_SIGNAL_POLL_MS), []() { return stopWatcher; })) {
+		if (reportRequested) {
+			reportRequested = 0;
+			dump();
+		}
+	}
+}
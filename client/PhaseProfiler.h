@@ -0,0 +1,128 @@
+#pragma once
+#include <string>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <fstream>
+#include "LatencyHistogram.h"
+#include "TraceRecorder.h"
+#include "Logger.h"
+
+const size_t PROFILE_SIGNAL_POLL_MS = 200;
+
+/// <summary>
+/// Phases of the upload path which are timed
+/// </summary>
+enum class UploadPhase {
+	Read,
+	Compress,
+	Encrypt,
+	Cksum,
+	Send,
+	ServerWait,
+	Count
+};
+
+/// <summary>
+/// Times the phases of the upload path of all the threads of the process into a latency histogram per phase,
+/// and writes them as a report at exit or when the process is signalled
+/// </summary>
+class PhaseProfiler {
+
+private:
+	// members
+	static std::atomic<bool> enabled;
+	static std::array<LatencyHistogram, (size_t)UploadPhase::Count> histograms;
+	static std::string reportPath;
+	static std::mutex reportMutex;
+	static volatile std::sig_atomic_t reportRequested;
+	static std::thread signalWatcher;
+	static std::mutex watcherMutex;
+	static std::condition_variable watcherStopped;
+	static bool stopWatcher;
+
+	/// <summary>
+	/// Signal handler - only marks that a report is wanted, the report is written by the watcher thread
+	/// </summary>
+	/// <param name="signal"></param>
+	static void onSignal(int signal);
+
+	/// <summary>
+	/// Writes a report whenever the process is signalled, until the profiler is stopped
+	/// </summary>
+	static void watchSignal();
+
+public:
+	/// <summary>
+	/// Scope of a phase - times the phase from its construction to its destruction,
+	/// and records it as a trace event if tracing
+	/// </summary>
+	class Span {
+
+	private:
+		UploadPhase phase;
+		bool isTimed;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		/// <summary>
+		/// Ctor
+		/// </summary>
+		/// <param name="phase"></param>
+		Span(UploadPhase phase);
+
+		/// <summary>
+		/// Dtor
+		/// </summary>
+		~Span();
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+	};
+
+	/// <summary>
+	/// Starts timing phases, and writing a report to a path (or to standard output if the path is "-")
+	/// whenever the process gets SIGUSR1 (SIGBREAK on Windows) and at stop
+	/// </summary>
+	/// <param name="path"></param>
+	static void start(const std::string& path);
+
+	/// <summary>
+	/// Stops timing phases and writes the final report
+	/// </summary>
+	static void stop();
+
+	/// <summary>
+	/// Returns true if phases are timed
+	/// </summary>
+	/// <returns></returns>
+	static bool isEnabled();
+
+	/// <summary>
+	/// Records the latency of a phase
+	/// </summary>
+	/// <param name="phase"></param>
+	/// <param name="latency"></param>
+	static void record(UploadPhase phase, std::chrono::steady_clock::duration latency);
+
+	/// <summary>
+	/// Returns the name of a phase
+	/// </summary>
+	/// <param name="phase"></param>
+	/// <returns></returns>
+	static std::string getPhaseName(UploadPhase phase);
+
+	/// <summary>
+	/// Writes count, mean, percentiles and max latency of every phase
+	/// </summary>
+	/// <param name="out"></param>
+	static void writeReport(std::ostream& out);
+
+	/// <summary>
+	/// Writes the report to its path
+	/// </summary>
+	static void dump();
+};
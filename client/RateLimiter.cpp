@@ -0,0 +1,126 @@
+#include "RateLimiter.h"
+
+/// <summary>
+/// Ctor - an unlimited limiter
+/// </summary>
+RateLimiter::RateLimiter() {
+	this->configuredRate = 0;
+	this->rate = 0;
+	this->burst = 0;
+	this->tokens = 0;
+	this->adaptive = false;
+	this->minRtt = 0;
+	this->smoothedRtt = 0;
+	this->lastRefill = std::chrono::steady_clock::now();
+	this->lastBackoff = this->lastRefill;
+}
+
+/// <summary>
+/// Sets the rate and the burst - a rate of 0 removes the limit
+/// </summary>
+/// <param name="bytesPerSecond"></param>
+/// <param name="burstBytes">bytes that may be sent at once after an idle period</param>
+/// <param name="adaptive">whether the rate backs off when the round trip time grows</param>
+void RateLimiter::configure(size_t bytesPerSecond, size_t burstBytes, bool adaptive) {
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->configuredRate = (double)bytesPerSecond;
+	this->rate = (double)bytesPerSecond;
+	this->burst = (double)burstBytes;
+	this->tokens = (double)burstBytes;
+	this->adaptive = adaptive;
+	this->minRtt = 0;
+	this->smoothedRtt = 0;
+	this->lastRefill = std::chrono::steady_clock::now();
+	this->lastBackoff = this->lastRefill;
+}
+
+/// <summary>
+/// Takes tokens for bytes about to be sent, waiting as long as the bucket is in debt
+/// </summary>
+/// <param name="bytes"></param>
+void RateLimiter::acquire(size_t bytes) {
+
+	std::chrono::duration<double> wait(0);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->rate <= 0)
+			return;
+
+		// adding the tokens earned since the last refill, up to the burst
+		auto now = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed = now - this->lastRefill;
+		this->lastRefill = now;
+		this->tokens = std::min(this->burst, this->tokens + elapsed.count() * this->rate);
+
+		// the bytes are taken even if the bucket goes into debt, so a send larger than the burst still goes through
+		// the debt is paid back by waiting, outside the lock, so other senders can take their share meanwhile
+		this->tokens -= (double)bytes;
+		if (this->tokens < 0)
+			wait = std::chrono::duration<double>(-this->tokens / this->rate);
+	}
+
+	if (wait.count() > 0)
+		std::this_thread::sleep_for(wait);
+}
+
+/// <summary>
+/// Adapts the rate to a round trip time sample - backs off while the smoothed round trip time is well above
+/// the lowest one seen (queues are building up along the path), and recovers towards the configured rate otherwise
+/// </summary>
+/// <param name="rtt"></param>
+void RateLimiter::onRoundTrip(std::chrono::microseconds rtt) {
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	if (!this->adaptive || this->configuredRate <= 0)
+		return;
+
+	double sample = (double)rtt.count();
+	if (this->minRtt == 0 || sample < this->minRtt)
+		this->minRtt = sample;
+	this->smoothedRtt = this->smoothedRtt == 0 ? sample : this->smoothedRtt + RTT_SMOOTHING * (sample - this->smoothedRtt);
+
+	// decreasing multiplicatively and increasing additively, like TCP congestion control
+	// backing off at most once a round trip, so the samples sent before the last backoff don't count twice
+	// on a very short path a few milliseconds of jitter are not taken as queueing
+	auto now = std::chrono::steady_clock::now();
+	double queueing = this->smoothedRtt - this->minRtt;
+	if (this->smoothedRtt > RTT_BACKOFF_FACTOR * this->minRtt && queueing > RTT_MIN_QUEUEING_US) {
+		if (now - this->lastBackoff >= std::chrono::microseconds((long long)this->smoothedRtt)) {
+			this->rate = std::max(this->configuredRate * MIN_RATE_FRACTION, this->rate * RATE_DECREASE);
+			this->lastBackoff = now;
+		}
+	}
+	else
+		this->rate = std::min(this->configuredRate, this->rate + this->configuredRate * RATE_INCREASE);
+}
+
+/// <summary>
+/// Returns whether the limiter has a rate
+/// </summary>
+/// <returns></returns>
+bool RateLimiter::isLimited() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->rate > 0;
+}
+
+/// <summary>
+/// Returns the current rate in bytes per second
+/// </summary>
+/// <returns></returns>
+size_t RateLimiter::getRate() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return (size_t)this->rate;
+}
+
+/// <summary>
+/// Returns the configured rate in bytes per second
+/// </summary>
+/// <returns></returns>
+size_t RateLimiter::getConfiguredRate() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return (size_t)this->configuredRate;
+}
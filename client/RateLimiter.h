@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+const double RTT_SMOOTHING = 0.125;
+const double RTT_BACKOFF_FACTOR = 2.0;
+const double RTT_MIN_QUEUEING_US = 5000;
+const double RATE_DECREASE = 0.7;
+const double RATE_INCREASE = 0.05;
+const double MIN_RATE_FRACTION = 0.05;
+
+/// <summary>
+/// Token bucket that shapes bytes sent to a rate - tokens are added at the rate up to the burst,
+/// and a send waits until the tokens it took are paid back
+/// </summary>
+class RateLimiter {
+
+private:
+	// members
+	std::mutex mutex;
+	double configuredRate;
+	double rate;
+	double burst;
+	double tokens;
+	bool adaptive;
+	double minRtt;
+	double smoothedRtt;
+	std::chrono::steady_clock::time_point lastRefill;
+	std::chrono::steady_clock::time_point lastBackoff;
+
+public:
+	/// <summary>
+	/// Ctor - an unlimited limiter
+	/// </summary>
+	RateLimiter();
+
+	/// <summary>
+	/// Sets the rate and the burst - a rate of 0 removes the limit
+	/// </summary>
+	/// <param name="bytesPerSecond"></param>
+	/// <param name="burstBytes">bytes that may be sent at once after an idle period</param>
+	/// <param name="adaptive">whether the rate backs off when the round trip time grows</param>
+	void configure(size_t bytesPerSecond, size_t burstBytes, bool adaptive);
+
+	/// <summary>
+	/// Takes tokens for bytes about to be sent, waiting as long as the bucket is in debt
+	/// </summary>
+	/// <param name="bytes"></param>
+	void acquire(size_t bytes);
+
+	/// <summary>
+	/// Adapts the rate to a round trip time sample - backs off while the smoothed round trip time is well above
+	/// the lowest one seen (queues are building up along the path), and recovers towards the configured rate otherwise
+	/// </summary>
+	/// <param name="rtt"></param>
+	void onRoundTrip(std::chrono::microseconds rtt);
+
+	/// <summary>
+	/// Returns whether the limiter has a rate
+	/// </summary>
+	/// <returns></returns>
+	bool isLimited();
+
+	/// <summary>
+	/// Returns the current rate in bytes per second
+	/// </summary>
+	/// <returns></returns>
+	size_t getRate();
+
+	/// <summary>
+	/// Returns the configured rate in bytes per second
+	/// </summary>
+	/// <returns></returns>
+	size_t getConfiguredRate();
+};
@@ -0,0 +1,48 @@
+#include "RollingChecksum.h"
+
+/// <summary>
+/// Ctor
+/// </summary>
+RollingChecksum::RollingChecksum() {
+	this->a = 0;
+	this->b = 0;
+	this->length = 0;
+}
+
+/// <summary>
+/// Calculates the checksum of a window from scratch
+/// </summary>
+/// <param name="data"></param>
+/// <param name="length">length of the window</param>
+void RollingChecksum::reset(const unsigned char* data, size_t length) {
+	this->a = 0;
+	this->b = 0;
+	this->length = length;
+
+	// a is the sum of the bytes, b is the sum of the bytes weighted by their distance from the end of the window
+	for (size_t i = 0; i < length; i++) {
+		this->a += data[i];
+		this->b += (uint32_t)(length - i) * data[i];
+	}
+
+	this->a &= 0xFFFF;
+	this->b &= 0xFFFF;
+}
+
+/// <summary>
+/// Slides the window one byte forward
+/// </summary>
+/// <param name="out">the byte that leaves the window</param>
+/// <param name="in">the byte that enters the window</param>
+void RollingChecksum::roll(unsigned char out, unsigned char in) {
+	this->a = (this->a - out + in) & 0xFFFF;
+	this->b = (this->b - (uint32_t)this->length * out + this->a) & 0xFFFF;
+}
+
+/// <summary>
+/// Returns the checksum of the current window
+/// </summary>
+/// <returns>checksum</returns>
+uint32_t RollingChecksum::digest() const {
+	return this->a | (this->b << 16);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <cstddef>
+
+class RollingChecksum {
+private:
+
+	// members
+	uint32_t a;
+	uint32_t b;
+	size_t length;
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	RollingChecksum();
+
+	/// <summary>
+	/// Calculates the checksum of a window from scratch
+	/// </summary>
+	/// <param name="data"></param>
+	/// <param name="length">length of the window</param>
+	void reset(const unsigned char* data, size_t length);
+
+	/// <summary>
+	/// Slides the window one byte forward
+	/// </summary>
+	/// <param name="out">the byte that leaves the window</param>
+	/// <param name="in">the byte that enters the window</param>
+	void roll(unsigned char out, unsigned char in);
+
+	/// <summary>
+	/// Returns the checksum of the current window
+	/// </summary>
+	/// <returns>checksum</returns>
+	uint32_t digest() const;
+};
@@ -1,8 +1,12 @@
 #include "SocketHandler.h"
 
 
-SocketHandler::SocketHandler() : sock(io_context) {
+SocketHandler::SocketHandler() : sock(io_context), readBuffer(READ_BUFFER_SIZE) {
 	this->connected = false;
+	this->readStart = 0;
+	this->readCount = 0;
+	this->connectTimeout = std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+	this->ioTimeout = std::chrono::milliseconds(IO_TIMEOUT_MS);
 }
 
 SocketHandler::~SocketHandler() {
@@ -15,29 +19,34 @@ SocketHandler::~SocketHandler() {
 /// </summary>
 bool SocketHandler::load_host_port() {
 
+	StartupProfiler::Step step("load_server_address");
 	bool isSuccessful = false;
 
 	try {
 		std::string ip;
 		// reading line of ip address - host and port
 		if (!fileHandler.readLine(SERVER_FILE_PATH, IP_ADDRESS, ip)) {
-			std::cout << "Error in loading ip address." << std::endl;
+			Logger::error("Error in loading ip address");
 		}
 
-		// splitting the address to host part according to the symbol ':'
-		// and checking validity
-		std::string host = ip.substr(0, ip.find(":"));
-		boost::system::error_code ec;
-		boost::asio::ip::address::from_string(host, ec);
-		if (ec)
-			this->host = DEFAULT_HOST;
-		else
+		// stripping white spaces (and a windows carriage return) from the end of the line
+		ip.erase(ip.find_last_not_of(" \t\r") + 1);
+
+		// splitting the address to host part according to the last symbol ':' - an ipv6 address is written
+		// in brackets, since it has ':' inside it - and checking validity
+		size_t separator = ip.rfind(":");
+		std::string host = ip.substr(0, separator);
+		if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+			host = host.substr(1, host.size() - 2);
+		if (isValidHost(host))
 			this->host = host;
+		else
+			this->host = DEFAULT_HOST;
 
 		// splitting the address to port according to the symbol ':'
 		// and checking validity
-		std::string port = ip.substr(ip.find(":") + 1, ip.length() - 1);
-		if (isNumeric(port) && stoi(port) >= 0 || stoi(port) <= MAX_PORT_VALUE)
+		std::string port = separator == std::string::npos ? "" : ip.substr(separator + 1);
+		if (isNumeric(port) && stoi(port) <= MAX_PORT_VALUE)
 			this->port = port;
 		else
 			this->port = DEFAULT_PORT;
@@ -50,7 +59,7 @@ bool SocketHandler::load_host_port() {
 		// in case of and exception - determining default values of host and port 
 		this->host = DEFAULT_HOST;
 		this->port = DEFAULT_PORT;
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -76,28 +85,76 @@ bool SocketHandler::isNumeric(std::string const& str)
 	return !str.empty() && it == str.end();
 }
 
+/// <summary>
+/// Returns true if the string is a literal address or a valid host name, false otherwise
+/// </summary>
+/// <param name="str"></param>
+/// <returns></returns>
+bool SocketHandler::isValidHost(std::string const& str)
+{
+	boost::system::error_code ec;
+	boost::asio::ip::make_address(str, ec);
+	if (!ec)
+		return true;
+
+	// a host name is made of letters, digits, '-' and '.'
+	if (str.empty() || str.length() > MAX_HOST_NAME_LENGTH)
+		return false;
+
+	return std::all_of(str.begin(), str.end(), [](char c) {
+		return std::isalnum((unsigned char)c) || c == '-' || c == '.';
+	});
+}
+
 /// <summary>
 /// Connects to server
 /// </summary>
 bool SocketHandler::connectToServer() {
+
+	TraceRecorder::Span span("connect", "session");
+	StartupProfiler::Step step("connect");
+	auto start = std::chrono::steady_clock::now();
+
 	try
 	{
 
 		if (!this->load_host_port()) {
-			std::cout << "Error in loading host and port details" << std::endl << std::endl;
+			Logger::error("Error in loading host and port details");
 			return false;
 		}
 
-		tcp::resolver resolver(this->io_context);
-		boost::asio::connect(this->sock, resolver.resolve(this->host, this->port));
+		std::vector<tcp::endpoint> endpoints;
+		bool isResolved = false;
+		{
+			StartupProfiler::Step resolveStep("resolve");
+			isResolved = HostResolver::resolve(this->io_context, this->host, this->port, this->connectTimeout, endpoints);
+		}
+		if (!isResolved) {
+			ClientMetrics::recordConnect(std::chrono::steady_clock::now() - start, false);
+			return false;
+		}
 
-		std::cout << "Connecting to Server" << std::endl << std::endl;
+		span.addArg("host", this->host + ":" + this->port);
+
+		// the addresses may be stale - resolving again on the next connection
+		if (!this->connectEndpoints(endpoints)) {
+			HostResolver::invalidate(this->host, this->port);
+			Logger::error("Cannot connect to server", { { "host", this->host }, { "port", this->port } });
+			ClientMetrics::recordConnect(std::chrono::steady_clock::now() - start, false);
+			return false;
+		}
+		ClientMetrics::recordConnect(std::chrono::steady_clock::now() - start, true);
+
+		this->readStart = 0;
+		this->readCount = 0;
+
+		Logger::info("Connected to server", { { "host", this->host }, { "port", this->port } });
 		this->connected = true;
 		return true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		this->sock.close();
 		return false;
 	}
@@ -115,12 +172,12 @@ bool SocketHandler::send(char* buffer, size_t size) {
 	bool isSuccessful = false;
 
 	try {
-		this->sock.write_some(boost::asio::buffer(buffer, size));
+		this->write(buffer, size);
 		isSuccessful = true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -128,22 +185,22 @@ bool SocketHandler::send(char* buffer, size_t size) {
 }
 
 /// <summary>
-/// Sends string buffer stream on the socket
+/// Sends string buffer stream on the socket - the buffer is sent in place, without copying it
 /// </summary>
 /// <param name="buffer"></param>
 /// <param name="size"></param>
 /// <returns></returns>
-bool SocketHandler::send(std::string buffer, size_t size) {
+bool SocketHandler::send(std::string_view buffer, size_t size) {
 
 	bool isSuccessful = false;
 
 	try {
-		this->sock.write_some(boost::asio::buffer(buffer, size));
+		this->write(buffer.data(), std::min(size, buffer.size()));
 		isSuccessful = true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -162,15 +219,34 @@ bool SocketHandler::receive(char* buffer, size_t size) {
 	bool isSuccessful = false;
 
 	try {
-		size_t reply_length = this->sock.read_some(boost::asio::buffer(buffer, size));
-		if (reply_length == 0)
-			isSuccessful = false;
-		else
-			isSuccessful = true;
+		if (size <= READ_BUFFER_SIZE) {
+
+			// serving the bytes from the read buffer, receiving from the socket only if they are not there yet
+			isSuccessful = this->fill(size) && this->peek(buffer, size);
+			if (isSuccessful)
+				this->consume(size);
+		}
+		else {
+
+			// a large buffer takes what's already buffered and the rest is received directly into it
+			size_t fromBuffer = this->readCount;
+			this->peek(buffer, fromBuffer);
+			this->consume(fromBuffer);
+
+			TraceRecorder::Span span("socket_read", "socket");
+			size_t reply_length = this->runCounted(this->receiveCounter, size - fromBuffer,
+				[this, buffer, fromBuffer, size](auto condition, auto handler) {
+					boost::asio::async_read(this->sock, boost::asio::buffer(buffer + fromBuffer, size - fromBuffer), condition,
+						handler);
+				});
+			span.addArg("bytes", reply_length);
+			ClientMetrics::addBytesReceived(reply_length);
+			isSuccessful = reply_length == size - fromBuffer;
+		}
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -185,18 +261,70 @@ bool SocketHandler::receive(char* buffer, size_t size) {
 /// <returns></returns>
 bool SocketHandler::receive(std::string& buffer, size_t size) {
 
+	if (buffer.size() < size)
+		buffer.resize(size);
+
+	return this->receive(&buffer[0], size);
+}
+
+/// <summary>
+/// Receives unsigned char* buffer stream on the socket
+/// </summary>
+/// <param name="buffer"></param>
+/// <param name="size"></param>
+/// <returns></returns>
+bool SocketHandler::receive(unsigned char* buffer, size_t size) {
+	return this->receive(reinterpret_cast<char*>(buffer), size);
+}
+
+/// <summary>
+/// Receives from the socket until at least size bytes are in the read buffer.
+/// Every receive pulls as much as the socket has available, so several frames are read at once
+/// </summary>
+/// <param name="size">must not exceed READ_BUFFER_SIZE</param>
+/// <returns></returns>
+bool SocketHandler::fill(size_t size) {
+
 	bool isSuccessful = false;
 
 	try {
-		size_t reply_length = this->sock.read_some(boost::asio::buffer(buffer, size));
-		if (reply_length == 0)
-			isSuccessful = false;
-		else
-			isSuccessful = true;
+		if (size > READ_BUFFER_SIZE)
+			return false;
+
+		while (this->readCount < size) {
+
+			// the free space of the ring may wrap around its end - receiving into both parts at once
+			size_t capacity = this->readBuffer.size();
+			size_t writeStart = (this->readStart + this->readCount) % capacity;
+			size_t freeSpace = capacity - this->readCount;
+			size_t firstPart = std::min(freeSpace, capacity - writeStart);
+
+			std::array<boost::asio::mutable_buffer, 2> freeBuffers = {
+				boost::asio::buffer(&this->readBuffer[writeStart], firstPart),
+				boost::asio::buffer(&this->readBuffer[0], freeSpace - firstPart)
+			};
+
+			TraceRecorder::Span span("socket_read", "socket");
+			size_t reply_length = this->runWithDeadline([this, &freeBuffers](auto handler) {
+				this->sock.async_read_some(freeBuffers, handler);
+			});
+			span.addArg("bytes", reply_length);
+
+			// a call which brings less than the frame needs is short - another call follows it
+			this->receiveCounter.record(size - this->readCount, reply_length);
+			if (reply_length == 0)
+				return false;
+
+			ClientMetrics::addBytesReceived(reply_length);
+
+			this->readCount += reply_length;
+		}
+
+		isSuccessful = true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -204,27 +332,246 @@ bool SocketHandler::receive(std::string& buffer, size_t size) {
 }
 
 /// <summary>
-/// Receives unsigned char* buffer stream on the socket
+/// Copies bytes from the read buffer without consuming them
 /// </summary>
 /// <param name="buffer"></param>
 /// <param name="size"></param>
+/// <returns>false if less than size bytes are buffered</returns>
+bool SocketHandler::peek(char* buffer, size_t size) {
+
+	if (size > this->readCount)
+		return false;
+
+	// the bytes may wrap around the end of the ring
+	size_t capacity = this->readBuffer.size();
+	size_t firstPart = std::min(size, capacity - this->readStart);
+
+	memcpy(buffer, &this->readBuffer[this->readStart], firstPart);
+	memcpy(buffer + firstPart, &this->readBuffer[0], size - firstPart);
+	if (size > 0)
+		this->copyCounter.record(size, size);
+
+	return true;
+}
+
+/// <summary>
+/// Removes bytes from the beginning of the read buffer
+/// </summary>
+/// <param name="size"></param>
+void SocketHandler::consume(size_t size) {
+
+	size = std::min(size, this->readCount);
+
+	this->readStart = (this->readStart + size) % this->readBuffer.size();
+	this->readCount -= size;
+
+	// starting over from the beginning of the ring keeps the next receive in one part
+	if (this->readCount == 0)
+		this->readStart = 0;
+}
+
+/// <summary>
+/// Returns number of received bytes which are not consumed yet
+/// </summary>
 /// <returns></returns>
-bool SocketHandler::receive(unsigned char* buffer, size_t size) {
+size_t SocketHandler::buffered() {
+	return this->readCount;
+}
 
-	bool isSuccessful = false;
+/// <summary>
+/// Returns whether bytes can be received without blocking - buffered or waiting on the socket
+/// </summary>
+/// <returns></returns>
+bool SocketHandler::hasPendingData() {
+	boost::system::error_code error;
+	return this->readCount > 0 || this->sock.available(error) > 0 || error;
+}
 
-	try {
-		size_t reply_length = this->sock.read_some(boost::asio::buffer(buffer, size));
-		if (reply_length == 0)
-			isSuccessful = false;
-		else
-			isSuccessful = true;
+/// <summary>
+/// Writes a buffer on the socket - in slices paced by the rate limiters, if any of them has a rate
+/// </summary>
+/// <param name="data"></param>
+/// <param name="size"></param>
+void SocketHandler::write(const char* data, size_t size) {
+
+	StartupProfiler::recordFirstByte();
+
+	RateLimiter& global = globalLimiter();
+	if (!this->sessionLimiter.isLimited() && !global.isLimited()) {
+		TraceRecorder::Span span("socket_write", "socket");
+		span.addArg("bytes", size);
+		this->runCounted(this->sendCounter, size, [this, data, size](auto condition, auto handler) {
+			boost::asio::async_write(this->sock, boost::asio::buffer(data, size), condition, handler);
+		});
+		ClientMetrics::addBytesSent(size);
+		return;
 	}
-	catch (std::exception& e)
-	{
-		std::cerr << "Exception: " << e.what() << std::endl;
-		isSuccessful = false;
+
+	// pacing small slices, so a large file is spread evenly over time instead of leaving in bursts
+	for (size_t offset = 0; offset < size; offset += SEND_SLICE_SIZE) {
+		size_t slice = std::min(SEND_SLICE_SIZE, size - offset);
+		global.acquire(slice);
+		this->sessionLimiter.acquire(slice);
+		TraceRecorder::Span span("socket_write", "socket");
+		span.addArg("bytes", slice);
+		this->runCounted(this->sendCounter, slice, [this, data, offset, slice](auto condition, auto handler) {
+			boost::asio::async_write(this->sock, boost::asio::buffer(data + offset, slice), condition, handler);
+		});
+		ClientMetrics::addBytesSent(slice);
 	}
+}
 
-	return isSuccessful;
-}
\ No newline at end of file
+/// <summary>
+/// Returns the limiter shared by all the connections of the process
+/// </summary>
+/// <returns></returns>
+RateLimiter& SocketHandler::globalLimiter() {
+	static RateLimiter limiter;
+	return limiter;
+}
+
+/// <summary>
+/// Limits the bytes sent on this connection
+/// </summary>
+/// <param name="bytesPerSecond">0 removes the limit</param>
+/// <param name="burstBytes"></param>
+/// <param name="adaptive">whether the rate backs off when the round trip time grows</param>
+void SocketHandler::setRateLimit(size_t bytesPerSecond, size_t burstBytes, bool adaptive) {
+	this->sessionLimiter.configure(bytesPerSecond, burstBytes, adaptive);
+}
+
+/// <summary>
+/// Limits the bytes sent on all the connections of the process together
+/// </summary>
+/// <param name="bytesPerSecond">0 removes the limit</param>
+/// <param name="burstBytes"></param>
+/// <param name="adaptive">whether the rate backs off when the round trip time grows</param>
+void SocketHandler::setGlobalRateLimit(size_t bytesPerSecond, size_t burstBytes, bool adaptive) {
+	globalLimiter().configure(bytesPerSecond, burstBytes, adaptive);
+}
+
+/// <summary>
+/// Reports the time from sending a request until its response arrived, for adaptive rate limits
+/// </summary>
+/// <param name="rtt"></param>
+void SocketHandler::onRoundTrip(std::chrono::microseconds rtt) {
+	this->sessionLimiter.onRoundTrip(rtt);
+	globalLimiter().onRoundTrip(rtt);
+}
+
+/// <summary>
+/// Returns the rate this connection may send at right now in bytes per second, 0 if it is not limited
+/// </summary>
+/// <returns></returns>
+size_t SocketHandler::getSendRate() {
+
+	size_t rate = 0;
+	for (RateLimiter* limiter : { &this->sessionLimiter, &globalLimiter() }) {
+		if (limiter->isLimited())
+			rate = rate == 0 ? limiter->getRate() : std::min(rate, limiter->getRate());
+	}
+
+	return rate;
+}
+
+/// <summary>
+/// Returns the counts of send calls on the socket
+/// </summary>
+/// <returns></returns>
+const IoCounter& SocketHandler::getSendCounter() {
+	return this->sendCounter;
+}
+
+/// <summary>
+/// Returns the counts of receive calls on the socket
+/// </summary>
+/// <returns></returns>
+const IoCounter& SocketHandler::getReceiveCounter() {
+	return this->receiveCounter;
+}
+
+/// <summary>
+/// Returns the counts of copies of received bytes out of the read buffer
+/// </summary>
+/// <returns></returns>
+const IoCounter& SocketHandler::getCopyCounter() {
+	return this->copyCounter;
+}
+
+/// <summary>
+/// Sets the deadline of connecting, and the time a read or write may go without moving a byte
+/// </summary>
+/// <param name="connectTimeoutMs"></param>
+/// <param name="ioTimeoutMs"></param>
+void SocketHandler::setTimeouts(size_t connectTimeoutMs, size_t ioTimeoutMs) {
+	this->connectTimeout = std::chrono::milliseconds(connectTimeoutMs);
+	this->ioTimeout = std::chrono::milliseconds(ioTimeoutMs);
+}
+
+/// <summary>
+/// Races connections to the endpoints - a new attempt starts every CONNECTION_ATTEMPT_DELAY_MS, or as soon as
+/// the previous one fails, and the first one to connect wins
+/// </summary>
+/// <param name="endpoints">ordered by HostResolver, alternating address families</param>
+/// <returns>false if no endpoint connected before the connect timeout</returns>
+bool SocketHandler::connectEndpoints(const std::vector<tcp::endpoint>& endpoints) {
+
+	std::vector<std::unique_ptr<tcp::socket>> attempts;
+	boost::asio::steady_timer attemptTimer(this->io_context);
+	size_t nextEndpoint = 0;
+	size_t failedAttempts = 0;
+	size_t winner = 0;
+	bool isConnected = false;
+	bool isDone = false;
+
+	std::function<void()> startNextAttempt = [&]() {
+		if (isDone || isConnected || nextEndpoint >= endpoints.size())
+			return;
+
+		size_t attempt = attempts.size();
+		attempts.push_back(std::make_unique<tcp::socket>(this->io_context));
+		attempts[attempt]->async_connect(endpoints[nextEndpoint++], [&, attempt](const boost::system::error_code& error) {
+			if (isDone || isConnected || error == boost::asio::error::operation_aborted)
+				return;
+
+			if (!error) {
+				isConnected = true;
+				winner = attempt;
+				return;
+			}
+
+			// a failed attempt doesn't wait for the delay - the next address is tried right away
+			failedAttempts++;
+			startNextAttempt();
+		});
+
+		attemptTimer.expires_after(std::chrono::milliseconds(CONNECTION_ATTEMPT_DELAY_MS));
+		attemptTimer.async_wait([&](const boost::system::error_code& error) {
+			if (!error)
+				startNextAttempt();
+		});
+	};
+
+	startNextAttempt();
+
+	auto deadline = std::chrono::steady_clock::now() + this->connectTimeout;
+	this->io_context.restart();
+	while (!isConnected && failedAttempts < endpoints.size() && this->io_context.run_one_until(deadline) > 0);
+
+	// closing the attempts that lost the race, and letting their handlers run before leaving
+	isDone = true;
+	attemptTimer.cancel();
+	for (size_t attempt = 0; attempt < attempts.size(); attempt++) {
+		if (!isConnected || attempt != winner)
+			attempts[attempt]->close();
+	}
+	this->io_context.restart();
+	this->io_context.run();
+
+	if (!isConnected)
+		return false;
+
+	this->sock.close();
+	this->sock = std::move(*attempts[winner]);
+	return true;
+}
@@ -15,6 +15,15 @@
 #include <boost/crc.hpp>
 #include <algorithm>
 #include "FileHandler.h"
+#include "RateLimiter.h"
+#include "HostResolver.h"
+#include "TraceRecorder.h"
+#include "ClientMetrics.h"
+#include "Logger.h"
+#include "IoCounter.h"
+#include "StartupProfiler.h"
+#include <memory>
+#include <functional>
 
 using boost::asio::ip::tcp;
 
@@ -23,6 +32,13 @@ const size_t IP_ADDRESS = 1;
 const std::string DEFAULT_HOST = "127.0.0.1";
 const std::string DEFAULT_PORT = "1234";
 const int MAX_PORT_VALUE = 65535;
+const size_t READ_BUFFER_SIZE = 64 * 1024;
+const size_t SEND_SLICE_SIZE = 16 * 1024;
+const size_t CONNECT_TIMEOUT_MS = 10000;
+const size_t IO_TIMEOUT_MS = 120000;
+const size_t CONNECTION_ATTEMPT_DELAY_MS = 250;
+const size_t MAX_HOST_NAME_LENGTH = 253;
+const size_t SOCKET_CALL_MAX_BYTES = 64 * 1024;	// bytes asked for in a single call of a whole read or write
 
 class SocketHandler {
 
@@ -37,9 +53,125 @@ private:
 	std::string port;
 	FileHandler fileHandler;
 
+	// ring buffer of bytes received from the socket and not yet consumed
+	std::vector<char> readBuffer;
+	size_t readStart;
+	size_t readCount;
+
+	// shapes the bytes sent on this connection
+	RateLimiter sessionLimiter;
+
+	// deadline of connecting, and the time a read or write may go without moving a byte
+	std::chrono::milliseconds connectTimeout;
+	std::chrono::milliseconds ioTimeout;
+	std::chrono::steady_clock::time_point lastProgress;
+
+	// calls on the socket, and copies out of the read buffer
+	IoCounter sendCounter;
+	IoCounter receiveCounter;
+	IoCounter copyCounter;
+
 	// method
 	bool load_host_port();
 	bool isNumeric(std::string const& str);
+	bool isValidHost(std::string const& str);
+
+	/// <summary>
+	/// Races connections to the endpoints - a new attempt starts every CONNECTION_ATTEMPT_DELAY_MS, or as soon as
+	/// the previous one fails, and the first one to connect wins
+	/// </summary>
+	/// <param name="endpoints">ordered by HostResolver, alternating address families</param>
+	/// <returns>false if no endpoint connected before the connect timeout</returns>
+	bool connectEndpoints(const std::vector<tcp::endpoint>& endpoints);
+
+	/// <summary>
+	/// Runs an asynchronous operation on the socket until it completes, closing the socket if the
+	/// io timeout passes without the operation moving a byte
+	/// </summary>
+	/// <param name="operation">starts the operation with the completion handler it is given</param>
+	/// <returns>bytes transferred by the operation</returns>
+	template <typename Operation>
+	size_t runWithDeadline(Operation operation) {
+
+		boost::system::error_code result = boost::asio::error::would_block;
+		size_t transferred = 0;
+		operation([&result, &transferred](const boost::system::error_code& error, size_t length) {
+			result = error;
+			transferred = length;
+		});
+
+		// the deadline is of inactivity - every call which moves bytes (seen by the completion condition of a whole
+		// read or write) moves it on, so a large write at a low rate doesn't time out while it keeps moving
+		this->lastProgress = std::chrono::steady_clock::now();
+		this->io_context.restart();
+		while (result == boost::asio::error::would_block) {
+			auto deadline = this->lastProgress + this->ioTimeout;
+			if (std::chrono::steady_clock::now() >= deadline)
+				break;
+			if (this->io_context.stopped())
+				this->io_context.restart();
+			this->io_context.run_until(deadline);
+		}
+
+		// the peer is not responding - the connection is given up, and the handler runs before leaving
+		if (result == boost::asio::error::would_block) {
+			this->sock.close();
+			this->connected = false;
+			this->io_context.restart();
+			this->io_context.run();
+			throw boost::system::system_error(boost::asio::error::timed_out);
+		}
+
+		if (result)
+			throw boost::system::system_error(result);
+
+		return transferred;
+	}
+
+	/// <summary>
+	/// Runs a whole read or write like runWithDeadline, counting every call it makes on the socket.
+	/// Its completion condition asks for at most SOCKET_CALL_MAX_BYTES in a call, and sees every call but the last,
+	/// which is counted once the read or write completed
+	/// </summary>
+	/// <param name="counter"></param>
+	/// <param name="size">bytes of the whole read or write</param>
+	/// <param name="operation">starts the read or write with the completion condition and handler it is given</param>
+	/// <returns>bytes transferred</returns>
+	template <typename Operation>
+	size_t runCounted(IoCounter& counter, size_t size, Operation operation) {
+
+		size_t previous = 0;
+		auto condition = [this, &counter, size, &previous](const boost::system::error_code& error, size_t transferred) {
+			if (transferred > previous)
+				this->lastProgress = std::chrono::steady_clock::now();
+			if (transferred > previous || error) {
+				counter.record(std::min(size - previous, SOCKET_CALL_MAX_BYTES), transferred - previous);
+				previous = transferred;
+			}
+			return (error || transferred >= size) ? (size_t)0 : SOCKET_CALL_MAX_BYTES;
+		};
+
+		size_t transferred = this->runWithDeadline([&operation, &condition](auto handler) {
+			operation(condition, handler);
+		});
+		if (transferred > previous)
+			counter.record(std::min(size - previous, SOCKET_CALL_MAX_BYTES), transferred - previous);
+
+		return transferred;
+	}
+
+	/// <summary>
+	/// Writes a buffer on the socket - in slices paced by the rate limiters, if any of them has a rate
+	/// </summary>
+	/// <param name="data"></param>
+	/// <param name="size"></param>
+	void write(const char* data, size_t size);
+
+	/// <summary>
+	/// Returns the limiter shared by all the connections of the process
+	/// </summary>
+	/// <returns></returns>
+	static RateLimiter& globalLimiter();
 	
 public:
 
@@ -51,6 +183,13 @@ public:
 	/// </summary>
 	bool connectToServer();
 
+	/// <summary>
+	/// Sets the deadline of connecting, and the time a read or write may go without moving a byte
+	/// </summary>
+	/// <param name="connectTimeoutMs"></param>
+	/// <param name="ioTimeoutMs"></param>
+	void setTimeouts(size_t connectTimeoutMs, size_t ioTimeoutMs);
+
 	/// <summary>
 	/// Sends char* buffer stream on the socket
 	/// </summary>
@@ -60,12 +199,12 @@ public:
 	bool send(char* buffer, size_t size);
 
 	/// <summary>
-	/// Sends string buffer stream on the socket
+	/// Sends string buffer stream on the socket - the buffer is sent in place, without copying it
 	/// </summary>
 	/// <param name="buffer"></param>
 	/// <param name="size"></param>
 	/// <returns></returns>
-	bool send(std::string buffer, size_t size);
+	bool send(std::string_view buffer, size_t size);
 
 	/// <summary>
 	/// Receives char* buffer stream on the socket
@@ -91,4 +230,84 @@ public:
 	/// <returns></returns>
 	bool receive(unsigned char* buffer, size_t size);
 
+	/// <summary>
+	/// Receives from the socket until at least size bytes are in the read buffer.
+	/// Every receive pulls as much as the socket has available, so several frames are read at once
+	/// </summary>
+	/// <param name="size">must not exceed READ_BUFFER_SIZE</param>
+	/// <returns></returns>
+	bool fill(size_t size);
+
+	/// <summary>
+	/// Copies bytes from the read buffer without consuming them
+	/// </summary>
+	/// <param name="buffer"></param>
+	/// <param name="size"></param>
+	/// <returns>false if less than size bytes are buffered</returns>
+	bool peek(char* buffer, size_t size);
+
+	/// <summary>
+	/// Removes bytes from the beginning of the read buffer
+	/// </summary>
+	/// <param name="size"></param>
+	void consume(size_t size);
+
+	/// <summary>
+	/// Returns number of received bytes which are not consumed yet
+	/// </summary>
+	/// <returns></returns>
+	size_t buffered();
+
+	/// <summary>
+	/// Returns whether bytes can be received without blocking - buffered or waiting on the socket
+	/// </summary>
+	/// <returns></returns>
+	bool hasPendingData();
+
+	/// <summary>
+	/// Limits the bytes sent on this connection
+	/// </summary>
+	/// <param name="bytesPerSecond">0 removes the limit</param>
+	/// <param name="burstBytes"></param>
+	/// <param name="adaptive">whether the rate backs off when the round trip time grows</param>
+	void setRateLimit(size_t bytesPerSecond, size_t burstBytes, bool adaptive);
+
+	/// <summary>
+	/// Limits the bytes sent on all the connections of the process together
+	/// </summary>
+	/// <param name="bytesPerSecond">0 removes the limit</param>
+	/// <param name="burstBytes"></param>
+	/// <param name="adaptive">whether the rate backs off when the round trip time grows</param>
+	static void setGlobalRateLimit(size_t bytesPerSecond, size_t burstBytes, bool adaptive);
+
+	/// <summary>
+	/// Reports the time from sending a request until its response arrived, for adaptive rate limits
+	/// </summary>
+	/// <param name="rtt"></param>
+	void onRoundTrip(std::chrono::microseconds rtt);
+
+	/// <summary>
+	/// Returns the rate this connection may send at right now in bytes per second, 0 if it is not limited
+	/// </summary>
+	/// <returns></returns>
+	size_t getSendRate();
+
+	/// <summary>
+	/// Returns the counts of send calls on the socket
+	/// </summary>
+	/// <returns></returns>
+	const IoCounter& getSendCounter();
+
+	/// <summary>
+	/// Returns the counts of receive calls on the socket
+	/// </summary>
+	/// <returns></returns>
+	const IoCounter& getReceiveCounter();
+
+	/// <summary>
+	/// Returns the counts of copies of received bytes out of the read buffer
+	/// </summary>
+	/// <returns></returns>
+	const IoCounter& getCopyCounter();
+
 };
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "StartupProfiler.h"
+#include <algorithm>
+
+std::atomic<bool> StartupProfiler::enabled(false);
+std::string StartupProfiler::reportPath;
+std::chrono::steady_clock::time_point StartupProfiler::processStart = std::chrono::steady_clock::now();
+std::mutex StartupProfiler::mutex;
+std::vector<StartupProfiler::StepRecord> StartupProfiler::steps;
+std::atomic<bool> StartupProfiler::hasFirstByte(false);
+std::chrono::steady_clock::time_point StartupProfiler::firstByte;
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="name"></param>
+StartupProfiler::Step::Step(const char* name) {
+	this->name = name;
+
+	// reading the clock only while profiling, so a disabled step costs a load
+	this->isTimed = StartupProfiler::isEnabled();
+	if (this->isTimed)
+		this->start = std::chrono::steady_clock::now();
+}
+
+/// <summary>
+/// Dtor
+/// </summary>
+StartupProfiler::Step::~Step() {
+
+	if (this->isTimed)
+		StartupProfiler::record(this->name, this->start, std::chrono::steady_clock::now());
+}
+
+/// <summary>
+/// Starts timing startup steps, to write them to a path (or to standard output if the path is "-") at stop.
+/// Steps are timed from the static initialization of the process, so options parsed before start are counted
+/// </summary>
+/// <param name="path"></param>
+void StartupProfiler::start(const std::string& path) {
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (enabled.exchange(true))
+		return;
+
+	reportPath = path;
+	steps.clear();
+	hasFirstByte = false;
+}
+
+/// <summary>
+/// Stops timing startup steps and writes the report
+/// </summary>
+void StartupProfiler::stop() {
+
+	if (!enabled.exchange(false))
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// the report is written to the console directly - after the records logged before it
+	if (reportPath == "-") {
+		Logger::flush();
+		std::cout << std::endl << "Startup profile:" << std::endl;
+		writeReport(std::cout);
+		return;
+	}
+
+	std::ofstream out(reportPath, std::ofstream::trunc);
+	if (!out.is_open()) {
+		Logger::error("Cannot write startup profile", { { "path", reportPath } });
+		return;
+	}
+	writeReport(out);
+}
+
+/// <summary>
+/// Returns true if startup steps are timed
+/// </summary>
+/// <returns></returns>
+bool StartupProfiler::isEnabled() {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Records a step
+/// </summary>
+/// <param name="name"></param>
+/// <param name="start"></param>
+/// <param name="end"></param>
+void StartupProfiler::record(const char* name, std::chrono::steady_clock::time_point start,
+	std::chrono::steady_clock::time_point end) {
+
+	if (!isEnabled())
+		return;
+
+	// steps may run on other threads - the key pair is generated while connecting in lazy mode
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto step = std::find_if(steps.begin(), steps.end(), [name](const StepRecord& record) { return record.name == name; });
+	if (step == steps.end()) {
+		steps.push_back({ name, start, end - start, 1 });
+		return;
+	}
+
+	step->firstStart = std::min(step->firstStart, start);
+	step->total += end - start;
+	step->count++;
+}
+
+/// <summary>
+/// Marks that the first byte of the process is written on a socket - only the first call counts
+/// </summary>
+void StartupProfiler::recordFirstByte() {
+
+	// every write of the process passes here - after the first one it costs two loads
+	if (!isEnabled() || hasFirstByte.load(std::memory_order_relaxed))
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (hasFirstByte)
+		return;
+
+	firstByte = std::chrono::steady_clock::now();
+	hasFirstByte = true;
+}
+
+/// <summary>
+/// Writes start, time and count of every step in the order the steps started, and the time to the first byte
+/// </summary>
+/// <param name="out"></param>
+void StartupProfiler::writeReport(std::ostream& out) {
+
+	auto toMs = [](std::chrono::steady_clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	};
+
+	std::vector<StepRecord> ordered = steps;
+	std::stable_sort(ordered.begin(), ordered.end(),
+		[](const StepRecord& a, const StepRecord& b) { return a.firstStart < b.firstStart; });
+
+	// steps are nested (connect reads the server file), so their times overlap rather than add up
+	out << std::left << std::setw(20) << "step" << std::right << std::setw(12) << "start ms" << std::setw(12)
+		<< "time ms" << std::setw(8) << "count" << std::endl;
+	out << std::fixed << std::setprecision(3);
+
+	bool isFirstByteWritten = false;
+	for (const StepRecord& step : ordered) {
+		if (hasFirstByte && !isFirstByteWritten && firstByte < step.firstStart) {
+			out << std::left << std::setw(20) << "first_byte" << std::right << std::setw(12)
+				<< toMs(firstByte - processStart) << std::endl;
+			isFirstByteWritten = true;
+		}
+		out << std::left << std::setw(20) << step.name << std::right << std::setw(12)
+			<< toMs(step.firstStart - processStart) << std::setw(12) << toMs(step.total) << std::setw(8) << step.count
+			<< std::endl;
+	}
+	if (hasFirstByte && !isFirstByteWritten)
+		out << std::left << std::setw(20) << "first_byte" << std::right << std::setw(12)
+			<< toMs(firstByte - processStart) << std::endl;
+
+	if (hasFirstByte)
+		out << "Time to first byte: " << toMs(firstByte - processStart) << " ms" << std::endl;
+	else
+		out << "No byte was written" << std::endl;
+	out << std::defaultfloat;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include "Logger.h"
+
+/// <summary>
+/// Times the steps a client takes from the start of the process until its first byte is on the wire -
+/// reading options and config files, connecting, registering and generating keys - and writes them as a report at stop
+/// </summary>
+class StartupProfiler {
+
+private:
+	/// <summary>
+	/// Time of a step - a step taken more than once (a config file read again, or a reconnection) adds up
+	/// </summary>
+	struct StepRecord {
+		std::string name;
+		std::chrono::steady_clock::time_point firstStart;
+		std::chrono::steady_clock::duration total;
+		size_t count;
+	};
+
+	// members
+	static std::atomic<bool> enabled;
+	static std::string reportPath;
+	static std::chrono::steady_clock::time_point processStart;
+	static std::mutex mutex;
+	static std::vector<StepRecord> steps;
+	static std::atomic<bool> hasFirstByte;
+	static std::chrono::steady_clock::time_point firstByte;
+
+public:
+	/// <summary>
+	/// Scope of a startup step - times the step from its construction to its destruction
+	/// </summary>
+	class Step {
+
+	private:
+		const char* name;
+		bool isTimed;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		/// <summary>
+		/// Ctor
+		/// </summary>
+		/// <param name="name"></param>
+		Step(const char* name);
+
+		/// <summary>
+		/// Dtor
+		/// </summary>
+		~Step();
+
+		Step(const Step&) = delete;
+		Step& operator=(const Step&) = delete;
+	};
+
+	/// <summary>
+	/// Starts timing startup steps, to write them to a path (or to standard output if the path is "-") at stop.
+	/// Steps are timed from the static initialization of the process, so options parsed before start are counted
+	/// </summary>
+	/// <param name="path"></param>
+	static void start(const std::string& path);
+
+	/// <summary>
+	/// Stops timing startup steps and writes the report
+	/// </summary>
+	static void stop();
+
+	/// <summary>
+	/// Returns true if startup steps are timed
+	/// </summary>
+	/// <returns></returns>
+	static bool isEnabled();
+
+	/// <summary>
+	/// Records a step
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="start"></param>
+	/// <param name="end"></param>
+	static void record(const char* name, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end);
+
+	/// <summary>
+	/// Marks that the first byte of the process is written on a socket - only the first call counts
+	/// </summary>
+	static void recordFirstByte();
+
+	/// <summary>
+	/// Writes start, time and count of every step in the order the steps started, and the time to the first byte
+	/// </summary>
+	/// <param name="out"></param>
+	static void writeReport(std::ostream& out);
+};
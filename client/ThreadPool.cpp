@@ -0,0 +1,144 @@
+#include "ThreadPool.h"
+#include <cstdint>
+
+// pool and index of the worker running on the current thread - a worker of one pool is outside of any other pool
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = SIZE_MAX;
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="threadCount"></param>
+ThreadPool::ThreadPool(size_t threadCount) {
+	this->nextQueue = 0;
+	this->queuedTasks = 0;
+	this->stopping = false;
+
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (size_t i = 0; i < threadCount; i++)
+		this->queues.push_back(std::make_unique<WorkerQueue>());
+
+	for (size_t i = 0; i < threadCount; i++)
+		this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+/// <summary>
+/// Dtor - runs the queued tasks and joins the workers
+/// </summary>
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(this->wakeMutex);
+		this->stopping = true;
+	}
+	this->wakeCondition.notify_all();
+
+	for (std::thread& worker : this->workers)
+		worker.join();
+}
+
+/// <summary>
+/// Returns number of workers
+/// </summary>
+/// <returns>number of workers</returns>
+size_t ThreadPool::size() const {
+	return this->workers.size();
+}
+
+/// <summary>
+/// Queues a task - on the queue of the submitting worker, or round robin if submitted from outside the pool
+/// </summary>
+/// <param name="task"></param>
+void ThreadPool::push(std::function<void()> task) {
+
+	bool isSpawned = currentPool == this;
+	size_t index = isSpawned ? currentWorker : this->nextQueue++ % this->queues.size();
+
+	{
+		std::lock_guard<std::mutex> lock(this->queues[index]->mutex);
+		if (isSpawned)
+			this->queues[index]->spawnedTasks.push_back(std::move(task));
+		else
+			this->queues[index]->tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->wakeMutex);
+		this->queuedTasks++;
+	}
+	this->wakeCondition.notify_one();
+}
+
+/// <summary>
+/// Takes the newest task spawned by a worker or else the oldest task submitted to it, or steals the oldest task
+/// of another worker
+/// </summary>
+/// <param name="index">index of the worker</param>
+/// <param name="task"></param>
+/// <returns>false if all the queues are empty</returns>
+bool ThreadPool::take(size_t index, std::function<void()>& task) {
+
+	{
+		WorkerQueue& own = *this->queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.spawnedTasks.empty()) {
+			task = std::move(own.spawnedTasks.back());
+			own.spawnedTasks.pop_back();
+			return true;
+		}
+
+		// submitted tasks keep their order - the files of a batch are sent in the order they were submitted,
+		// so the file the sender waits for next is prepared first
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.front());
+			own.tasks.pop_front();
+			return true;
+		}
+	}
+
+	// stealing from the other workers, starting from the next one so the victims are spread
+	for (size_t i = 1; i < this->queues.size(); i++) {
+		WorkerQueue& victim = *this->queues[(index + i) % this->queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		std::deque<std::function<void()>>& stolen = victim.tasks.empty() ? victim.spawnedTasks : victim.tasks;
+		if (!stolen.empty()) {
+			task = std::move(stolen.front());
+			stolen.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Runs tasks until the pool is stopped
+/// </summary>
+/// <param name="index">index of the worker</param>
+void ThreadPool::workerLoop(size_t index) {
+
+	currentPool = this;
+	currentWorker = index;
+
+	while (true) {
+		{
+			// sleeping until a task is queued, or until the pool is stopped and no task is left
+			std::unique_lock<std::mutex> lock(this->wakeMutex);
+			this->wakeCondition.wait(lock, [this]() { return this->queuedTasks > 0 || this->stopping; });
+			if (this->queuedTasks == 0 && this->stopping)
+				return;
+		}
+
+		std::function<void()> task;
+		if (!this->take(index, task))
+			continue;
+
+		{
+			std::lock_guard<std::mutex> lock(this->wakeMutex);
+			this->queuedTasks--;
+		}
+
+		task();
+	}
+}
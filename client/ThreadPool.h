@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class ThreadPool {
+
+private:
+	/// <summary>
+	/// Tasks of a single worker. Tasks submitted from outside the pool are taken oldest first, in the order they
+	/// were submitted - tasks spawned by the worker itself are taken newest first, while their data is in its cache.
+	/// Other workers steal the oldest tasks
+	/// </summary>
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+		std::deque<std::function<void()>> spawnedTasks;
+	};
+
+	// members
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<size_t> nextQueue;
+	std::atomic<size_t> queuedTasks;
+	std::atomic<bool> stopping;
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+
+	/// <summary>
+	/// Queues a task - on the queue of the submitting worker, or round robin if submitted from outside the pool
+	/// </summary>
+	/// <param name="task"></param>
+	void push(std::function<void()> task);
+
+	/// <summary>
+	/// Takes the newest task spawned by a worker or else the oldest task submitted to it, or steals the oldest task
+	/// of another worker
+	/// </summary>
+	/// <param name="index">index of the worker</param>
+	/// <param name="task"></param>
+	/// <returns>false if all the queues are empty</returns>
+	bool take(size_t index, std::function<void()>& task);
+
+	/// <summary>
+	/// Runs tasks until the pool is stopped
+	/// </summary>
+	/// <param name="index">index of the worker</param>
+	void workerLoop(size_t index);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	/// <param name="threadCount"></param>
+	ThreadPool(size_t threadCount);
+
+	/// <summary>
+	/// Dtor - runs the queued tasks and joins the workers
+	/// </summary>
+	~ThreadPool();
+
+	/// <summary>
+	/// Returns number of workers
+	/// </summary>
+	/// <returns>number of workers</returns>
+	size_t size() const;
+
+	/// <summary>
+	/// Submits a task to the pool
+	/// </summary>
+	/// <param name="function"></param>
+	/// <returns>future of the result of the task</returns>
+	template <typename Function>
+	auto submit(Function function) -> std::future<decltype(function())> {
+		using Result = decltype(function());
+
+		// the packaged task is move only, the queue holds copyable functions
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+		std::future<Result> result = task->get_future();
+		this->push([task]() { (*task)(); });
+		return result;
+	}
+};
@@ -0,0 +1,259 @@
+#include "TraceRecorder.h"
+#include <iomanip>
+
+std::atomic<bool> TraceRecorder::enabled(false);
+std::string TraceRecorder::tracePath;
+std::chrono::steady_clock::time_point TraceRecorder::origin;
+std::mutex TraceRecorder::eventsMutex;
+std::vector<TraceRecorder::TraceEvent> TraceRecorder::events;
+size_t TraceRecorder::droppedEvents = 0;
+std::atomic<uint32_t> TraceRecorder::nextThreadId(1);
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="name"></param>
+/// <param name="category"></param>
+TraceRecorder::Span::Span(const char* name, const char* category) {
+	this->category = category;
+
+	// nothing is allocated and the clock is not read unless tracing
+	this->isTraced = TraceRecorder::isEnabled();
+	if (this->isTraced) {
+		this->name = name;
+		this->start = std::chrono::steady_clock::now();
+	}
+}
+
+/// <summary>
+/// Dtor
+/// </summary>
+TraceRecorder::Span::~Span() {
+	if (this->isTraced)
+		TraceRecorder::recordComplete(this->name, this->category, this->start, std::chrono::steady_clock::now(), this->args);
+}
+
+/// <summary>
+/// Adds a number argument to the event
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+void TraceRecorder::Span::addArg(const char* key, uint64_t value) {
+	if (!this->isTraced)
+		return;
+	if (!this->args.empty())
+		this->args += ",";
+	this->args += TraceRecorder::arg(key, value);
+}
+
+/// <summary>
+/// Adds a string argument to the event
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+void TraceRecorder::Span::addArg(const char* key, const std::string& value) {
+	if (!this->isTraced)
+		return;
+	if (!this->args.empty())
+		this->args += ",";
+	this->args += TraceRecorder::arg(key, value);
+}
+
+/// <summary>
+/// Starts recording events, to be written to a path at stop
+/// </summary>
+/// <param name="path"></param>
+void TraceRecorder::start(const std::string& path) {
+
+	std::lock_guard<std::mutex> lock(eventsMutex);
+	tracePath = path;
+	origin = std::chrono::steady_clock::now();
+	events.clear();
+	events.reserve(RESERVED_TRACE_EVENTS);
+	droppedEvents = 0;
+	enabled = true;
+}
+
+/// <summary>
+/// Stops recording events and writes the trace file
+/// </summary>
+void TraceRecorder::stop() {
+
+	if (!enabled.exchange(false))
+		return;
+
+	std::ofstream out(tracePath, std::ofstream::trunc);
+	if (!out.is_open()) {
+		Logger::error("Cannot write trace", { { "path", tracePath } });
+		return;
+	}
+
+	write(out);
+
+	std::lock_guard<std::mutex> lock(eventsMutex);
+	Logger::info("Wrote trace", { { "events", events.size() }, { "path", tracePath } });
+	if (droppedEvents > 0)
+		Logger::warning("Trace events were dropped", { { "dropped", droppedEvents }, { "max_events", MAX_TRACE_EVENTS } });
+}
+
+/// <summary>
+/// Returns true if events are recorded
+/// </summary>
+/// <returns></returns>
+bool TraceRecorder::isEnabled() {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Records a complete event of the calling thread
+/// </summary>
+/// <param name="name"></param>
+/// <param name="category"></param>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <param name="args">json members of the arguments, without braces</param>
+void TraceRecorder::recordComplete(const std::string& name, const char* category, std::chrono::steady_clock::time_point start,
+	std::chrono::steady_clock::time_point end, const std::string& args) {
+
+	if (isEnabled())
+		add({ name, category, 'X', currentThreadId(), 0, start, end - start, args });
+}
+
+/// <summary>
+/// Records an event which may overlap other events of the calling thread - such as a request waiting for its response
+/// </summary>
+/// <param name="name"></param>
+/// <param name="category"></param>
+/// <param name="id">id which tells apart the events of the same name that overlap</param>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <param name="args">json members of the arguments, without braces</param>
+void TraceRecorder::recordAsync(const std::string& name, const char* category, uint64_t id,
+	std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, const std::string& args) {
+
+	if (!isEnabled())
+		return;
+
+	uint32_t threadId = currentThreadId();
+	add({ name, category, 'b', threadId, id, start, std::chrono::steady_clock::duration::zero(), args });
+	add({ name, category, 'e', threadId, id, end, std::chrono::steady_clock::duration::zero(), "" });
+}
+
+/// <summary>
+/// Records an instant event of the calling thread
+/// </summary>
+/// <param name="name"></param>
+/// <param name="category"></param>
+/// <param name="args">json members of the arguments, without braces</param>
+void TraceRecorder::recordInstant(const std::string& name, const char* category, const std::string& args) {
+
+	if (isEnabled())
+		add({ name, category, 'i', currentThreadId(), 0, std::chrono::steady_clock::now(),
+			std::chrono::steady_clock::duration::zero(), args });
+}
+
+/// <summary>
+/// Returns a json member of a string argument
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+/// <returns></returns>
+std::string TraceRecorder::arg(const char* key, const std::string& value) {
+	return "\"" + std::string(key) + "\":\"" + escape(value) + "\"";
+}
+
+/// <summary>
+/// Returns a json member of a number argument
+/// </summary>
+/// <param name="key"></param>
+/// <param name="value"></param>
+/// <returns></returns>
+std::string TraceRecorder::arg(const char* key, uint64_t value) {
+	return "\"" + std::string(key) + "\":" + std::to_string(value);
+}
+
+/// <summary>
+/// Writes the recorded events as a Chrome trace event json
+/// </summary>
+/// <param name="out"></param>
+void TraceRecorder::write(std::ostream& out) {
+
+	std::lock_guard<std::mutex> lock(eventsMutex);
+
+	// timestamps are microseconds since the trace started
+	auto microseconds = [](std::chrono::steady_clock::duration duration) {
+		return std::chrono::duration<double, std::micro>(duration).count();
+	};
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+
+	for (size_t i = 0; i < events.size(); i++) {
+		const TraceEvent& event = events[i];
+
+		out << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << event.category << "\",\"ph\":\"" << event.phase
+			<< "\",\"pid\":1,\"tid\":" << event.threadId << ",\"ts\":" << microseconds(event.start - origin);
+
+		if (event.phase == 'X')
+			out << ",\"dur\":" << microseconds(event.duration);
+		else if (event.phase == 'i')
+			out << ",\"s\":\"t\"";
+		else
+			out << ",\"id\":" << event.asyncId;
+
+		if (!event.args.empty())
+			out << ",\"args\":{" << event.args << "}";
+		out << "}" << (i + 1 < events.size() ? "," : "") << std::endl;
+	}
+
+	out << "]}" << std::endl;
+}
+
+/// <summary>
+/// Adds an event, unless the trace is full
+/// </summary>
+/// <param name="event"></param>
+void TraceRecorder::add(TraceEvent&& event) {
+
+	std::lock_guard<std::mutex> lock(eventsMutex);
+
+	// a long running client is not allowed to grow without a bound - the newest events are dropped
+	if (events.size() >= MAX_TRACE_EVENTS) {
+		droppedEvents++;
+		return;
+	}
+	events.push_back(std::move(event));
+}
+
+/// <summary>
+/// Returns a small id of the calling thread, given in the order threads first record
+/// </summary>
+/// <returns></returns>
+uint32_t TraceRecorder::currentThreadId() {
+	thread_local uint32_t threadId = nextThreadId++;
+	return threadId;
+}
+
+/// <summary>
+/// Escapes a string for json
+/// </summary>
+/// <param name="str"></param>
+/// <returns></returns>
+std::string TraceRecorder::escape(const std::string& str) {
+
+	std::string escaped;
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			escaped.push_back('\\');
+			escaped.push_back(c);
+		}
+		else if ((unsigned char)c < 0x20) {
+			char code[8];
+			snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+			escaped.append(code);
+		}
+		else
+			escaped.push_back(c);
+	}
+	return escaped;
+}
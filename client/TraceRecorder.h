@@ -0,0 +1,178 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include "Logger.h"
+
+const size_t RESERVED_TRACE_EVENTS = 64 * 1024;
+const size_t MAX_TRACE_EVENTS = 4 * 1024 * 1024;
+
+/// <summary>
+/// Records begin and end of the steps of a session, and writes them as a Chrome trace event file,
+/// which can be opened in Perfetto or chrome://tracing to see how the steps of every thread overlap
+/// </summary>
+class TraceRecorder {
+
+private:
+	/// <summary>
+	/// An event of the trace - a complete event (X) of a thread, an instant event (i), or the begin (b) or
+	/// end (e) of an asynchronous event which may overlap others of the same thread
+	/// </summary>
+	struct TraceEvent {
+		std::string name;
+		const char* category;
+		char phase;
+		uint32_t threadId;
+		uint64_t asyncId;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::duration duration;
+		std::string args;
+	};
+
+	// members
+	static std::atomic<bool> enabled;
+	static std::string tracePath;
+	static std::chrono::steady_clock::time_point origin;
+	static std::mutex eventsMutex;
+	static std::vector<TraceEvent> events;
+	static size_t droppedEvents;
+	static std::atomic<uint32_t> nextThreadId;
+
+	/// <summary>
+	/// Adds an event, unless the trace is full
+	/// </summary>
+	/// <param name="event"></param>
+	static void add(TraceEvent&& event);
+
+	/// <summary>
+	/// Returns a small id of the calling thread, given in the order threads first record
+	/// </summary>
+	/// <returns></returns>
+	static uint32_t currentThreadId();
+
+	/// <summary>
+	/// Escapes a string for json
+	/// </summary>
+	/// <param name="str"></param>
+	/// <returns></returns>
+	static std::string escape(const std::string& str);
+
+public:
+	/// <summary>
+	/// Scope of a step - records a complete event from its construction to its destruction
+	/// </summary>
+	class Span {
+
+	private:
+		std::string name;
+		const char* category;
+		bool isTraced;
+		std::chrono::steady_clock::time_point start;
+		std::string args;
+
+	public:
+		/// <summary>
+		/// Ctor
+		/// </summary>
+		/// <param name="name"></param>
+		/// <param name="category"></param>
+		Span(const char* name, const char* category);
+
+		/// <summary>
+		/// Dtor
+		/// </summary>
+		~Span();
+
+		/// <summary>
+		/// Adds a number argument to the event
+		/// </summary>
+		/// <param name="key"></param>
+		/// <param name="value"></param>
+		void addArg(const char* key, uint64_t value);
+
+		/// <summary>
+		/// Adds a string argument to the event
+		/// </summary>
+		/// <param name="key"></param>
+		/// <param name="value"></param>
+		void addArg(const char* key, const std::string& value);
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+	};
+
+	/// <summary>
+	/// Starts recording events, to be written to a path at stop
+	/// </summary>
+	/// <param name="path"></param>
+	static void start(const std::string& path);
+
+	/// <summary>
+	/// Stops recording events and writes the trace file
+	/// </summary>
+	static void stop();
+
+	/// <summary>
+	/// Returns true if events are recorded
+	/// </summary>
+	/// <returns></returns>
+	static bool isEnabled();
+
+	/// <summary>
+	/// Records a complete event of the calling thread
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="category"></param>
+	/// <param name="start"></param>
+	/// <param name="end"></param>
+	/// <param name="args">json members of the arguments, without braces</param>
+	static void recordComplete(const std::string& name, const char* category, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end, const std::string& args = "");
+
+	/// <summary>
+	/// Records an event which may overlap other events of the calling thread - such as a request waiting for its response
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="category"></param>
+	/// <param name="id">id which tells apart the events of the same name that overlap</param>
+	/// <param name="start"></param>
+	/// <param name="end"></param>
+	/// <param name="args">json members of the arguments, without braces</param>
+	static void recordAsync(const std::string& name, const char* category, uint64_t id,
+		std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, const std::string& args = "");
+
+	/// <summary>
+	/// Records an instant event of the calling thread
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="category"></param>
+	/// <param name="args">json members of the arguments, without braces</param>
+	static void recordInstant(const std::string& name, const char* category, const std::string& args = "");
+
+	/// <summary>
+	/// Returns a json member of a string argument
+	/// </summary>
+	/// <param name="key"></param>
+	/// <param name="value"></param>
+	/// <returns></returns>
+	static std::string arg(const char* key, const std::string& value);
+
+	/// <summary>
+	/// Returns a json member of a number argument
+	/// </summary>
+	/// <param name="key"></param>
+	/// <param name="value"></param>
+	/// <returns></returns>
+	static std::string arg(const char* key, uint64_t value);
+
+	/// <summary>
+	/// Writes the recorded events as a Chrome trace event json
+	/// </summary>
+	/// <param name="out"></param>
+	static void write(std::ostream& out);
+};
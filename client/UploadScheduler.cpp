@@ -0,0 +1,161 @@
+#include "UploadScheduler.h"
+#include <algorithm>
+#include <iterator>
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="budget">bytes that may be buffered at once</param>
+UploadScheduler::UploadScheduler(size_t budget) {
+	this->budget = budget;
+	this->bufferedBytes = 0;
+	this->peakBufferedBytes = 0;
+	this->admissions = 0;
+}
+
+/// <summary>
+/// Queues a job until its memory fits in the budget and no job before it in the order waits
+/// </summary>
+/// <param name="job"></param>
+void UploadScheduler::enqueue(const ContentJob& job) {
+
+	ContentJob waitingJob = job;
+	waitingJob.sizeClass = sizeClassOf(job.fileSize);
+	waitingJob.enqueuedAt = this->admissions;
+	this->waitingJobs.push_back(waitingJob);
+}
+
+/// <summary>
+/// Admits the first waiting job if its memory fits in the budget and accounts its memory as buffered.
+/// Jobs are ordered by priority, then by size class of their file (shortest job first), then by arrival.
+/// A job larger than the whole budget is admitted alone, once nothing else is buffered
+/// </summary>
+/// <param name="job"></param>
+/// <returns>false if no job waits or the first one doesn't fit yet</returns>
+bool UploadScheduler::admit(ContentJob& job) {
+
+	if (this->waitingJobs.empty())
+		return false;
+
+	// finding the first job in the order - jobs that arrived earlier win ties, so chunks of a file keep their order
+	auto first = this->waitingJobs.begin();
+	int firstPriority = this->effectivePriorityOf(*first);
+	for (auto it = std::next(first); it != this->waitingJobs.end(); ++it) {
+		int priority = this->effectivePriorityOf(*it);
+		if (priority > firstPriority || (priority == firstPriority && it->sizeClass < first->sizeClass)) {
+			first = it;
+			firstPriority = priority;
+		}
+	}
+
+	// a job that doesn't fit is waited for rather than skipped, so a large job is not starved by the small ones
+	size_t memory = memoryOf(*first);
+	if (this->bufferedBytes > 0 && this->bufferedBytes + memory > this->budget)
+		return false;
+
+	job = *first;
+	this->waitingJobs.erase(first);
+	this->admissions++;
+
+	// the rest of the chunks of the file age from now on, so an aged large file doesn't hold back the files after it
+	for (ContentJob& waitingJob : this->waitingJobs) {
+		if (waitingJob.resultIndex == job.resultIndex)
+			waitingJob.enqueuedAt = this->admissions;
+	}
+
+	this->bufferedBytes += memory;
+	if (this->bufferedBytes > this->peakBufferedBytes)
+		this->peakBufferedBytes = this->bufferedBytes;
+
+	return true;
+}
+
+/// <summary>
+/// Returns memory of a job to the budget, once its content was sent
+/// </summary>
+/// <param name="bytes"></param>
+void UploadScheduler::release(size_t bytes) {
+	this->bufferedBytes -= std::min(bytes, this->bufferedBytes.load());
+}
+
+/// <summary>
+/// Drops the waiting jobs and starts the peak of buffered bytes over, before a new batch. Bytes of jobs
+/// already admitted stay buffered until they are released
+/// </summary>
+void UploadScheduler::clear() {
+	this->waitingJobs.clear();
+	this->peakBufferedBytes = this->bufferedBytes;
+	this->admissions = 0;
+}
+
+/// <summary>
+/// Returns whether no job waits for admission
+/// </summary>
+/// <returns></returns>
+bool UploadScheduler::isEmpty() const {
+	return this->waitingJobs.empty();
+}
+
+/// <summary>
+/// Returns the waiting jobs
+/// </summary>
+/// <returns></returns>
+const std::deque<ContentJob>& UploadScheduler::getWaitingJobs() const {
+	return this->waitingJobs;
+}
+
+/// <summary>
+/// Returns bytes that are buffered right now - content being prepared or waiting to be sent
+/// </summary>
+/// <returns></returns>
+size_t UploadScheduler::getBufferedBytes() const {
+	return this->bufferedBytes;
+}
+
+/// <summary>
+/// Returns the highest number of bytes that were buffered at once
+/// </summary>
+/// <returns></returns>
+size_t UploadScheduler::getPeakBufferedBytes() const {
+	return this->peakBufferedBytes;
+}
+
+/// <summary>
+/// Returns bytes that may be buffered at once
+/// </summary>
+/// <returns></returns>
+size_t UploadScheduler::getBudget() const {
+	return this->budget;
+}
+
+/// <summary>
+/// Returns the memory a job takes until it is sent - its content, and its compressed and encrypted copy
+/// </summary>
+/// <param name="job"></param>
+/// <returns></returns>
+size_t UploadScheduler::memoryOf(const ContentJob& job) {
+	return 2 * job.length;
+}
+
+/// <summary>
+/// Returns size class of a file - 0 up to SIZE_CLASS_BASE bytes, and one more for every SIZE_CLASS_FACTOR times larger
+/// </summary>
+/// <param name="fileSize"></param>
+/// <returns></returns>
+size_t UploadScheduler::sizeClassOf(uint64_t fileSize) {
+
+	size_t sizeClass = 0;
+	for (uint64_t limit = SIZE_CLASS_BASE; fileSize > limit && sizeClass < SIZE_CLASS_COUNT - 1; limit *= SIZE_CLASS_FACTOR)
+		sizeClass++;
+
+	return sizeClass;
+}
+
+/// <summary>
+/// Returns priority of a waiting job, raised by one for every AGING_ADMISSIONS admissions it waited
+/// </summary>
+/// <param name="job"></param>
+/// <returns></returns>
+int UploadScheduler::effectivePriorityOf(const ContentJob& job) const {
+	return job.priority + (int)((this->admissions - job.enqueuedAt) / AGING_ADMISSIONS);
+}
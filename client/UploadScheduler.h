@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+#include <cstddef>
+#include <deque>
+#include <atomic>
+
+const size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+const uint64_t SIZE_CLASS_BASE = 64 * 1024;
+const uint64_t SIZE_CLASS_FACTOR = 16;
+const size_t SIZE_CLASS_COUNT = 5;
+const uint64_t AGING_ADMISSIONS = 16;
+
+/// <summary>
+/// Content of a file to prepare and send - a whole file, or a chunk of it
+/// </summary>
+struct ContentJob {
+	size_t resultIndex;
+	uint64_t offset;
+	size_t length;
+	uint64_t fileSize;
+	bool isChunk;
+	int priority;
+	size_t sizeClass = 0;
+	uint64_t enqueuedAt = 0;
+	bool isDelta = false;
+};
+
+class UploadScheduler {
+
+private:
+	// members
+	size_t budget;
+	std::atomic<size_t> bufferedBytes;
+	size_t peakBufferedBytes;
+	uint64_t admissions;
+	std::deque<ContentJob> waitingJobs;
+
+	/// <summary>
+	/// Returns priority of a waiting job, raised by one for every AGING_ADMISSIONS admissions it waited
+	/// </summary>
+	/// <param name="job"></param>
+	/// <returns></returns>
+	int effectivePriorityOf(const ContentJob& job) const;
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	/// <param name="budget">bytes that may be buffered at once</param>
+	UploadScheduler(size_t budget);
+
+	/// <summary>
+	/// Queues a job until its memory fits in the budget and no job before it in the order waits
+	/// </summary>
+	/// <param name="job"></param>
+	void enqueue(const ContentJob& job);
+
+	/// <summary>
+	/// Admits the first waiting job if its memory fits in the budget and accounts its memory as buffered.
+	/// Jobs are ordered by priority, then by size class of their file (shortest job first), then by arrival.
+	/// A job larger than the whole budget is admitted alone, once nothing else is buffered
+	/// </summary>
+	/// <param name="job"></param>
+	/// <returns>false if no job waits or the first one doesn't fit yet</returns>
+	bool admit(ContentJob& job);
+
+	/// <summary>
+	/// Returns memory of a job to the budget, once its content was sent
+	/// </summary>
+	/// <param name="bytes"></param>
+	void release(size_t bytes);
+
+	/// <summary>
+	/// Drops the waiting jobs and starts the peak of buffered bytes over, before a new batch. Bytes of jobs
+	/// already admitted stay buffered until they are released
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Returns whether no job waits for admission
+	/// </summary>
+	/// <returns></returns>
+	bool isEmpty() const;
+
+	/// <summary>
+	/// Returns the waiting jobs
+	/// </summary>
+	/// <returns></returns>
+	const std::deque<ContentJob>& getWaitingJobs() const;
+
+	/// <summary>
+	/// Returns bytes that are buffered right now - content being prepared or waiting to be sent
+	/// </summary>
+	/// <returns></returns>
+	size_t getBufferedBytes() const;
+
+	/// <summary>
+	/// Returns the highest number of bytes that were buffered at once
+	/// </summary>
+	/// <returns></returns>
+	size_t getPeakBufferedBytes() const;
+
+	/// <summary>
+	/// Returns bytes that may be buffered at once
+	/// </summary>
+	/// <returns></returns>
+	size_t getBudget() const;
+
+	/// <summary>
+	/// Returns the memory a job takes until it is sent - its content, and its compressed and encrypted copy
+	/// </summary>
+	/// <param name="job"></param>
+	/// <returns></returns>
+	static size_t memoryOf(const ContentJob& job);
+
+	/// <summary>
+	/// Returns size class of a file - 0 up to SIZE_CLASS_BASE bytes, and one more for every SIZE_CLASS_FACTOR times larger
+	/// </summary>
+	/// <param name="fileSize"></param>
+	/// <returns></returns>
+	static size_t sizeClassOf(uint64_t fileSize);
+};
@@ -0,0 +1,84 @@
+#include "Varint.h"
+
+/// <summary>
+/// Appends a number in variable length encoding - 7 bits in each byte, least significant first,
+/// the high bit of a byte is set if more bytes follow
+/// </summary>
+/// <param name="destination"></param>
+/// <param name="value"></param>
+void Varint::append(std::string& destination, uint64_t value) {
+
+	while (value >= 0x80) {
+		destination.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+
+	destination.push_back((char)value);
+}
+
+/// <summary>
+/// Appends a string prefixed with its length in variable length encoding
+/// </summary>
+/// <param name="destination"></param>
+/// <param name="str"></param>
+void Varint::appendString(std::string& destination, const std::string& str) {
+	append(destination, str.size());
+	destination.append(str);
+}
+
+/// <summary>
+/// Reads a number in variable length encoding
+/// </summary>
+/// <param name="source"></param>
+/// <param name="offset">offset to read from, moved past the number</param>
+/// <param name="value"></param>
+/// <returns>false if the source ends before the number or the number is too long</returns>
+bool Varint::read(std::string_view source, size_t& offset, uint64_t& value) {
+
+	value = 0;
+
+	for (size_t i = 0; i < MAX_VARINT_LENGTH && offset < source.size(); i++) {
+		unsigned char byte = (unsigned char)source[offset++];
+		value |= (uint64_t)(byte & 0x7F) << (7 * i);
+
+		// the last byte of the number doesn't have the high bit set
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Reads a string prefixed with its length in variable length encoding
+/// </summary>
+/// <param name="source"></param>
+/// <param name="offset">offset to read from, moved past the string</param>
+/// <param name="str"></param>
+/// <returns>false if the source ends before the string</returns>
+bool Varint::readString(std::string_view source, size_t& offset, std::string& str) {
+
+	uint64_t length = 0;
+	if (!read(source, offset, length) || length > source.size() - offset)
+		return false;
+
+	str.assign(source.substr(offset, (size_t)length));
+	offset += (size_t)length;
+	return true;
+}
+
+/// <summary>
+/// Returns the number of bytes of a number in variable length encoding
+/// </summary>
+/// <param name="value"></param>
+/// <returns></returns>
+size_t Varint::length(uint64_t value) {
+
+	size_t length = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		length++;
+	}
+
+	return length;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+const size_t MAX_VARINT_LENGTH = 10;
+
+class Varint {
+
+public:
+
+	/// <summary>
+	/// Appends a number in variable length encoding - 7 bits in each byte, least significant first,
+	/// the high bit of a byte is set if more bytes follow
+	/// </summary>
+	/// <param name="destination"></param>
+	/// <param name="value"></param>
+	static void append(std::string& destination, uint64_t value);
+
+	/// <summary>
+	/// Appends a string prefixed with its length in variable length encoding
+	/// </summary>
+	/// <param name="destination"></param>
+	/// <param name="str"></param>
+	static void appendString(std::string& destination, const std::string& str);
+
+	/// <summary>
+	/// Reads a number in variable length encoding
+	/// </summary>
+	/// <param name="source"></param>
+	/// <param name="offset">offset to read from, moved past the number</param>
+	/// <param name="value"></param>
+	/// <returns>false if the source ends before the number or the number is too long</returns>
+	static bool read(std::string_view source, size_t& offset, uint64_t& value);
+
+	/// <summary>
+	/// Reads a string prefixed with its length in variable length encoding
+	/// </summary>
+	/// <param name="source"></param>
+	/// <param name="offset">offset to read from, moved past the string</param>
+	/// <param name="str"></param>
+	/// <returns>false if the source ends before the string</returns>
+	static bool readString(std::string_view source, size_t& offset, std::string& str);
+
+	/// <summary>
+	/// Returns the number of bytes of a number in variable length encoding
+	/// </summary>
+	/// <param name="value"></param>
+	/// <returns></returns>
+	static size_t length(uint64_t value);
+};
@@ -1,16 +1,48 @@
 #include "client.h"
 #include "fileitem.h"
+#include <iomanip>
 /// <summary>
 /// Ctor
 /// </summary>
-Client::Client() {
+Client::Client() : Client(ClientOptions()) {
+}
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="options"></param>
+Client::Client(const ClientOptions& options) : scheduler(options.memoryBudget), threadPool(options.threadCount) {
 	this->connectedToServer = false;
 	this->cksumOfLastFile = 0;
 	this->numberOfTrialsTOSendFile = 1;
 	this->clientIdBytes = { 0 };
+	this->lastFileStatus = UploadStatus::Pending;
+	this->protocolVersion = LEGACY_VERSION;
+	this->lastRequestId = 0;
+	this->windowSize = options.windowSize;
+	this->compressionCodec = options.compressionCodec;
+	this->watchDebounceMs = options.watchDebounceMs;
+	this->maxReconnects = options.maxReconnects;
+	this->reconnectBackoffMs = options.reconnectBackoffMs;
+	this->lazyInit = options.lazyInit;
+	this->random.seed(std::random_device()());
+
+	// by default a tenth of a second of the rate may be sent at once
+	auto burstOf = [&options](size_t rate) {
+		return options.burstBytes > 0 ? options.burstBytes : std::max(SEND_SLICE_SIZE, rate / BURST_PER_SECOND);
+	};
+	if (options.sessionRate > 0)
+		this->sockHandler.setRateLimit(options.sessionRate, burstOf(options.sessionRate), options.adaptiveRate);
+	if (options.globalRate > 0)
+		SocketHandler::setGlobalRateLimit(options.globalRate, burstOf(options.globalRate), options.adaptiveRate);
+	this->sockHandler.setTimeouts(options.connectTimeoutMs, options.ioTimeoutMs);
 
 	if (!std::filesystem::exists(SERVER_FILE_PATH)) {
-		std::cout << "Cannot contiune because server file is missing." << std::endl;
+		Logger::error("Cannot contiune because server file is missing", { { "path", SERVER_FILE_PATH } });
+	}
+	else if (this->lazyInit) {
+		// nothing is read or connected until there are files to send
+		Logger::debug("Deferring connection to server until files are sent");
 	}
 	else {
 
@@ -22,9 +54,6 @@ Client::Client() {
 		// loads registraion details (if any) - client id and private key that are stored in details file
 		this->loadRegistrationDetails();
 
-		// fixed size of client name
-		this->clientName.resize(CLIENT_NAME_LENGTH, '\0');
-
 		// connecting to server with host and port that were loaded from file
 
 	}
@@ -46,10 +75,12 @@ Client::~Client() {
 /// Loads host and port from file
 /// </summary>
 void Client::loadClientName() {
+	StartupProfiler::Step step("load_client_name");
+
 	try {
 		// getting client name from file
 		if (!fileHandler.readLine(SERVER_FILE_PATH, CLIENT_NAME, this->clientName)) {
-			std::cout << "Error in loading client name" << std::endl;
+			Logger::error("Error in loading client name");
 		}
 
 		if (this->clientName.length() > CLIENT_NAME_LENGTH)
@@ -58,7 +89,7 @@ void Client::loadClientName() {
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 }
 
@@ -68,10 +99,11 @@ void Client::loadClientName() {
 /// <param name="path"></param>
 bool Client::loadRegistrationDetails() {
 	std::string path = CLIENT_DETAILS_PATH;
+	StartupProfiler::Step step("load_registration");
 
 	if (!std::filesystem::exists(path)) {
 
-		std::cout << "Client details file is missing." << std::endl;
+		Logger::info("Client details file is missing", { { "path", path } });
 		return false;
 	}
 
@@ -81,12 +113,12 @@ bool Client::loadRegistrationDetails() {
 		std::string clientIdHex;
 
 		if (!fileHandler.readLine(CLIENT_DETAILS_PATH, CLIENT_ID, clientIdHex)) {
-			std::cout << "Error in loading registration details file" << std::endl;
+			Logger::error("Error in loading registration details file");
 			return false;
 		}
 
 		if (!this->verifyClientIdHex(clientIdHex)) {
-			std::cout << "Error in loading client id from client details file" << std::endl;
+			Logger::error("Error in loading client id from client details file");
 			return false;
 		}
 
@@ -96,7 +128,7 @@ bool Client::loadRegistrationDetails() {
 
 		// getting private key from file and putting it inside "privateKey" field
 		if (!fileHandler.readLine(path, PRIVATE_KEY, this->privateKey)) {
-			std::cout << "Error in loading private key." << std::endl;
+			Logger::error("Error in loading private key");
 			return false;
 		}
 
@@ -104,7 +136,7 @@ bool Client::loadRegistrationDetails() {
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		return false;
 	}
 }
@@ -133,7 +165,7 @@ bool Client::verifyClientIdHex(std::string hex) {
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		return false;
 	}
 }
@@ -162,202 +194,1377 @@ std::array<unsigned char, UUID_LENGTH> Client::hexToBytesArray(const std::string
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
+	}
+
+	return bytes;
+}
+
+/// <summary>
+/// Registers to server
+/// </summary>
+void Client::registerToServer() {
+
+	if (!this->connectedToServer) {
+		Logger::error("No connection to server");
+		return;
+	}
+
+
+	if (!std::filesystem::exists(SERVER_FILE_PATH)) {
+		Logger::error("Cannot contiune because server file is missing", { { "path", SERVER_FILE_PATH } });
+		return;
+	}
+
+	TraceRecorder::Span span("register", "session");
+	StartupProfiler::Step step("register");
+
+	try {
+
+		// registration is always sent in the legacy layout, and it negotiates the version for the next requests
+		this->protocolVersion = LEGACY_VERSION;
+
+		// creating a request with the relevant details and "register to server" code
+		Request request(CLIENT_VERSION, CLIENT_CODE_REGISTER, this->clientName);
+
+		// sending the request to the server
+		if (!this->sendRequestToServer(request))
+			return;
+
+		Logger::info("Sent request to server - registration to server", { { "client", this->clientName } });
+
+		// receiving response to the request from server
+		Response response;
+		if (!this->receiveResponse(response))
+			return;
+
+		// using the highest version both client and server speak
+		this->protocolVersion = std::min(CLIENT_VERSION, response.getVersion());
+
+		this->handleResponse(response);
+	}
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+	}
+}
+
+/// <summary>
+/// Saves private key
+/// </summary>
+/// <param name="privateKey"></param>
+void Client::savePrivateKey(std::string privateKey) {
+	std::string path = CLIENT_DETAILS_PATH;;
+
+	// if the file of client details is missing or the private key is already saved if the file
+	// the method exist without doing anything
+	if (!std::filesystem::exists(path)) {
+		return;
+	}
+
+
+	if (!fileHandler.writeLines(path, LINE_OF_PRIVATE_KEY, privateKey)) {
+		Logger::error("Error in saving private key");
+	}
+}
+
+/// <summary>
+/// Generates RSA Key Pair
+/// </summary>
+void Client::generateRSAKeyPair() {
+
+	if (!this->connectedToServer) {
+		Logger::error("No connection to server");
+		return;
+	}
+
+	if (this->clientIdHex == "") {
+		Logger::error("Cannot perform the task of generating RSA key pair and asking for AES key. registraion is needed first");
+		return;
+	}
+
+
+	TraceRecorder::Span span("key_exchange", "session");
+	StartupProfiler::Step step("key_exchange");
+
+	try {
+		// Creating an RSA decryptor. this is done here to generate a new private/public key pair
+		auto keygenStart = std::chrono::steady_clock::now();
+		std::unique_ptr<RSAPrivateWrapper> rsapriv;
+		if (this->pendingPrivateKey.valid()) {
+			// the key pair generated while connecting - waiting for it if it isn't ready yet
+			StartupProfiler::Step wait("rsa_keygen_wait");
+			rsapriv = std::make_unique<RSAPrivateWrapper>(this->pendingPrivateKey.get());
+		}
+		else {
+			StartupProfiler::Step keygen("rsa_keygen");
+			rsapriv = std::make_unique<RSAPrivateWrapper>();
+			TraceRecorder::recordComplete("rsa_keygen", "session", keygenStart, std::chrono::steady_clock::now());
+		}
+
+		// Getting the private key and encode it as base64
+		std::string base64PrivateKey = Base64Wrapper::encode(rsapriv->getPrivateKey());
+
+		// save private key in client details file
+		this->savePrivateKey(base64PrivateKey);
+
+		// save private key in field "private key"
+		this->privateKey = base64PrivateKey;
+
+		// Getting the public key
+		std::string publicKey = rsapriv->getPublicKey();
+
+		// setting clien name at the payload
+		std::string payload;
+		if (this->protocolVersion >= VERSION_COMPACT_FRAMING) {
+			Varint::appendString(payload, this->clientName);
+		}
+		else {
+			// fixed size of client name
+			payload = this->clientName;
+			payload.resize(CLIENT_NAME_LENGTH, '\0');
+		}
+
+		// appending the public key to the payload 
+		payload.append(publicKey);
+
+		// creating a request of sending public key and getting AES key to the server with
+		// the payload of client name and public key
+		Request request(clientIdBytes, this->protocolVersion, CLIENT_CODE_SEND_PUBLIC_KEY, std::move(payload));
+
+		// sending the request to server
+		if (!this->sendRequestToServer(request))
+			return;
+
+		Logger::info("Sent request to server - sent public RSA key, asking for AES key");
+
+		// receiving response to the request from server
+		this->receiveResponseFromServer();
+
+		if (!this->aesKey.empty())
+			ClientMetrics::recordKeyExchange(std::chrono::steady_clock::now() - keygenStart);
+	}
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+	}
+}
+
+/// <summary>
+/// Sends all the encrypted files to server over the same connection
+/// </summary>
+void Client::sendFilesToServer() {
+
+	try {
+		// the files are listed before anything else, so a lazy client with nothing to send never connects
+		if (this->loadFilePaths() == false) {
+			Logger::error("Server File doesn't exist or couldn't be loaded properly", { { "path", SERVER_FILE_PATH } });
+			return;
+		}
+
+		if (this->lazyInit && !this->connectedToServer)
+			this->startSession();
+
+		if (!this->connectedToServer) {
+			Logger::error("No connection to server");
+			return;
+		}
+
+		if (this->clientIdHex == "") {
+			Logger::error("Cannot perform the task of sending file. Registraion is needed first");
+			return;
+		}
+
+		this->uploadFiles(this->filePaths);
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+	}
+}
+
+/// <summary>
+/// Keeps running and uploads the files written in the directories to send, over the same connection
+/// </summary>
+void Client::watchFilesToServer() {
+
+	// a lazy client whose directories had no files to send yet connects before it starts watching
+	if (this->lazyInit && !this->connectedToServer)
+		this->startSession();
+
+	if (!this->connectedToServer || this->clientIdHex == "" || this->aesKey == "") {
+		Logger::error("Cannot watch directories without an authenticated connection to server");
+		return;
+	}
+
+	try {
+		DirectoryWatcher watcher;
+		for (const std::string& directoryPath : this->watchedDirectories) {
+			if (!watcher.addDirectory(directoryPath))
+				return;
+			Logger::info("Watching directory", { { "directory", directoryPath } });
+		}
+
+		if (this->watchedDirectories.empty()) {
+			Logger::error("No directories to watch in server file");
+			return;
+		}
+
+		// every group of files written together is uploaded as a batch, once none of them is written any more
+		std::vector<std::string> changedFiles;
+		while (watcher.waitForChanges(this->watchDebounceMs, changedFiles)) {
+			if (changedFiles.empty())
+				continue;
+
+			Logger::info("Files changed, uploading", { { "files", changedFiles.size() } });
+			if (!this->uploadFiles(changedFiles)) {
+				Logger::error("Connection to server is broken, stopped watching");
+				return;
+			}
+		}
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+	}
+}
+
+/// <summary>
+/// Uploads a batch of files over the authenticated connection and prints its summary
+/// </summary>
+/// <param name="filePaths"></param>
+/// <returns>false if the connection broke during the batch</returns>
+bool Client::uploadFiles(const std::vector<std::string>& filePaths) {
+
+	this->uploadResults.clear();
+	for (const std::string& filePath : filePaths)
+		this->uploadResults.push_back({ filePath, UploadStatus::Pending, 0, 0, false, this->priorityOf(filePath), {} });
+
+	// files of different directories with the same name would overwrite each other in server -
+	// they are rejected before any file of the batch is sent
+	for (UploadResult& result : this->uploadResults) {
+		std::string owner;
+		if (!this->claimServerFilename(result.filePath, owner)) {
+			Logger::error("Another file is sent under the same name", { { "path", result.filePath }, { "other", owner } });
+			result.status = UploadStatus::DuplicateName;
+		}
+	}
+	this->orderUploads();
+
+	// sending the files on the already authenticated connection - pipelined if the server supports it
+	// a broken connection is established again, and the batch continues with the files that are not completed
+	bool isConnected = false;
+	do {
+		if (this->protocolVersion >= VERSION_PIPELINING)
+			isConnected = this->sendFilesPipelined();
+		else
+			isConnected = this->sendFilesLockStep();
+	} while (!isConnected && this->reconnect());
+
+	// marking the files that were not completed because of a broken connection
+	for (UploadResult& result : this->uploadResults) {
+		if (result.status == UploadStatus::Pending || result.status == UploadStatus::SendFailed) {
+			result.status = UploadStatus::SendFailed;
+			isConnected = false;
+		}
+		ClientMetrics::recordFile(getStatusLabel(result.status));
+	}
+
+	this->printUploadSummary();
+
+	// every batch refreshes the metrics file, so a watching client is visible while it runs
+	ClientMetrics::setInFlightRequests(0);
+	ClientMetrics::flush();
+	return isConnected;
+}
+
+/// <summary>
+/// Sends a single encrypted file to server and waits for its cksum verification
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns>final status of the file</returns>
+UploadStatus Client::sendFileToServer(std::string filePath) {
+
+	try {
+		// every file of the batch starts its own trials from the first one
+		this->filePath = filePath;
+		this->numberOfTrialsTOSendFile = 1;
+		this->lastFileStatus = UploadStatus::Pending;
+
+		// creating a request to send to sever with the relevant information
+		Request request = Request(this->clientIdBytes, this->protocolVersion, CLIENT_CODE_SEND_FILE);
+
+		// the size of the content is 32 bits in the request - a larger file can only be sent in chunks
+		std::error_code error;
+		uint64_t fileSize = std::filesystem::file_size(this->filePath, error);
+		if (!error && fileSize > MAX_REQUEST_CONTENT_SIZE) {
+			Logger::error("File is too large to send without chunks", { { "path", filePath }, { "size", fileSize } });
+			return UploadStatus::TooLarge;
+		}
+
+		// creating a file item to send to sever with the relevant information
+		// file item gets its information from method "loadFileContent"
+		FileItem fileItem;
+		if (this->loadFileContent(this->filePath, fileItem, this->cksumOfLastFile) == false) {
+			Logger::error("File doesn't exist", { { "path", filePath } });
+			return UploadStatus::ReadFailed;
+		}
+
+		Logger::debug("Sending file request to server", { { "file", fileItem.getFilename().data() } });
+
+		// sending request to server with request and file item objects
+		if (!this->sendRequestToServer(request, fileItem))
+			return UploadStatus::SendFailed;
+
+		Logger::debug("Waiting for response from server. Server needs to calculate cksum");
+		bool isReceived = false;
+		{
+			PhaseProfiler::Span span(UploadPhase::ServerWait);
+			isReceived = this->receiveResponseFromServer();
+		}
+		if (!isReceived)
+			return UploadStatus::SendFailed;
+
+		return this->lastFileStatus;
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		return UploadStatus::SendFailed;
+	}
+}
+
+/// <summary>
+/// Takes the name a file is saved under in server for the session, unless another file already took it -
+/// the server keeps the files of a client by their lowercase name only
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="owner">path of the file which took the name</param>
+/// <returns>false if the name belongs to another file</returns>
+bool Client::claimServerFilename(const std::string& filePath, std::string& owner) {
+
+	std::string filename = std::filesystem::path(filePath).filename().string();
+	std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+
+	// the same file may be listed with a different case or form of its path, or written again in watch mode
+	std::string normalPath = std::filesystem::path(filePath).lexically_normal().string();
+	std::transform(normalPath.begin(), normalPath.end(), normalPath.begin(), ::tolower);
+
+	auto claimed = this->serverFilenames.emplace(filename, normalPath).first;
+	if (claimed->second == normalPath)
+		return true;
+
+	owner = claimed->second;
+	return false;
+}
+
+/// <summary>
+/// Sends the pending files of the batch one after the other, waiting for each file to be verified
+/// </summary>
+/// <returns>false if the connection broke during the batch</returns>
+bool Client::sendFilesLockStep() {
+
+	for (size_t resultIndex : this->uploadOrder) {
+		UploadResult& result = this->uploadResults[resultIndex];
+		if (result.status != UploadStatus::Pending)
+			continue;
+
+		UploadStatus status = this->sendFileToServer(result.filePath);
+		result.trials += this->numberOfTrialsTOSendFile;
+
+		// a broken connection stops the batch - the file is sent again from its start on the next connection
+		if (status == UploadStatus::SendFailed)
+			return false;
+
+		result.status = status;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Sends the pending files of the batch keeping up to window size files in flight,
+/// matching responses to their requests by request id
+/// </summary>
+/// <returns>false if the connection broke during the batch</returns>
+bool Client::sendFilesPipelined() {
+
+	// in-flight files by id of the request that waits for a response
+	std::map<uint32_t, FileTransfer> inFlight;
+	size_t nextFile = 0;
+
+	this->drainPreparedFiles();
+	this->scheduler.clear();
+	this->requestSentAt.clear();
+	this->awaitedRequests.clear();
+	this->deltaBases.clear();
+
+	try {
+		while (nextFile < this->uploadResults.size() || !inFlight.empty() || !this->preparedContents.empty()
+			|| !this->scheduler.isEmpty()) {
+
+			// filling the window with new files before waiting for a response
+			// the memory of their content is bounded by the scheduler, not by the window
+			while (this->countActiveFiles(inFlight) < this->windowSize && nextFile < this->uploadResults.size()) {
+
+				// files completed on a previous connection are not sent again
+				if (this->uploadResults[this->uploadOrder[nextFile]].status != UploadStatus::Pending) {
+					nextFile++;
+					continue;
+				}
+
+				this->queueFileDigests(nextFile);
+				if (!this->startFileTransfer(this->uploadOrder[nextFile++], inFlight))
+					return false;
+			}
+
+			// sending files as soon as the thread pool prepares them, as long as no response is waiting to be read
+			// every content that is sent frees memory for the next ones waiting in the scheduler
+			this->admitFileContents();
+			while (!this->preparedContents.empty()) {
+				if (!this->sendPreparedFiles(inFlight))
+					return false;
+				this->admitFileContents();
+				if (this->preparedContents.empty() || (!inFlight.empty() && this->sockHandler.hasPendingData()))
+					break;
+				this->preparedContents[this->admissionOrder.front()].wait_for(std::chrono::milliseconds(PREPARED_FILE_POLL_MS));
+			}
+
+			// files which failed loading are not waiting for a response
+			ClientMetrics::setInFlightRequests((int64_t)inFlight.size());
+			if (inFlight.empty())
+				continue;
+
+			Response response;
+			if (!this->receiveResponse(response))
+				return false;
+
+			// finding the file the response belongs to
+			auto it = inFlight.find(response.getRequestId());
+			if (it == inFlight.end()) {
+				Logger::warning("Received response to unknown request", { { "request", response.getRequestId() } });
+				continue;
+			}
+
+			FileTransfer transfer = it->second;
+			inFlight.erase(it);
+
+			if (!this->handlePipelinedResponse(response, transfer, inFlight))
+				return false;
+		}
+	}
+
+	catch (std::exception& e)
+	{
+		Logger::error("Exception", { { "error", e.what() } });
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Connects to server again and authenticates the new connection, waiting longer before every attempt
+/// </summary>
+/// <returns>false if all the attempts failed</returns>
+bool Client::reconnect() {
+
+	// content of the broken connection is still prepared with its key - it is waited for before the key changes
+	this->drainPreparedFiles();
+
+	for (size_t attempt = 0; attempt < this->maxReconnects; attempt++) {
+
+		// exponential backoff with jitter - between half and all of the doubled delay, so clients which lost
+		// their connections together don't come back together
+		size_t backoffMs = MAX_RECONNECT_BACKOFF_MS;
+		if (attempt < 16)
+			backoffMs = std::min(MAX_RECONNECT_BACKOFF_MS, this->reconnectBackoffMs << attempt);
+		std::uniform_int_distribution<size_t> jitter(backoffMs / 2, backoffMs);
+		size_t delayMs = jitter(this->random);
+
+		Logger::warning("Connection to server lost, reconnecting", { { "delay_ms", delayMs }, { "attempt", attempt + 1 },
+			{ "max_attempts", this->maxReconnects } });
+
+		TraceRecorder::Span span("reconnect", "retry");
+		span.addArg("attempt", attempt + 1);
+		span.addArg("delay_ms", delayMs);
+		std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+
+		this->connectedToServer = this->sockHandler.connectToServer();
+		if (!this->connectedToServer)
+			continue;
+
+		// nothing sent on the broken connection is answered on the new one
+		this->requestSentAt.clear();
+		this->awaitedRequests.clear();
+
+		// the new connection negotiates its version and gets a new AES key - content encrypted with the old key is
+		// prepared again
+		this->aesKey = "";
+		this->registerToServer();
+		this->generateRSAKeyPair();
+		if (!this->aesKey.empty())
+			return true;
+	}
+
+	this->connectedToServer = false;
+	return false;
+}
+
+/// <summary>
+/// Waits for the files the thread pool is still preparing and returns their memory to the scheduler - they read
+/// the key, version and client id of the session, so they are done before a new session changes them
+/// </summary>
+void Client::drainPreparedFiles() {
+
+	for (auto& digest : this->preparedDigests)
+		digest.second.wait();
+	this->preparedDigests.clear();
+
+	// the memory of a content is released once its task is done, never while the task may still use it
+	for (auto& content : this->preparedContents) {
+		try {
+			this->scheduler.release(content.second.get().memory);
+		}
+		catch (std::exception& e)
+		{
+			Logger::error("Exception", { { "error", e.what() } });
+		}
+	}
+	this->preparedContents.clear();
+	this->admissionOrder.clear();
+}
+
+/// <summary>
+/// Connects, registers and exchanges keys the first time files are sent by a lazy client. The RSA key pair is
+/// generated on another thread meanwhile, so it costs no time of its own before the first byte
+/// </summary>
+void Client::startSession() {
+
+	this->pendingPrivateKey = std::async(std::launch::async, []() {
+		StartupProfiler::Step step("rsa_keygen");
+		auto keygenStart = std::chrono::steady_clock::now();
+		RSAPrivateWrapper rsapriv;
+		TraceRecorder::recordComplete("rsa_keygen", "session", keygenStart, std::chrono::steady_clock::now());
+		return rsapriv.getPrivateKey();
+	});
+
+	if (this->sockHandler.connectToServer())
+		this->connectedToServer = true;
+
+	this->loadClientName();
+	this->loadRegistrationDetails();
+	this->registerToServer();
+	this->generateRSAKeyPair();
+}
+
+/// <summary>
+/// Starts the transfer of a file of the batch - asks the server whether it already has the file,
+/// if the server supports it, or sends the file right away
+/// </summary>
+/// <param name="resultIndex">index of the file in the upload results</param>
+/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+/// <returns>false if the connection is broken, true otherwise</returns>
+bool Client::startFileTransfer(size_t resultIndex, std::map<uint32_t, FileTransfer>& inFlight) {
+
+	if (this->protocolVersion >= VERSION_DEDUP)
+		return this->sendFileDigest(resultIndex, inFlight);
+
+	this->queueFileContent(resultIndex);
+	return true;
+}
+
+/// <summary>
+/// Sends size and cksum of a file of the batch and adds it to the in-flight files
+/// </summary>
+/// <param name="resultIndex">index of the file in the upload results</param>
+/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+/// <returns>false if the connection is broken, true otherwise</returns>
+bool Client::sendFileDigest(size_t resultIndex, std::map<uint32_t, FileTransfer>& inFlight) {
+
+	UploadResult& result = this->uploadResults[resultIndex];
+
+	// the digest is calculated over the original content, like the cksum the server saved on upload
+	// it was queued in the thread pool ahead of the request
+	this->queueFileDigest(resultIndex);
+	PreparedFile digest = this->preparedDigests[resultIndex].get();
+	this->preparedDigests.erase(resultIndex);
+
+	uint32_t cksum = digest.cksum;
+	if (!digest.isLoaded) {
+		Logger::error("File doesn't exist", { { "path", result.filePath } });
+		result.status = UploadStatus::ReadFailed;
+		return true;
+	}
+
+	// chunks of the file are verified with the cksum of the whole file
+	// chunks acknowledged on a previous connection belong to other content if the file changed since
+	if (result.hasCksum && result.cksum != cksum)
+		result.ackedChunks.clear();
+	result.cksum = cksum;
+	result.hasCksum = true;
+
+	// the file may be gone since its digest was calculated - it fails alone, the connection is fine
+	std::error_code error;
+	uint64_t fileSize = std::filesystem::file_size(result.filePath, error);
+	if (error) {
+		Logger::error("File doesn't exist", { { "path", result.filePath } });
+		result.status = UploadStatus::ReadFailed;
+		return true;
+	}
+
+	std::string filename = std::filesystem::path(result.filePath).filename().string();
+
+	// the payload is the length prefixed filename, the size of the file (variable length) and its cksum
+	std::string payload;
+	CksumHeader cksumHeader = {};
+	cksumHeader.cksum = cksum;
+	Varint::appendString(payload, filename);
+	Varint::append(payload, fileSize);
+	payload.append(cksumHeader.buffer, sizeof(uint32_t));
+
+	Logger::debug("Asking server whether it has file", { { "file", filename }, { "size", fileSize }, { "cksum", cksum } });
+
+	Request request(this->clientIdBytes, this->protocolVersion, CLIENT_CODE_FILE_DIGEST, std::move(payload));
+	if (!this->sendRequestToServer(request))
+		return false;
+
+	inFlight[request.getRequestId()] = { resultIndex, filename, cksum, UploadStatus::Pending, 0, std::chrono::steady_clock::now() };
+	return true;
+}
+
+/// <summary>
+/// Queues the content of a file of the batch in the scheduler - as a whole, or in chunks if the server supports it
+/// </summary>
+/// <param name="resultIndex">index of the file in the upload results</param>
+void Client::queueFileContent(size_t resultIndex) {
+
+	UploadResult& result = this->uploadResults[resultIndex];
+	result.trials++;
+
+	std::error_code error;
+	uint64_t fileSize = std::filesystem::file_size(result.filePath, error);
+	if (error) {
+		Logger::error("File doesn't exist", { { "path", result.filePath } });
+		result.status = UploadStatus::ReadFailed;
+		return;
+	}
+
+	// a large file is sent in chunks, so it never has to be held in memory as a whole
+	// the chunks are verified with the cksum of the whole file, which the digest request calculated
+	if (this->protocolVersion >= VERSION_CHUNKED && result.hasCksum && fileSize > CHUNK_SIZE) {
+		for (uint64_t offset = 0; offset < fileSize; offset += CHUNK_SIZE) {
+			// chunks the server acknowledged on a previous connection are not sent again
+			if (result.ackedChunks.count(offset) > 0)
+				continue;
+
+			size_t length = (size_t)std::min<uint64_t>(CHUNK_SIZE, fileSize - offset);
+			this->scheduler.enqueue({ resultIndex, offset, length, fileSize, true, result.priority });
+		}
+		return;
+	}
+
+	// the size of the content is 32 bits in the request - a larger file can only be sent in chunks
+	if (fileSize > MAX_REQUEST_CONTENT_SIZE) {
+		Logger::error("File is too large to send without chunks", { { "path", result.filePath }, { "size", fileSize } });
+		result.status = UploadStatus::TooLarge;
+		return;
+	}
+
+	this->scheduler.enqueue({ resultIndex, 0, (size_t)fileSize, fileSize, false, result.priority });
+}
+
+/// <summary>
+/// Hands the queued contents which fit in the memory budget to the thread pool to be loaded, compressed,
+/// encrypted and cksummed
+/// </summary>
+void Client::admitFileContents() {
+
+	// admitting on this thread only, so a thread of the pool never waits for memory and the pool can't deadlock
+	ContentJob job = {};
+	while (this->scheduler.admit(job)) {
+
+		// chunks of a file which already failed are not prepared
+		if (this->uploadResults[job.resultIndex].status != UploadStatus::Pending) {
+			this->deltaBases.erase(job.resultIndex);
+			this->scheduler.release(UploadScheduler::memoryOf(job));
+			continue;
+		}
+
+		std::string filePath = this->uploadResults[job.resultIndex].filePath;
+		if (job.isDelta) {
+			std::shared_ptr<const DeltaBasis> basis = this->deltaBases[job.resultIndex];
+			this->deltaBases.erase(job.resultIndex);
+			this->preparedContents[{ job.resultIndex, job.offset }] = this->threadPool.submit([this, filePath, job, basis]() {
+				return this->prepareDelta(filePath, job, basis);
+			});
+		}
+		else {
+			this->preparedContents[{ job.resultIndex, job.offset }] = this->threadPool.submit([this, filePath, job]() {
+				return this->prepareContent(filePath, job);
+			});
+		}
+
+		// contents are sent in the order the scheduler admitted them - by priority, size class and age
+		this->admissionOrder.push_back({ job.resultIndex, job.offset });
+	}
+}
+
+/// <summary>
+/// Returns number of files of the batch which are started and not completed yet
+/// </summary>
+/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+/// <returns></returns>
+size_t Client::countActiveFiles(const std::map<uint32_t, FileTransfer>& inFlight) {
+
+	// chunks of the same file count as one file
+	std::set<size_t> activeFiles;
+	for (const auto& transfer : inFlight)
+		activeFiles.insert(transfer.second.resultIndex);
+	for (const auto& prepared : this->preparedContents)
+		activeFiles.insert(prepared.first.first);
+	for (const ContentJob& job : this->scheduler.getWaitingJobs())
+		activeFiles.insert(job.resultIndex);
+
+	return activeFiles.size();
+}
+
+/// <summary>
+/// Queues the cksum of the next files of the batch in the thread pool, ahead of their digest requests
+/// </summary>
+/// <param name="nextFile">place in the upload order of the next file to start</param>
+void Client::queueFileDigests(size_t nextFile) {
+
+	if (this->protocolVersion < VERSION_DEDUP)
+		return;
+
+	// keeping every thread of the pool busy with the files that come next
+	size_t lastFile = std::min(this->uploadOrder.size(), nextFile + this->windowSize + this->threadPool.size());
+	for (size_t i = nextFile; i < lastFile; i++)
+		this->queueFileDigest(this->uploadOrder[i]);
+}
+
+/// <summary>
+/// Queues the cksum of a file of the batch in the thread pool, unless it is already queued
+/// </summary>
+/// <param name="resultIndex">index of the file in the upload results</param>
+void Client::queueFileDigest(size_t resultIndex) {
+
+	if (this->preparedDigests.count(resultIndex) > 0 || this->uploadResults[resultIndex].status != UploadStatus::Pending)
+		return;
+
+	std::string filePath = this->uploadResults[resultIndex].filePath;
+	this->preparedDigests[resultIndex] = this->threadPool.submit([this, filePath]() {
+		return this->prepareDigest(filePath);
+	});
+}
+
+/// <summary>
+/// Calculates cksum of a file in a thread of the pool
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns></returns>
+PreparedFile Client::prepareDigest(std::string filePath) {
+
+	PreparedFile prepared = { false, FileItem(), 0, 0 };
+
+	if (!std::filesystem::exists(filePath))
+		return prepared;
+
+	prepared.isLoaded = this->calculateCksum(filePath, prepared.cksum);
+	return prepared;
+}
+
+/// <summary>
+/// Loads, compresses and encrypts content of a file in a thread of the pool - the whole file or a chunk of it
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="job"></param>
+/// <returns></returns>
+PreparedFile Client::prepareContent(std::string filePath, ContentJob job) {
+
+	PreparedFile prepared = { false, FileItem(), 0, UploadScheduler::memoryOf(job) };
+
+	if (!std::filesystem::exists(filePath))
+		return prepared;
+
+	if (!job.isChunk) {
+		prepared.isLoaded = this->loadFileContent(filePath, prepared.fileItem, prepared.cksum);
+		return prepared;
+	}
+
+	std::string chunk;
+	bool isRead = false;
+	{
+		PhaseProfiler::Span span(UploadPhase::Read);
+		isRead = this->fileHandler.readChunk(filePath, job.offset, job.length, chunk);
+	}
+	if (!isRead)
+		return prepared;
+
+	std::string filename = std::filesystem::path(filePath).filename().string();
+	prepared.isLoaded = this->packContent(filename, chunk.data(), chunk.size(), prepared.fileItem);
+	prepared.fileItem.setChunk(job.offset, job.fileSize);
+	return prepared;
+}
+
+/// <summary>
+/// Loads a file, encodes it as a delta against the copy saved in server, and compresses and encrypts the delta
+/// in a thread of the pool
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="job"></param>
+/// <param name="basis"></param>
+/// <returns></returns>
+PreparedFile Client::prepareDelta(std::string filePath, ContentJob job, std::shared_ptr<const DeltaBasis> basis) {
+
+	PreparedFile prepared = { false, FileItem(), 0, UploadScheduler::memoryOf(job), true };
+
+	std::string filename = std::filesystem::path(filePath).filename().string();
+	std::string content;
+
+	Logger::debug("Reading file from disk", { { "file", filename } });
+	bool isRead = false;
+	{
+		PhaseProfiler::Span span(UploadPhase::Read);
+		isRead = this->fileHandler.readChunk(filePath, 0, job.length, content);
+	}
+	if (!isRead)
+		return prepared;
+
+	// the server verifies the rebuilt file with the cksum of the whole original content
+	this->calculateCksum((unsigned char*)content.data(), content.size(), prepared.cksum);
+
+	size_t literalBytes = 0;
+	std::string delta = DeltaEncoder::encode(content.data(), content.size(), basis->blockSize, basis->signatures,
+		literalBytes);
+
+	// the blocks which changed are copied from the file content into the delta
+	this->payloadCopyCounter.record(literalBytes, literalBytes);
+
+	Logger::info("Sending delta of file", { { "file", filename }, { "changed_bytes", literalBytes }, { "size", job.fileSize } });
+
+	prepared.isLoaded = this->packContent(filename, delta.data(), delta.size(), prepared.fileItem);
+	return prepared;
+}
+
+/// <summary>
+/// Sends the queued files whose preparation is done, in the order the scheduler admitted them, and adds them to the in-flight files
+/// </summary>
+/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+/// <returns>false if the connection is broken, true otherwise</returns>
+bool Client::sendPreparedFiles(std::map<uint32_t, FileTransfer>& inFlight) {
+
+	// walking the contents in the order they were admitted, not in the order of their files in the batch
+	for (auto order = this->admissionOrder.begin(); order != this->admissionOrder.end();) {
+
+		auto it = this->preparedContents.find(*order);
+		if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++order;
+			continue;
+		}
+
+		size_t resultIndex = it->first.first;
+		PreparedFile prepared = it->second.get();
+		this->preparedContents.erase(it);
+		order = this->admissionOrder.erase(order);
+
+		UploadResult& result = this->uploadResults[resultIndex];
+		bool isChunk = prepared.fileItem.getFileSize() > 0;
+
+		// chunks of a file which already failed are dropped
+		if (result.status != UploadStatus::Pending) {
+			this->scheduler.release(prepared.memory);
+			continue;
+		}
+
+		// a file which can't be loaded fails alone - the rest of the batch continues
+		if (!prepared.isLoaded) {
+			Logger::error("File doesn't exist", { { "path", result.filePath } });
+			result.status = UploadStatus::ReadFailed;
+			this->scheduler.release(prepared.memory);
+			continue;
+		}
+
+		if (isChunk)
+			Logger::debug("Sending chunk of file", { { "file", prepared.fileItem.getFilename().data() },
+				{ "offset", prepared.fileItem.getOffset() }, { "size", prepared.fileItem.getFileSize() } });
+		else
+			Logger::debug("Sending file request to server", { { "file", prepared.fileItem.getFilename().data() } });
+
+		uint16_t code = isChunk ? CLIENT_CODE_SEND_CHUNK : prepared.isDelta ? CLIENT_CODE_SEND_DELTA : CLIENT_CODE_SEND_FILE;
+		Request request(this->clientIdBytes, this->protocolVersion, code);
+		bool isSent = this->sendRequestToServer(request, prepared.fileItem);
+		this->scheduler.release(prepared.memory);
+		if (!isSent)
+			return false;
+
+		// content of a file sent before - which failed its cksum, or whose connection broke
+		if (result.trials > 1)
+			ClientMetrics::addRetransmittedBytes(prepared.fileItem.getContentSize());
+
+		uint32_t cksum = isChunk ? result.cksum : prepared.cksum;
+		inFlight[request.getRequestId()] = { resultIndex, std::string(prepared.fileItem.getFilename()), cksum,
+			UploadStatus::Pending, prepared.fileItem.getOffset(), std::chrono::steady_clock::now() };
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Queues a file of the batch in the scheduler, to be sent as a delta against the copy saved in server
+/// </summary>
+/// <param name="resultIndex">index of the file in the upload results</param>
+/// <param name="response">response with the block signatures of the copy saved in server</param>
+void Client::queueFileDelta(size_t resultIndex, Response& response) {
+
+	UploadResult& result = this->uploadResults[resultIndex];
+
+	// falling back to sending the whole file if the signatures can't be used
+	auto basis = std::make_shared<DeltaBasis>();
+	if (!DeltaEncoder::parseSignatures(response.getPayload(), basis->blockSize, basis->signatures)) {
+		Logger::warning("Received malformed block signatures from server, sending the whole file", { { "file", result.filePath } });
+		this->queueFileContent(resultIndex);
+		return;
+	}
+
+	// the delta is encoded from the whole file in memory - a file above the memory budget or the chunk size is
+	// sent whole instead, in chunks when the server accepts them
+	std::error_code error;
+	uint64_t fileSize = std::filesystem::file_size(result.filePath, error);
+	if (error || fileSize > this->scheduler.getBudget() || fileSize > MAX_REQUEST_CONTENT_SIZE
+		|| (this->protocolVersion >= VERSION_CHUNKED && fileSize > CHUNK_SIZE)) {
+		if (!error)
+			Logger::debug("File is too large to encode as a delta, sending the whole file", { { "file", result.filePath }, { "size", fileSize } });
+		this->queueFileContent(resultIndex);
+		return;
+	}
+
+	result.trials++;
+
+	// the whole file is read to encode the delta - its memory is reserved like the content of any other file,
+	// and the delta is encoded by the thread pool instead of stalling the sending thread
+	ContentJob job = { resultIndex, 0, (size_t)fileSize, fileSize, false, result.priority };
+	job.isDelta = true;
+	this->deltaBases[resultIndex] = basis;
+	this->scheduler.enqueue(job);
+}
+
+/// <summary>
+/// Handles response from server to a request of an in-flight file
+/// </summary>
+/// <param name="response"></param>
+/// <param name="transfer"></param>
+/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+/// <returns>false if the connection is broken, true otherwise</returns>
+bool Client::handlePipelinedResponse(Response& response, FileTransfer& transfer, std::map<uint32_t, FileTransfer>& inFlight) {
+
+	UploadResult& result = this->uploadResults[transfer.resultIndex];
+
+	switch (response.getCode()) {
+
+	case SERVER_CODE_CKSUM_READY: {
+
+		// the wait covers the server receiving, decrypting and saving the content, and the requests ahead of it
+		// in flight, the waits of files overlap each other - traced apart by request id
+		auto receivedAt = std::chrono::steady_clock::now();
+		PhaseProfiler::record(UploadPhase::ServerWait, receivedAt - transfer.sentAt);
+		TraceRecorder::recordAsync("server_wait", "file", response.getRequestId(), transfer.sentAt, receivedAt,
+			TraceRecorder::arg("file", transfer.filename));
+
+		// the payload holds the content size, filename and cksum of the file saved in server
+		uint32_t contentSize = 0;
+		std::string filename;
+		uint32_t cksumFromServer = 0;
+		if (!this->parseCksumReply(response, contentSize, filename, cksumFromServer)) {
+			Logger::warning("Received malformed cksum response from server", { { "file", transfer.filename.c_str() } });
+			return false;
+		}
+
+		Logger::info("Received cksum of file", { { "file", transfer.filename.c_str() }, { "cksum", transfer.cksum },
+			{ "server_cksum", cksumFromServer } });
+
+		// the server completed the file - a file sent again is sent with all of its chunks
+		result.ackedChunks.clear();
+
+		// answering the cksum with a request on the same file
+		Request request(this->clientIdBytes, this->protocolVersion, transfer.filename);
+		request.setCode(this->getCksumRequestCode(transfer.cksum, cksumFromServer, result.trials));
+		if (request.getCode() != CLIENT_CODE_CKSUM_OK)
+			ClientMetrics::recordCksumFailure(result.trials);
+		if (!this->sendRequestToServer(request))
+			return false;
+
+		if (request.getCode() == CLIENT_CODE_CKSUM_ERR) {
+			// server doesn't answer this request - the file is sent again right away
+			Logger::warning("Cksum failed, sending file again", { { "file", transfer.filename.c_str() }, { "trials", result.trials } });
+			TraceRecorder::recordInstant("cksum_retry", "retry", TraceRecorder::arg("file", transfer.filename) + ","
+				+ TraceRecorder::arg("trial", result.trials));
+			this->queueFileContent(transfer.resultIndex);
+			return true;
+		}
+
+		// waiting for the server to confirm the final status of the file
+		transfer.status = request.getCode() == CLIENT_CODE_CKSUM_OK ? UploadStatus::Verified : UploadStatus::CksumFailed;
+		inFlight[request.getRequestId()] = transfer;
+		return true;
+	}
+
+	case SERVER_CODE_MESSAGE_RECEIVED:
+		result.status = transfer.status;
+		return true;
+
+	case SERVER_CODE_CHUNK_RECEIVED: {
+		auto receivedAt = std::chrono::steady_clock::now();
+		PhaseProfiler::record(UploadPhase::ServerWait, receivedAt - transfer.sentAt);
+		TraceRecorder::recordAsync("server_wait", "file", response.getRequestId(), transfer.sentAt, receivedAt,
+			TraceRecorder::arg("file", transfer.filename) + "," + TraceRecorder::arg("offset", transfer.chunkOffset));
+
+		// the file is answered with its cksum once its last chunk arrives
+		// until then, the chunk is remembered in case the connection breaks
+		result.ackedChunks.insert(transfer.chunkOffset);
+		return true;
 	}
 
-	return bytes;
-}
+	case SERVER_CODE_FILE_PRESENT:
+		// the server already has a verified copy of the file - nothing to send
+		Logger::info("File is unchanged on server, skipping it", { { "file", transfer.filename.c_str() } });
+		result.status = UploadStatus::Unchanged;
+		return true;
 
-/// <summary>
-/// Registers to server
-/// </summary>
-void Client::registerToServer() {
+	case SERVER_CODE_FILE_MISSING:
+		this->queueFileContent(transfer.resultIndex);
+		return true;
 
-	if (!this->connectedToServer) {
-		std::cout << "No connection to server" << std::endl;
-		return;
-	}
+	case SERVER_CODE_FILE_SIGNATURES:
+		// the server has an older copy of the file - sending only what changed
+		this->queueFileDelta(transfer.resultIndex, response);
+		return true;
 
+	case SERVER_CODE_REGISTRATION_ERR:
+		Logger::error("Received response from server - client is not registered");
+		result.status = UploadStatus::SendFailed;
+		return true;
 
-	if (!std::filesystem::exists(SERVER_FILE_PATH)) {
-		std::cout << "Cannot contiune because server file is missing." << std::endl;
-		return;
+	default:
+		return true;
 	}
+}
 
-	try {
+/// <summary>
+/// Parses content size, filename and cksum of the file saved in server from a cksum response
+/// </summary>
+/// <param name="response"></param>
+/// <param name="contentSize"></param>
+/// <param name="filename"></param>
+/// <param name="cksum"></param>
+/// <returns>false if the payload of the response is malformed</returns>
+bool Client::parseCksumReply(Response& response, uint32_t& contentSize, std::string& filename, uint32_t& cksum) {
 
-		// creating a request with the relevant details and "register to server" code
-		Request request(CLIENT_VERSION, CLIENT_CODE_REGISTER, this->clientName);
+	std::string_view payload = response.getPayload();
 
-		// sending the request to the server
-		if (!this->sendRequestToServer(request))
-			return;
+	if (this->protocolVersion >= VERSION_COMPACT_FRAMING) {
 
-		std::cout << "Sent request to server - registration to server" << std::endl;
+		// content size in variable length encoding, length prefixed filename and cksum
+		size_t offset = 0;
+		uint64_t size = 0;
+		CksumHeader cksumHeader = {};
 
-		// receiving response to the request from server
-		this->receiveResponseFromServer();
-	}
-	catch (std::exception& e)
-	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		if (!Varint::read(payload, offset, size) || !Varint::readString(payload, offset, filename)
+			|| payload.size() - offset < sizeof(uint32_t))
+			return false;
+
+		memcpy(cksumHeader.buffer, payload.data() + offset, sizeof(uint32_t));
+		contentSize = (uint32_t)size;
+		cksum = cksumHeader.cksum;
+		return true;
 	}
+
+	// content size, filename with a determined length and cksum
+	if (payload.size() < sizeof(CksumData))
+		return false;
+
+	CksumReplyHeader cksumReplyHeader = {};
+	memcpy(cksumReplyHeader.buffer, payload.data(), sizeof(CksumData));
+	contentSize = cksumReplyHeader.cksumData.contentSize;
+	filename.assign(cksumReplyHeader.cksumData.filename, FILENAME_LENGTH);
+	cksum = cksumReplyHeader.cksumData.cksum;
+	return true;
 }
 
 /// <summary>
-/// Saves private key
+/// Returns the code of the request that answers a cksum from server
 /// </summary>
-/// <param name="privateKey"></param>
-void Client::savePrivateKey(std::string privateKey) {
-	std::string path = CLIENT_DETAILS_PATH;;
+/// <param name="clientCksum"></param>
+/// <param name="serverCksum"></param>
+/// <param name="trials">number of times the file was sent</param>
+/// <returns>cksum ok, cksum error or cksum error for the last time</returns>
+uint16_t Client::getCksumRequestCode(uint32_t clientCksum, uint32_t serverCksum, unsigned short trials) {
 
-	// if the file of client details is missing or the private key is already saved if the file
-	// the method exist without doing anything
-	if (!std::filesystem::exists(path)) {
-		return;
-	}
+	if (clientCksum == serverCksum)
+		return CLIENT_CODE_CKSUM_OK;
 
+	if (trials < NUMBER_OF_FILE_SENDING)
+		return CLIENT_CODE_CKSUM_ERR;
 
-	if (!fileHandler.writeLines(path, LINE_OF_PRIVATE_KEY, privateKey)) {
-		std::cout << "Error in saving private key." << std::endl;
+	return CLIENT_CODE_CKSUM_ERR_FINAL;
+}
+
+/// <summary>
+/// Returns the label of a final status of a file, as it is counted in the metrics
+/// </summary>
+/// <param name="status"></param>
+/// <returns></returns>
+std::string Client::getStatusLabel(UploadStatus status) {
+
+	switch (status) {
+	case UploadStatus::Verified:
+		return "verified";
+	case UploadStatus::Unchanged:
+		return "unchanged";
+	case UploadStatus::CksumFailed:
+		return "cksum_failed";
+	case UploadStatus::ReadFailed:
+		return "read_failed";
+	case UploadStatus::TooLarge:
+		return "too_large";
+	case UploadStatus::DuplicateName:
+		return "duplicate_name";
+	case UploadStatus::SendFailed:
+		return "send_failed";
+	default:
+		return "pending";
 	}
 }
 
 /// <summary>
-/// Generates RSA Key Pair
+/// Prints summary of the outcome of each file of the batch
 /// </summary>
-void Client::generateRSAKeyPair() {
+void Client::printUploadSummary() {
+
+	size_t verified = 0;
+
+	// the summary is written to the console directly - after the records logged before it
+	Logger::flush();
+	std::cout << std::endl << "Upload summary:" << std::endl;
+	std::cout << "------------------------------------" << std::endl;
+
+	for (const UploadResult& result : this->uploadResults) {
+		std::string status;
+
+		switch (result.status) {
+		case UploadStatus::Verified:
+			status = "verified";
+			verified++;
+			break;
+		case UploadStatus::Unchanged:
+			status = "unchanged on server";
+			verified++;
+			break;
+		case UploadStatus::CksumFailed:
+			status = "cksum failed";
+			break;
+		case UploadStatus::ReadFailed:
+			status = "read failed";
+			break;
+		case UploadStatus::TooLarge:
+			status = "too large to send without chunks";
+			break;
+		case UploadStatus::DuplicateName:
+			status = "another file has the same name";
+			break;
+		case UploadStatus::SendFailed:
+			status = "send failed";
+			break;
+		default:
+			status = "pending";
+			break;
+		}
 
-	if (!this->connectedToServer) {
-		std::cout << "No connection to server" << std::endl;
-		return;
+		std::cout << result.filePath << ": " << status << " (" << result.trials << " trial/s)" << std::endl;
 	}
 
-	if (this->clientIdHex == "") {
-		std::cout << "Cannot perform the task of generating RSA key pair and asking for AES key. registraion is needed first." << std::endl;
-		return;
-	}
+	std::cout << "------------------------------------" << std::endl;
+	std::cout << verified << " of " << this->uploadResults.size() << " files verified" << std::endl;
 
+	size_t sendRate = this->sockHandler.getSendRate();
+	if (sendRate > 0)
+		std::cout << "Send rate limit: " << sendRate << " bytes/sec" << std::endl;
 
-	try {
-		// Creating an RSA decryptor. this is done here to generate a new private/public key pair
-		RSAPrivateWrapper rsapriv;
+	if (this->protocolVersion >= VERSION_PIPELINING)
+		std::cout << "Peak memory of file content: " << this->scheduler.getPeakBufferedBytes() << " of "
+			<< this->scheduler.getBudget() << " bytes" << std::endl;
 
-		// Getting the private key and encode it as base64
-		std::string base64PrivateKey = Base64Wrapper::encode(rsapriv.getPrivateKey());
+	this->printIoSummary();
+}
 
-		// save private key in client details file
-		this->savePrivateKey(base64PrivateKey);
+/// <summary>
+/// Prints the calls on the socket and on files, and the copies of payload, of the session so far
+/// </summary>
+void Client::printIoSummary() {
 
-		// save private key in field "private key"
-		this->privateKey = base64PrivateKey;
+	std::cout << std::endl << "I/O of the session:" << std::endl;
+	this->sockHandler.getSendCounter().write(std::cout, "socket send");
+	this->sockHandler.getReceiveCounter().write(std::cout, "socket receive");
+	this->fileHandler.getReadCounter().write(std::cout, "file read");
+	std::cout << std::setw(16) << "" << this->fileHandler.getOpens() << " files opened" << std::endl;
 
-		// Getting the public key
-		std::string publicKey = rsapriv.getPublicKey();
+	// copies of received bytes out of the read buffer, and of file content on its way to the socket
+	this->sockHandler.getCopyCounter().write(std::cout, "receive copy");
+	this->payloadCopyCounter.write(std::cout, "payload copy");
+}
 
-		// setting clien name at the payload
-		std::string payload = this->clientName;
+/// <summary>
+/// Loads paths of the files to send to server - a path can be a file, a directory or a manifest
+/// </summary>
+bool Client::loadFilePaths() {
+	StartupProfiler::Step step("load_file_list");
 
-		// appending the public key to the payload 
-		payload.append(publicKey);
+	try {
 
-		// creating a request of sending public key and getting AES key to the server with
-		// the payload of client name and public key
-		Request request(clientIdBytes, CLIENT_VERSION, CLIENT_CODE_SEND_PUBLIC_KEY, payload);
+		if (!std::filesystem::exists(SERVER_FILE_PATH)) {
+			return false;
+		}
 
-		// sending the request to server
-		if (!this->sendRequestToServer(request))
-			return;
+		// every line from the line of the file path onwards is an entry of files to send
+		std::vector<std::string> entries;
+		if (!this->fileHandler.readLines(SERVER_FILE_PATH, LINE_OF_FILE_PATH_TO_SEND, entries) || entries.empty()) {
+			Logger::error("Error in loading file path");
+			return false;
+		}
 
-		std::cout << "Sent request to server - sent public RSA key, asking for AES key" << std::endl;
+		this->filePaths.clear();
+		this->watchedDirectories.clear();
+		this->entryPriorities.clear();
+		for (const std::string& entry : entries)
+			this->expandFileEntry(entry, true, 0, this->filePaths);
 
-		// receiving response to the request from server
-		this->receiveResponseFromServer();
+		return !this->filePaths.empty();
 	}
+
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
+		return false;
 	}
 }
 
 /// <summary>
-/// Sends encrypted file to server
+/// Expands an entry of files to send into file paths
 /// </summary>
-/// <param name="path"></param>
-void Client::sendFileToServer() {
-
-	if (!this->connectedToServer) {
-		std::cout << "No connection to server" << std::endl;
-		return;
-	}
-
-	if (this->clientIdHex == "") {
-		std::cout << "Cannot perform the task of sending file. Registraion is needed first." << std::endl;
+/// <param name="entry">path of a file, path of a directory or '@' followed by path of a manifest,
+/// optionally followed by '|' and the priority of its files</param>
+/// <param name="allowManifest"></param>
+/// <param name="priority">priority of the entry if it has none - the priority of the manifest it is in</param>
+/// <param name="destination"></param>
+void Client::expandFileEntry(std::string entry, bool allowManifest, int priority, std::vector<std::string>& destination) {
+
+	// stripping white spaces (and a windows carriage return) from both sides of the entry
+	const std::string whiteSpaces = " \t\r";
+	size_t first = entry.find_first_not_of(whiteSpaces);
+	if (first == std::string::npos)
 		return;
-	}
+	entry = entry.substr(first, entry.find_last_not_of(whiteSpaces) - first + 1);
 
-	try {
-		if (this->loadFilePath() == false) {
-			std::cout << "Server File doesn't exist or couldn't be loaded properly." << std::endl;
-			return;
+	// splitting the priority from the end of the entry - files with a higher priority are sent first
+	size_t separator = entry.rfind(PRIORITY_SEPARATOR);
+	if (separator != std::string::npos) {
+		try {
+			priority = std::stoi(entry.substr(separator + 1));
 		}
-
-		// creating a request to send to sever with the relevant information
-		Request request = Request(this->clientIdBytes, CLIENT_VERSION, CLIENT_CODE_SEND_FILE);
-
-		// creating a file item to send to sever with the relevant information
-		// file item gets its information from method "loadFileContent"
-		FileItem fileItem;
-		if (this->loadFileContent(this->filePath, fileItem) == false) {
-			std::cout << "File in path: " << filePath << " doesn't exist" << std::endl;
-			return;
+		catch (std::exception&) {
+			Logger::warning("Invalid priority in entry", { { "entry", entry }, { "priority", priority } });
 		}
+		entry = entry.substr(0, entry.find_last_not_of(whiteSpaces, separator - 1) + 1);
+		if (entry.empty())
+			return;
+	}
 
-		std::cout << "Sending file request to server - file: \"" << fileItem.getFilename() << "\"" << std::endl;
-
-		// sending request to server with request and file item objects
-		if (!this->sendRequestToServer(request, fileItem))
+	// a manifest holds an entry in each line - manifests inside a manifest are not expanded
+	if (entry[0] == MANIFEST_PREFIX) {
+		std::vector<std::string> manifestEntries;
+		if (!allowManifest || !this->fileHandler.readLines(entry.substr(1), 1, manifestEntries)) {
+			Logger::error("Error in loading manifest", { { "manifest", entry.substr(1) } });
 			return;
+		}
 
-		std::cout << "Waiting for response from server. Server needs to calculate cksum. It may take a while. Please wait..." << std::endl;
-		this->receiveResponseFromServer();
+		for (const std::string& manifestEntry : manifestEntries)
+			this->expandFileEntry(manifestEntry, false, priority, destination);
+		return;
 	}
 
-	catch (std::exception& e)
-	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+	// a directory is expanded to all the files inside it, and is watched in watch mode
+	// its priority applies to the files written in it later as well
+	if (std::filesystem::is_directory(entry)) {
+		if (!this->fileHandler.listFiles(entry, destination))
+			Logger::error("Error in listing directory", { { "directory", entry } });
+		this->watchedDirectories.push_back(entry);
+		this->entryPriorities[entry] = priority;
+		return;
 	}
 
+	// converting filepath to lowercase
+	std::transform(entry.begin(), entry.end(), entry.begin(), ::tolower);
+	destination.push_back(entry);
+	this->entryPriorities[entry] = priority;
 }
 
-
 /// <summary>
-/// Loads path of the file to send to server
+/// Returns priority of a file - of its own entry, or of the closest directory entry it is in
 /// </summary>
-bool Client::loadFilePath() {
-
-	try {
-
-		if (!std::filesystem::exists(SERVER_FILE_PATH)) {
-			return false;
-		}
+/// <param name="filePath"></param>
+/// <returns></returns>
+int Client::priorityOf(const std::string& filePath) {
+
+	auto it = this->entryPriorities.find(filePath);
+	if (it != this->entryPriorities.end())
+		return it->second;
+
+	// the longest directory entry that holds the file is the closest one
+	int priority = 0;
+	size_t closestLength = 0;
+	for (const auto& entry : this->entryPriorities) {
+		const std::string& directoryPath = entry.first;
+		if (directoryPath.size() <= closestLength || filePath.compare(0, directoryPath.size(), directoryPath) != 0)
+			continue;
+
+		char next = filePath.size() > directoryPath.size() ? filePath[directoryPath.size()] : '\0';
+		bool endsWithSeparator = directoryPath.back() == '/' || directoryPath.back() == '\\';
+		if (!endsWithSeparator && next != '/' && next != '\\')
+			continue;
+
+		priority = entry.second;
+		closestLength = directoryPath.size();
+	}
 
-		if (!this->fileHandler.readLine(SERVER_FILE_PATH, LINE_OF_FILE_PATH_TO_SEND, this->filePath)) {
-			std::cout << "Error in loading file path." << std::endl;
-			return false;
-		}
+	return priority;
+}
 
-		// converting filepath to lowercase
-		std::transform(this->filePath.begin(), this->filePath.end(), this->filePath.begin(), ::tolower);
+/// <summary>
+/// Orders the files of the batch by priority, and by size class within the same priority (shortest job first)
+/// </summary>
+void Client::orderUploads() {
 
-		return true;
+	std::vector<size_t> sizeClasses;
+	for (const UploadResult& result : this->uploadResults) {
+		std::error_code error;
+		uint64_t fileSize = std::filesystem::file_size(result.filePath, error);
+		sizeClasses.push_back(error ? 0 : UploadScheduler::sizeClassOf(fileSize));
 	}
 
-	catch (std::exception& e)
-	{
-		std::cerr << "Exception: " << e.what() << std::endl;
-		return false;
-	}
+	this->uploadOrder.resize(this->uploadResults.size());
+	for (size_t i = 0; i < this->uploadOrder.size(); i++)
+		this->uploadOrder[i] = i;
+
+	// files of the same priority and size class keep the order of the batch
+	std::stable_sort(this->uploadOrder.begin(), this->uploadOrder.end(), [this, &sizeClasses](size_t left, size_t right) {
+		if (this->uploadResults[left].priority != this->uploadResults[right].priority)
+			return this->uploadResults[left].priority > this->uploadResults[right].priority;
+		return sizeClasses[left] < sizeClasses[right];
+	});
 }
 
 /// <summary>
@@ -365,45 +1572,47 @@ bool Client::loadFilePath() {
 /// </summary>
 /// <param name="filePath"></param>
 /// <param name="item"></param>
-bool Client::loadFileContent(std::string filePath, FileItem& fileItem) {
+bool Client::loadFileContent(std::string filePath, FileItem& fileItem, uint32_t& cksum) {
 
 	char* buffer = { 0 };
 	try {
 
-		if (!std::filesystem::exists(this->filePath)) {
+		if (!std::filesystem::exists(filePath)) {
 			return false;
 		}
 
 		// extracting file name of file path
-		std::string filename = this->filePath.substr(this->filePath.find_last_of('\\') + 1);
+		std::string filename = std::filesystem::path(filePath).filename().string();
 
 		// setting buffer
-		//uint32_t actualBufferSize;
-		uint32_t fileSize = (uint32_t)std::filesystem::file_size(this->filePath);
+		uint64_t fileSize = std::filesystem::file_size(filePath);
+		if (fileSize > MAX_REQUEST_CONTENT_SIZE) {
+			Logger::error("File is too large to send without chunks", { { "path", filePath }, { "size", fileSize } });
+			return false;
+		}
 
 		// reading the content of the file and putting it in the buffer
-		std::cout << "Reading file \"" << filename << "\" from disk..." << std::endl;
-		if (!this->fileHandler.readFile(filePath, &buffer)) {
-			std::cout << "Failed reading the file." << std::endl;
+		Logger::debug("Reading file from disk", { { "file", filename } });
+		bool isRead = false;
+		{
+			PhaseProfiler::Span span(UploadPhase::Read);
+			isRead = this->fileHandler.readFile(filePath, &buffer);
+		}
+		if (!isRead) {
+			Logger::error("Failed reading the file", { { "path", filePath } });
 			return false;
 		}
 
-		// encrypting the content of the file and putting it inside a string
-		std::cout << "Encrypting file \"" << filename << "\"..." << std::endl;
-		std::string encryptedFileContent;
-		if (!this->encryptContent(buffer, fileSize, encryptedFileContent))
+		// compressing and encrypting the content of the file into the file item
+		if (!this->packContent(filename, buffer, (size_t)fileSize, fileItem))
 		{
-			std::cout << "Encryption failed." << std::endl;
 			if (buffer != nullptr)
 				delete[] buffer;
 			return false;
 		}
 
-		// creating a file item with the relevant information to send to server
-		fileItem = FileItem(this->clientIdBytes, filename, encryptedFileContent);
-
-		// doing a cksum calculation and putting the number inside field "cksumOfLastFile"
-		this->calculateCksum((unsigned char*)buffer, fileSize, this->cksumOfLastFile);
+		// doing a cksum calculation of the original content
+		this->calculateCksum((unsigned char*)buffer, (size_t)fileSize, cksum);
 
 		if (buffer != nullptr)
 			delete[] buffer;
@@ -413,7 +1622,7 @@ bool Client::loadFileContent(std::string filePath, FileItem& fileItem) {
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 
 		if (buffer != nullptr)
 			delete[] buffer;
@@ -422,6 +1631,61 @@ bool Client::loadFileContent(std::string filePath, FileItem& fileItem) {
 	}
 }
 
+/// <summary>
+/// Compresses (if the server knows the codec) and encrypts content into a file item to send to server
+/// </summary>
+/// <param name="filename"></param>
+/// <param name="content"></param>
+/// <param name="contentSize"></param>
+/// <param name="fileItem"></param>
+/// <returns></returns>
+bool Client::packContent(std::string filename, char* content, size_t contentSize, FileItem& fileItem) {
+
+	// compressing the content before encrypting it, if the server knows the codec
+	// the content is sent uncompressed when compression doesn't make it smaller
+	uint8_t codec = CODEC_NONE;
+	std::string compressedContent;
+	if (this->compressionCodec != CODEC_NONE && this->protocolVersion >= VERSION_COMPRESSION) {
+		Logger::debug("Compressing file", { { "file", filename } });
+		{
+			PhaseProfiler::Span span(UploadPhase::Compress);
+			compressedContent = CompressionWrapper::compress(content, contentSize, this->compressionCodec);
+		}
+
+		if (compressedContent.size() < contentSize) {
+			codec = this->compressionCodec;
+			Logger::debug("Compressed file", { { "file", filename }, { "size", contentSize },
+				{ "compressed_size", compressedContent.size() }, { "codec", CompressionWrapper::getCodecName(codec) } });
+		}
+		else
+			compressedContent.clear();
+	}
+
+	// encrypting the content and putting it inside a string
+	Logger::debug("Encrypting file", { { "file", filename } });
+	std::string encryptedContent;
+	bool isEncrypted = (codec == CODEC_NONE)
+		? this->encryptContent(content, contentSize, encryptedContent)
+		: this->encryptContent(compressedContent.data(), compressedContent.size(), encryptedContent);
+	if (!isEncrypted)
+	{
+		Logger::error("Encryption failed", { { "file", filename } });
+		return false;
+	}
+
+	// the size of the content is 32 bits in the request
+	if (encryptedContent.size() > MAX_REQUEST_CONTENT_SIZE) {
+		Logger::error("Content is too large to send in a request", { { "file", filename }, { "size", encryptedContent.size() } });
+		return false;
+	}
+
+	// creating a file item with the relevant information to send to server
+	// the encrypted content is moved into the file item, it is never copied on its way to the socket
+	fileItem = FileItem(this->clientIdBytes, filename, std::move(encryptedContent));
+	fileItem.setCodec(codec);
+	return true;
+}
+
 /// <summary>
 /// Encrypts content
 /// </summary>
@@ -432,6 +1696,7 @@ bool Client::loadFileContent(std::string filePath, FileItem& fileItem) {
 bool Client::encryptContent(char* content, size_t contentSize, std::string& encryptedContent) {
 
 	bool isSuccessful = false;
+	PhaseProfiler::Span span(UploadPhase::Encrypt);
 
 	try {
 		// getting AES key from field "aesKey" and converting it from string to
@@ -445,7 +1710,7 @@ bool Client::encryptContent(char* content, size_t contentSize, std::string& encr
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		isSuccessful = false;
 	}
 
@@ -458,19 +1723,25 @@ bool Client::encryptContent(char* content, size_t contentSize, std::string& encr
 /// <param name="content"></param>
 /// <param name="size"></param>
 /// <param name="result"></param>
-bool Client::calculateCksum(unsigned char* content, uint32_t size, uint32_t& result) {
+bool Client::calculateCksum(unsigned char* content, size_t size, uint32_t& result) {
 
 	CRC crc;
+	PhaseProfiler::Span span(UploadPhase::Cksum);
 
 	try {
-		crc.update((unsigned char*)content, size);
+		// the cksum is updated in pieces its 32 bit length can hold, so content of 4GB and more is cksummed whole
+		for (size_t offset = 0; offset < size;) {
+			uint32_t length = (uint32_t)std::min<size_t>(size - offset, UINT32_MAX);
+			crc.update(content + offset, length);
+			offset += length;
+		}
 		result = crc.digest();
 		return true;
 	}
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 		return false;
 	}
 }
@@ -489,24 +1760,24 @@ void Client::handleResponse(Response& response) {
 
 
 	case SERVER_CODE_REGISTRATION_OK:
-		std::cout << "Received response from server - successful registration" << std::endl << std::endl;
+		Logger::info("Received response from server - successful registration");
 		this->saveRegistrationDetails(response);
 		break;
 
 
 	case SERVER_CODE_REGISTRATION_ERR:
-		std::cout << "Received response from server - registration failed" << std::endl << std::endl;
+		Logger::info("Received response from server - registration failed");
 		break;
 
 
 	case SERVER_CODE_SWITCHING_KEYS:
-		std::cout << "Received response from server - received public key" << std::endl << std::endl;
+		Logger::info("Received response from server - received public key");
 		this->handleAESKeyFromServer(response);
 		break;
 
 
 	case SERVER_CODE_CKSUM_READY:
-		std::cout << "Received response from server - received cksum" << std::endl << std::endl;
+		Logger::debug("Received response from server - received cksum");
 		this->handleFileResponse(response);
 		break;
 
@@ -540,7 +1811,7 @@ void Client::saveRegistrationDetails(Response& response) {
 
 		// writing client name on first line of the file
 		if (!this->fileHandler.writeLines(path, this->clientName)) {
-			std::cout << "Error in saving client name on client details file." << std::endl;
+			Logger::error("Error in saving client name on client details file");
 		}
 
 		// looping over client id which is a vector of unsigned chars
@@ -564,12 +1835,12 @@ void Client::saveRegistrationDetails(Response& response) {
 		this->clientIdHex = oss.str();
 
 		if (!this->fileHandler.writeLines(path, this->clientIdHex)) {
-			std::cout << "Error in saving client id on client details file." << std::endl;
+			Logger::error("Error in saving client id on client details file");
 		}
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 }
 
@@ -580,35 +1851,40 @@ void Client::saveRegistrationDetails(Response& response) {
 void Client::handleFileResponse(Response& response) {
 
 	try {
-		ContentSizeHeader contentSizeHeader = { 0 };
-		std::string filename;
-		CksumHeader cksumHeader = { 0 };
-
-		// reading content size and storing it inside a variable
-		this->sockHandler.receive(contentSizeHeader.buffer, sizeof(uint32_t));
-		uint32_t contentSize = contentSizeHeader.contentSize;
+		if (this->protocolVersion < VERSION_PIPELINING) {
 
-		// reading filename with a determined length and storing it inside a string variable
-		filename.resize(FILENAME_LENGTH, '\0');
-		this->sockHandler.receive(filename, FILENAME_LENGTH);
+			// legacy layout - content size, filename with a determined length and cksum follow the response
+			std::string cksumData;
+			if (!this->sockHandler.receive(cksumData, sizeof(CksumData)))
+				return;
+			response.setPayload(std::move(cksumData));
+		}
 
-		// reading cksum and storing it inside a variable
-		this->sockHandler.receive(cksumHeader.buffer, sizeof(uint32_t));
-		uint32_t cksumFromServer = cksumHeader.cksum;
+		uint32_t contentSize = 0;
+		std::string filename;
+		uint32_t cksumFromServer = 0;
+		if (!this->parseCksumReply(response, contentSize, filename, cksumFromServer)) {
+			Logger::warning("Received malformed cksum response from server");
+			return;
+		}
 
-		// printing the cksum of file from this pc vs. cksum of the file from server
-		std::cout << "cksum from file in this pc:\t " << this->cksumOfLastFile << std::endl;
-		std::cout << "cksum from file saved in server: " << cksumFromServer << std::endl;
+		// logging the cksum of file from this pc vs. cksum of the file from server
+		Logger::info("Received cksum of file", { { "file", filename }, { "cksum", this->cksumOfLastFile },
+			{ "server_cksum", cksumFromServer } });
 
 		// creating a request with relevant information to send to the server
 		// code of request will be determined after comparison of client and server cksums
-		Request request(this->clientIdBytes, CLIENT_VERSION, filename);
+		Request request(this->clientIdBytes, this->protocolVersion, filename);
+		uint16_t code = this->getCksumRequestCode(this->cksumOfLastFile, cksumFromServer, this->numberOfTrialsTOSendFile);
+		if (code != CLIENT_CODE_CKSUM_OK)
+			ClientMetrics::recordCksumFailure(this->numberOfTrialsTOSendFile);
 
-		if (this->cksumOfLastFile == cksumFromServer) {
+		if (code == CLIENT_CODE_CKSUM_OK) {
 
 			// sending a request announcing that
 			// the cksums of client (original) file and server file are equal
-			std::cout << "Cksum succeded" << std::endl;
+			Logger::debug("Cksum succeded", { { "file", filename } });
+			this->lastFileStatus = UploadStatus::Verified;
 			request.setCode(CLIENT_CODE_CKSUM_OK);
 			if (!this->sendRequestToServer(request))
 				return;
@@ -616,16 +1892,15 @@ void Client::handleFileResponse(Response& response) {
 			// receiving a response to the file request from the server
 			this->receiveResponseFromServer();
 		}
-		else if (this->numberOfTrialsTOSendFile < NUMBER_OF_FILE_SENDING)
+		else if (code == CLIENT_CODE_CKSUM_ERR)
 		{
 			// cksums of client(original) file and server file are not equal
-			std::cout << "Cksum failed " << this->numberOfTrialsTOSendFile << " time/s" << std::endl << std::endl;
+			Logger::warning("Cksum failed, sending file again", { { "file", filename },
+				{ "trials", this->numberOfTrialsTOSendFile } });
 
 			// the client will re-send the file to the server
 			// number of trials is up by one
 			this->numberOfTrialsTOSendFile++;
-			std::cout << "SENDING FILE AGAIN: TRIAL NUMBER " << this->numberOfTrialsTOSendFile << std::endl;
-			std::cout << "------------------------------------" << std::endl;
 
 			// sending a request of that cksum failed and the client will re-send the file
 			request.setCode(CLIENT_CODE_CKSUM_ERR);
@@ -639,11 +1914,11 @@ void Client::handleFileResponse(Response& response) {
 		else {
 			// cksums of client(original) file and server file are not equal
 			// this was the last trial and client won't sending the file anymore
-			std::cout << "Cksum failed " << this->numberOfTrialsTOSendFile << " times" << std::endl;
-			std::cout << "This was the last time" << std::endl;
+			Logger::error("Cksum failed for the last time", { { "file", filename },
+				{ "trials", this->numberOfTrialsTOSendFile } });
+			this->lastFileStatus = UploadStatus::CksumFailed;
 
-			// reseting number of trials and cksum of a file
-			this->numberOfTrialsTOSendFile = 1;
+			// reseting cksum of a file
 			this->cksumOfLastFile = 0;
 
 			// creating a request with information of cksum failue for the last time
@@ -659,7 +1934,7 @@ void Client::handleFileResponse(Response& response) {
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 }
 
@@ -668,24 +1943,28 @@ void Client::handleFileResponse(Response& response) {
 /// </summary>
 void Client::reSendFileToServer() {
 
+	TraceRecorder::Span span("cksum_retry", "retry");
+	span.addArg("trial", this->numberOfTrialsTOSendFile);
+
 	try {
 		// loading the content of the file
 		FileItem fileItem;
-		this->loadFileContent(this->filePath, fileItem);
+		this->loadFileContent(this->filePath, fileItem, this->cksumOfLastFile);
 
 		// creating a request of sending a file
-		Request fileRequest(this->clientIdBytes, CLIENT_VERSION, CLIENT_CODE_SEND_FILE);
+		Request fileRequest(this->clientIdBytes, this->protocolVersion, CLIENT_CODE_SEND_FILE);
 
 		// sending the request with the file content
 		if (!this->sendRequestToServer(fileRequest, fileItem))
 			return;
+		ClientMetrics::addRetransmittedBytes(fileItem.getContentSize());
 
-		std::cout << "Waiting for response from server. Server needs to calculate cksum. It may take a while. Please wait..." << std::endl;
+		Logger::debug("Waiting for response from server. Server needs to calculate cksum");
 		this->receiveResponseFromServer();
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 }
 
@@ -697,7 +1976,8 @@ void Client::handleAESKeyFromServer(Response& response) {
 
 	try {
 		// this is the encrypted AES key as a string - needs to be encrypted
-		std::string aesKeyCipher = response.getPayload();
+		std::string aesKeyCipher(response.getPayload());
+		this->payloadCopyCounter.record(aesKeyCipher.size(), aesKeyCipher.size());
 
 		// creating an RSA decryptor using the existing private key of the client
 		RSAPrivateWrapper rsapriv_other(Base64Wrapper::decode(this->privateKey));
@@ -711,7 +1991,7 @@ void Client::handleAESKeyFromServer(Response& response) {
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 }
 
@@ -725,31 +2005,54 @@ bool Client::sendRequestToServer(Request& request) {
 
 	try {
 
+		// every request gets its own id, so its response can be matched to it
+		request.setRequestId(++this->lastRequestId);
+
+		bool isCksumRequest = request.getCode() == CLIENT_CODE_CKSUM_OK || request.getCode() == CLIENT_CODE_CKSUM_ERR
+			|| request.getCode() == CLIENT_CODE_CKSUM_ERR_FINAL;
+
+		// the filename without padding
+		std::string filename(request.getFilename().substr(0, request.getFilename().find('\0')));
+
+		// from compact framing the filename of a cksum request is its length prefixed payload
+		if (isCksumRequest && request.getVersion() >= VERSION_COMPACT_FRAMING) {
+			std::string payload;
+			Varint::appendString(payload, filename);
+			request.setPayload(std::move(payload));
+		}
+
 		// preparing the request header items to send to server
-		RequestHeader requestHeader = { 0 };
+		RequestHeader requestHeader = {};
 		requestHeader.requestData.clientId = request.getClientId();
 		requestHeader.requestData.version = request.getVersion();
 		requestHeader.requestData.code = request.getCode();
 		requestHeader.requestData.payloadSize = request.getPayloadSize();
 
 		// sending header items (meta-data) of request as a stream to server
-		this->sockHandler.send(requestHeader.buffer, sizeof(RequestData));
+		if (!this->sockHandler.send(requestHeader.buffer, sizeof(RequestData)))
+			return false;
+
+		// registration is always sent in the legacy layout - the version is negotiated by it
+		if (request.getCode() != CLIENT_CODE_REGISTER && !this->sendRequestId(request))
+			return false;
 
 		// if the payload is not empty - sending payload to server
-		if (request.getPayloadSize() > 0)
-			this->sockHandler.send(request.getPayload(), request.getPayloadSize());
+		if (request.getPayloadSize() > 0 && !this->sockHandler.send(request.getPayload(), request.getPayloadSize()))
+			return false;
 
-		// if the request is a cksum request - sending also filename
-		if (request.getCode() == CLIENT_CODE_CKSUM_OK || request.getCode() == CLIENT_CODE_CKSUM_ERR
-			|| request.getCode() == CLIENT_CODE_CKSUM_ERR_FINAL) {
-			this->sockHandler.send(request.getFilename(), FILENAME_LENGTH);
+		// legacy layout - a cksum request is followed by filename with a determined length
+		if (isCksumRequest && request.getVersion() < VERSION_COMPACT_FRAMING) {
+			filename.resize(FILENAME_LENGTH, '\0');
+			if (!this->sockHandler.send(filename, FILENAME_LENGTH))
+				return false;
 		}
 
+		this->trackRequest(request);
 		isSuccessful = true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 
 	return isSuccessful;
@@ -763,60 +2066,147 @@ bool Client::sendRequestToServer(Request& request) {
 bool Client::sendRequestToServer(Request& request, FileItem& fileItem) {
 
 	bool isSuccessful = false;
+	PhaseProfiler::Span span(UploadPhase::Send);
 
 	try {
 
+		// every request gets its own id, so its response can be matched to it
+		request.setRequestId(++this->lastRequestId);
+
 		// preparing the request header items to send to server
-		RequestHeader requestHeader = { 0 };
+		RequestHeader requestHeader = {};
 		requestHeader.requestData.clientId = request.getClientId();
 		requestHeader.requestData.version = request.getVersion();
 		requestHeader.requestData.code = request.getCode();
 		requestHeader.requestData.payloadSize = request.getPayloadSize();
 
+		if (request.getVersion() >= VERSION_COMPACT_FRAMING) {
+
+			// the payload is the length prefixed filename followed by the encrypted content
+			// from compression version on, the codec of the content comes between them
+			std::string_view filename = fileItem.getFilename();
+			std::string filenameData;
+			Varint::appendString(filenameData, std::string(filename.substr(0, filename.find('\0'))));
+			if (request.getVersion() >= VERSION_COMPRESSION)
+				filenameData.push_back((char)fileItem.getCodec());
+
+			// a chunk carries its place in the file, so chunks can be written in any order
+			if (request.getCode() == CLIENT_CODE_SEND_CHUNK) {
+				Varint::append(filenameData, fileItem.getOffset());
+				Varint::append(filenameData, fileItem.getFileSize());
+			}
+			uint64_t payloadSize = filenameData.size() + (uint64_t)fileItem.getContentSize();
+			if (payloadSize > UINT32_MAX) {
+				Logger::error("Request is too large to send", { { "file", filename }, { "size", payloadSize } });
+				return false;
+			}
+			requestHeader.requestData.payloadSize = (uint32_t)payloadSize;
+
+			if (!this->sockHandler.send(requestHeader.buffer, sizeof(RequestData))
+				|| !this->sendRequestId(request)
+				|| !this->sockHandler.send(filenameData, filenameData.size())
+				|| !this->sockHandler.send(fileItem.getMessageContent(), fileItem.getContentSize()))
+				return false;
+
+			this->trackRequest(request);
+			return true;
+		}
+
 		// sending header items (meta-data) of request as a stream to server
-		this->sockHandler.send(requestHeader.buffer, sizeof(RequestData));
+		if (!this->sockHandler.send(requestHeader.buffer, sizeof(RequestData)))
+			return false;
 
+		if (!this->sendRequestId(request))
+			return false;
 
 		// preparing the file header items to send to server
-		FileHeader fileHeader = { 0 };
+		FileHeader fileHeader = {};
 		fileHeader.fileData.clientId = fileItem.getClientId();
 		fileHeader.fileData.contentSize = fileItem.getContentSize();
 
 		// sending header items (meta-data) of file item as a stream to server
-		this->sockHandler.send(fileHeader.buffer, sizeof(FileData));
+		if (!this->sockHandler.send(fileHeader.buffer, sizeof(FileData)))
+			return false;
 
 		// sending filename to server
-		this->sockHandler.send(fileItem.getFilename().data(), FILENAME_LENGTH);
+		if (!this->sockHandler.send(fileItem.getFilename(), FILENAME_LENGTH))
+			return false;
 
 		// sending content of the file to server
-		this->sockHandler.send(fileItem.getMessageContent(), fileItem.getContentSize());
+		if (!this->sockHandler.send(fileItem.getMessageContent(), fileItem.getContentSize()))
+			return false;
 
+		this->trackRequest(request);
 		isSuccessful = true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 
 	return isSuccessful;
 }
 
+/// <summary>
+/// Remembers a sent request which the server answers, and when it was sent if its round trip is sampled
+/// </summary>
+/// <param name="request"></param>
+void Client::trackRequest(Request& request) {
+
+	// requests have ids from pipelining on, registration is sent in the legacy layout, and a failed cksum which is
+	// not final is not answered - so it would never be forgotten
+	uint16_t code = request.getCode();
+	if (request.getVersion() < VERSION_PIPELINING || code == CLIENT_CODE_REGISTER || code == CLIENT_CODE_CKSUM_ERR)
+		return;
+
+	// the server answers the requests of a connection one after the other, so the round trip of a request sent behind
+	// others would include the server handling them - only requests without file content which nothing is ahead of
+	// are sampled, so an adaptive rate limit backs off for the network and not for the server's cpu or disk
+	bool isSampled = this->awaitedRequests.empty() && (code == CLIENT_CODE_CKSUM_OK
+		|| code == CLIENT_CODE_CKSUM_ERR_FINAL || code == CLIENT_CODE_FILE_DIGEST);
+	if (isSampled)
+		this->requestSentAt[request.getRequestId()] = std::chrono::steady_clock::now();
+
+	this->awaitedRequests.insert(request.getRequestId());
+}
+
+/// <summary>
+/// Receives response from server and handles it
+/// </summary>
+bool Client::receiveResponseFromServer() {
+
+	Response response;
+	if (!this->receiveResponse(response))
+		return false;
+
+	this->handleResponse(response);
+	return true;
+}
+
 /// <summary>
 /// Receives response from server
 /// </summary>
 /// <param name="response"></param>
-bool Client::receiveResponseFromServer() {
+bool Client::receiveResponse(Response& response) {
 
 	bool isSuccessful = false;
 
 	try {
 		// setting stream buffers
-		ResponseHeader responseHeader = { 0 };
+		ResponseHeader responseHeader = {};
+		RequestIdHeader requestIdHeader = {};
 
-		boost::system::error_code error_code;
+		// receiving the whole fixed part of the response at once, its fields are parsed from the read buffer
+		size_t fixedSize = sizeof(ResponseData) + UUID_LENGTH;
+		if (this->protocolVersion >= VERSION_PIPELINING)
+			fixedSize += sizeof(uint32_t);
+
+		if (!this->sockHandler.fill(fixedSize))
+			return false;
 
 		// reading response header from server
-		this->sockHandler.receive(responseHeader.buffer, sizeof(ResponseData));
+		if (!this->sockHandler.receive(responseHeader.buffer, sizeof(ResponseData)))
+			return false;
 
 		// storing the header items inside relevant variables
 		uint8_t version = responseHeader.responseData.version;
@@ -825,7 +2215,12 @@ bool Client::receiveResponseFromServer() {
 
 		// reading client id from server
 		std::array<unsigned char, UUID_LENGTH> clientId = { 0 };
-		this->sockHandler.receive(clientId.data(), UUID_LENGTH);
+		if (!this->sockHandler.receive(clientId.data(), UUID_LENGTH))
+			return false;
+
+		// reading id of the request this response answers
+		if (this->protocolVersion >= VERSION_PIPELINING && !this->sockHandler.receive(requestIdHeader.buffer, sizeof(uint32_t)))
+			return false;
 
 		// setting payload buffer
 		std::string payload;
@@ -833,25 +2228,49 @@ bool Client::receiveResponseFromServer() {
 		// if there's payload - receiving it from server
 		if (payloadSize > 0) {
 			payload.resize(payloadSize);
-			this->sockHandler.receive(payload, payloadSize);
+			if (!this->sockHandler.receive(payload, payloadSize))
+				return false;
 		}
 
 		// creating a response object with information received from server
-		Response response(version, code, clientId, payload);
-
-		this->handleResponse(response);
+		response = Response(version, code, clientId, std::move(payload));
+		response.setRequestId(requestIdHeader.requestId);
+
+		// the round trip of the request lets an adaptive rate limit back off while queues build up
+		auto sentAt = this->requestSentAt.find(requestIdHeader.requestId);
+		if (sentAt != this->requestSentAt.end()) {
+			this->sockHandler.onRoundTrip(std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - sentAt->second));
+			this->requestSentAt.erase(sentAt);
+		}
+		this->awaitedRequests.erase(requestIdHeader.requestId);
 
 		isSuccessful = true;
 	}
 
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 
 	return isSuccessful;
 }
 
+/// <summary>
+/// Sends id of the request, if the version of the request has request ids
+/// </summary>
+/// <param name="request"></param>
+bool Client::sendRequestId(Request& request) {
+
+	if (request.getVersion() < VERSION_PIPELINING)
+		return true;
+
+	RequestIdHeader requestIdHeader = {};
+	requestIdHeader.requestId = request.getRequestId();
+
+	return this->sockHandler.send(requestIdHeader.buffer, sizeof(uint32_t));
+}
+
 /// <summary>
 /// Clears buffer
 /// </summary>
@@ -863,34 +2282,42 @@ void Client::clearBuffer(char message[], int length) {
 }
 
 /// <summary>
-/// Calculates cksum
+/// Calculates cksum of a file, reading it chunk by chunk
 /// </summary>
-/// <param name="path"></param>
+/// <param name="filePath"></param>
+/// <param name="result"></param>
 /// <returns></returns>
-uint32_t Client::calculateCksum(std::string filePath) {
-	uint32_t cksum = 0;
-	std::ifstream fileToCheck;
+bool Client::calculateCksum(std::string filePath, uint32_t& result) {
 
-	// getting the size of the file according to the file path
-	uint32_t fileSize = (uint32_t)std::filesystem::file_size(filePath);
+	bool isSuccessful = false;
+	std::ifstream fileToCheck;
 
-	// creating the new stream buffer with the relevant size
-	char* buffer = new char[fileSize];
+	// the file is read as it is cksummed, so its reading is timed as part of the cksum
+	PhaseProfiler::Span span(UploadPhase::Cksum);
 
 	try {
-		fileToCheck.read(buffer, fileSize);
+		fileToCheck.open(filePath, std::fstream::binary);
+		if (!fileToCheck.is_open())
+			return false;
 
-		// calculatin cksum and putting the number inside cksum
+		// calculating cksum chunk by chunk, so the file is never held in memory as a whole
 		CRC crc;
-		crc.update((unsigned char*)buffer, fileSize);
-		cksum = crc.digest();
+		std::vector<char> buffer(CKSUM_CHUNK_SIZE);
+		while (fileToCheck.read(buffer.data(), buffer.size()) || fileToCheck.gcount() > 0)
+			crc.update((unsigned char*)buffer.data(), (uint32_t)fileToCheck.gcount());
+
+		result = crc.digest();
+		isSuccessful = true;
 	}
 	catch (std::exception& e)
 	{
-		std::cerr << "Exception: " << e.what() << std::endl;
+		Logger::error("Exception", { { "error", e.what() } });
 	}
 
-	return cksum;
+	if (fileToCheck.is_open())
+		fileToCheck.close();
+
+	return isSuccessful;
 }
 
 /// <summary>
@@ -16,6 +16,23 @@
 #include <algorithm>
 #include "FileHandler.h"
 #include "SocketHandler.h"
+#include "ClientOptions.h"
+#include "Varint.h"
+#include "CompressionWrapper.h"
+#include "DeltaEncoder.h"
+#include "DirectoryWatcher.h"
+#include "ThreadPool.h"
+#include "UploadScheduler.h"
+#include "PhaseProfiler.h"
+#include "ClientMetrics.h"
+#include "Logger.h"
+#include "IoCounter.h"
+#include "StartupProfiler.h"
+#include <future>
+#include <map>
+#include <deque>
+#include <set>
+#include <random>
 
 using boost::asio::ip::tcp;
 
@@ -24,10 +41,76 @@ const size_t CLIENT_ID = 2;
 const size_t PRIVATE_KEY = 3;
 const std::string CLIENT_DETAILS_PATH = "me.info";
 const uint8_t CLIENT_NAME_LENGTH = 255;
-const uint8_t CLIENT_VERSION = 3;
+const uint8_t CLIENT_VERSION = 9;
 const int LINE_OF_PRIVATE_KEY = 3;
 const int LINE_OF_FILE_PATH_TO_SEND = 3;
 const int NUMBER_OF_FILE_SENDING = 4;
+const char MANIFEST_PREFIX = '@';
+const char PRIORITY_SEPARATOR = '|';
+const size_t CKSUM_CHUNK_SIZE = 64 * 1024;
+const size_t PREPARED_FILE_POLL_MS = 5;
+const size_t CHUNK_SIZE = 4 * 1024 * 1024;
+const size_t BURST_PER_SECOND = 10;
+const size_t MAX_RECONNECT_BACKOFF_MS = 30000;
+const uint64_t MAX_REQUEST_CONTENT_SIZE = UINT32_MAX - 64 * 1024;	// payload size is 32 bits - room for filename and padding
+
+/// <summary>
+/// Final status of a single file of a batch upload
+/// </summary>
+enum class UploadStatus {
+	Pending,
+	Verified,
+	Unchanged,
+	CksumFailed,
+	ReadFailed,
+	TooLarge,
+	DuplicateName,
+	SendFailed
+};
+
+/// <summary>
+/// Outcome of a single file of a batch upload
+/// </summary>
+struct UploadResult {
+	std::string filePath;
+	UploadStatus status;
+	unsigned short trials;
+	uint32_t cksum = 0;
+	bool hasCksum = false;
+	int priority = 0;
+	std::set<uint64_t> ackedChunks;
+};
+
+/// <summary>
+/// File of a pipelined batch which waits for a response from server
+/// </summary>
+struct FileTransfer {
+	size_t resultIndex;
+	std::string filename;
+	uint32_t cksum;
+	UploadStatus status;
+	uint64_t chunkOffset = 0;
+	std::chrono::steady_clock::time_point sentAt;
+};
+
+/// <summary>
+/// File of a batch read, compressed, encrypted and cksummed by the thread pool
+/// </summary>
+struct PreparedFile {
+	bool isLoaded;
+	FileItem fileItem;
+	uint32_t cksum;
+	size_t memory;
+	bool isDelta = false;
+};
+
+/// <summary>
+/// Block signatures of the copy of a file saved in server, which the file is sent as a delta against
+/// </summary>
+struct DeltaBasis {
+	size_t blockSize;
+	std::vector<BlockSignature> signatures;
+};
 
 class Client {
 
@@ -41,9 +124,37 @@ private:
 	uint32_t cksumOfLastFile;
 	unsigned short numberOfTrialsTOSendFile;
 	std::string filePath;
+	std::vector<std::string> filePaths;
+	std::vector<std::string> watchedDirectories;
+	std::map<std::string, int> entryPriorities;
+	std::vector<UploadResult> uploadResults;
+	std::vector<size_t> uploadOrder;
+	std::map<std::string, std::string> serverFilenames;
+	UploadStatus lastFileStatus;
+	uint8_t protocolVersion;
+	uint32_t lastRequestId;
+	size_t windowSize;
+	uint8_t compressionCodec;
+	size_t watchDebounceMs;
 	bool connectedToServer;
+	bool lazyInit;
+	size_t maxReconnects;
+	size_t reconnectBackoffMs;
+	std::mt19937 random;
 	FileHandler fileHandler;
 	SocketHandler sockHandler;
+	std::map<size_t, std::future<PreparedFile>> preparedDigests;
+	std::map<std::pair<size_t, uint64_t>, std::future<PreparedFile>> preparedContents;
+	std::deque<std::pair<size_t, uint64_t>> admissionOrder;
+	std::map<size_t, std::shared_ptr<const DeltaBasis>> deltaBases;
+	UploadScheduler scheduler;
+	std::map<uint32_t, std::chrono::steady_clock::time_point> requestSentAt;
+	std::set<uint32_t> awaitedRequests;
+	IoCounter payloadCopyCounter;
+	std::future<std::string> pendingPrivateKey;
+
+	// declared last, so its workers are joined before the members they use are destroyed
+	ThreadPool threadPool;
 
 	/// <summary>
 	/// Loads host and port from file
@@ -76,16 +187,235 @@ private:
 	void savePrivateKey(std::string privateKey);
 
 	/// <summary>
-	/// Loads path of the file to send to server
+	/// Loads paths of the files to send to server - a path can be a file, a directory or a manifest
+	/// </summary>
+	bool loadFilePaths();
+
+	/// <summary>
+	/// Expands an entry of files to send into file paths
+	/// </summary>
+	/// <param name="entry">path of a file, path of a directory or '@' followed by path of a manifest,
+	/// optionally followed by '|' and the priority of its files</param>
+	/// <param name="allowManifest"></param>
+	/// <param name="priority">priority of the entry if it has none - the priority of the manifest it is in</param>
+	/// <param name="destination"></param>
+	void expandFileEntry(std::string entry, bool allowManifest, int priority, std::vector<std::string>& destination);
+
+	/// <summary>
+	/// Returns priority of a file - of its own entry, or of the closest directory entry it is in
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <returns></returns>
+	int priorityOf(const std::string& filePath);
+
+	/// <summary>
+	/// Orders the files of the batch by priority, and by size class within the same priority (shortest job first)
+	/// </summary>
+	void orderUploads();
+
+	/// <summary>
+	/// Takes the name a file is saved under in server for the session, unless another file already took it -
+	/// the server keeps the files of a client by their lowercase name only
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <param name="owner">path of the file which took the name</param>
+	/// <returns>false if the name belongs to another file</returns>
+	bool claimServerFilename(const std::string& filePath, std::string& owner);
+
+	/// <summary>
+	/// Uploads a batch of files over the authenticated connection and prints its summary
+	/// </summary>
+	/// <param name="filePaths"></param>
+	/// <returns>false if the connection broke during the batch</returns>
+	bool uploadFiles(const std::vector<std::string>& filePaths);
+
+	/// <summary>
+	/// Sends a single encrypted file to server and waits for its cksum verification
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <returns>final status of the file</returns>
+	UploadStatus sendFileToServer(std::string filePath);
+
+	/// <summary>
+	/// Sends the pending files of the batch one after the other, waiting for each file to be verified
+	/// </summary>
+	/// <returns>false if the connection broke during the batch</returns>
+	bool sendFilesLockStep();
+
+	/// <summary>
+	/// Sends the pending files of the batch keeping up to window size files in flight,
+	/// matching responses to their requests by request id
+	/// </summary>
+	/// <returns>false if the connection broke during the batch</returns>
+	bool sendFilesPipelined();
+
+	/// <summary>
+	/// Connects to server again and authenticates the new connection, waiting longer before every attempt
+	/// </summary>
+	/// <returns>false if all the attempts failed</returns>
+	bool reconnect();
+
+	/// <summary>
+	/// Waits for the files the thread pool is still preparing and returns their memory to the scheduler - they read
+	/// the key, version and client id of the session, so they are done before a new session changes them
+	/// </summary>
+	void drainPreparedFiles();
+
+	/// <summary>
+	/// Connects, registers and exchanges keys the first time files are sent by a lazy client. The RSA key pair is
+	/// generated on another thread meanwhile, so it costs no time of its own before the first byte
+	/// </summary>
+	void startSession();
+
+	/// <summary>
+	/// Starts the transfer of a file of the batch - asks the server whether it already has the file,
+	/// if the server supports it, or sends the file right away
+	/// </summary>
+	/// <param name="resultIndex">index of the file in the upload results</param>
+	/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+	/// <returns>false if the connection is broken, true otherwise</returns>
+	bool startFileTransfer(size_t resultIndex, std::map<uint32_t, FileTransfer>& inFlight);
+
+	/// <summary>
+	/// Sends size and cksum of a file of the batch and adds it to the in-flight files
+	/// </summary>
+	/// <param name="resultIndex">index of the file in the upload results</param>
+	/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+	/// <returns>false if the connection is broken, true otherwise</returns>
+	bool sendFileDigest(size_t resultIndex, std::map<uint32_t, FileTransfer>& inFlight);
+
+	/// <summary>
+	/// Queues the content of a file of the batch in the scheduler - as a whole, or in chunks if the server supports it
+	/// </summary>
+	/// <param name="resultIndex">index of the file in the upload results</param>
+	void queueFileContent(size_t resultIndex);
+
+	/// <summary>
+	/// Hands the queued contents which fit in the memory budget to the thread pool to be loaded, compressed,
+	/// encrypted and cksummed
+	/// </summary>
+	void admitFileContents();
+
+	/// <summary>
+	/// Returns number of files of the batch which are started and not completed yet
+	/// </summary>
+	/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+	/// <returns></returns>
+	size_t countActiveFiles(const std::map<uint32_t, FileTransfer>& inFlight);
+
+	/// <summary>
+	/// Queues the cksum of the next files of the batch in the thread pool, ahead of their digest requests
 	/// </summary>
-	bool loadFilePath();
+	/// <param name="nextFile">place in the upload order of the next file to start</param>
+	void queueFileDigests(size_t nextFile);
+
+	/// <summary>
+	/// Queues the cksum of a file of the batch in the thread pool, unless it is already queued
+	/// </summary>
+	/// <param name="resultIndex">index of the file in the upload results</param>
+	void queueFileDigest(size_t resultIndex);
+
+	/// <summary>
+	/// Calculates cksum of a file in a thread of the pool
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <returns></returns>
+	PreparedFile prepareDigest(std::string filePath);
+
+	/// <summary>
+	/// Loads, compresses and encrypts content of a file in a thread of the pool - the whole file or a chunk of it
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <param name="job"></param>
+	/// <returns></returns>
+	PreparedFile prepareContent(std::string filePath, ContentJob job);
+
+	/// <summary>
+	/// Loads a file, encodes it as a delta against the copy saved in server, and compresses and encrypts the delta
+	/// in a thread of the pool
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <param name="job"></param>
+	/// <param name="basis"></param>
+	/// <returns></returns>
+	PreparedFile prepareDelta(std::string filePath, ContentJob job, std::shared_ptr<const DeltaBasis> basis);
+
+	/// <summary>
+	/// Sends the queued files whose preparation is done, in the order the scheduler admitted them, and adds them to the in-flight files
+	/// </summary>
+	/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+	/// <returns>false if the connection is broken, true otherwise</returns>
+	bool sendPreparedFiles(std::map<uint32_t, FileTransfer>& inFlight);
+
+	/// <summary>
+	/// Queues a file of the batch in the scheduler, to be sent as a delta against the copy saved in server
+	/// </summary>
+	/// <param name="resultIndex">index of the file in the upload results</param>
+	/// <param name="response">response with the block signatures of the copy saved in server</param>
+	void queueFileDelta(size_t resultIndex, Response& response);
+
+	/// <summary>
+	/// Handles response from server to a request of an in-flight file
+	/// </summary>
+	/// <param name="response"></param>
+	/// <param name="transfer"></param>
+	/// <param name="inFlight">in-flight files by id of the request that waits for a response</param>
+	/// <returns>false if the connection is broken, true otherwise</returns>
+	bool handlePipelinedResponse(Response& response, FileTransfer& transfer, std::map<uint32_t, FileTransfer>& inFlight);
+
+	/// <summary>
+	/// Parses content size, filename and cksum of the file saved in server from a cksum response
+	/// </summary>
+	/// <param name="response"></param>
+	/// <param name="contentSize"></param>
+	/// <param name="filename"></param>
+	/// <param name="cksum"></param>
+	/// <returns>false if the payload of the response is malformed</returns>
+	bool parseCksumReply(Response& response, uint32_t& contentSize, std::string& filename, uint32_t& cksum);
+
+	/// <summary>
+	/// Returns the code of the request that answers a cksum from server
+	/// </summary>
+	/// <param name="clientCksum"></param>
+	/// <param name="serverCksum"></param>
+	/// <param name="trials">number of times the file was sent</param>
+	/// <returns>cksum ok, cksum error or cksum error for the last time</returns>
+	uint16_t getCksumRequestCode(uint32_t clientCksum, uint32_t serverCksum, unsigned short trials);
+
+	/// <summary>
+	/// Returns the label of a final status of a file, as it is counted in the metrics
+	/// </summary>
+	/// <param name="status"></param>
+	/// <returns></returns>
+	static std::string getStatusLabel(UploadStatus status);
+
+	/// <summary>
+	/// Prints summary of the outcome of each file of the batch
+	/// </summary>
+	void printUploadSummary();
+
+	/// <summary>
+	/// Prints the calls on the socket and on files, and the copies of payload, of the session so far
+	/// </summary>
+	void printIoSummary();
 
 	/// <summary>
 	/// Loads content of file to send to server
 	/// </summary>
 	/// <param name="filePath"></param>
 	/// <param name="item"></param>
-	bool loadFileContent(std::string filePath, FileItem& item);
+	/// <param name="cksum">cksum of the original content</param>
+	bool loadFileContent(std::string filePath, FileItem& item, uint32_t& cksum);
+
+	/// <summary>
+	/// Compresses (if the server knows the codec) and encrypts content into a file item to send to server
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="content"></param>
+	/// <param name="contentSize"></param>
+	/// <param name="fileItem"></param>
+	/// <returns></returns>
+	bool packContent(std::string filename, char* content, size_t contentSize, FileItem& fileItem);
 
 	/// <summary>
 	/// Encrypts content
@@ -102,7 +432,7 @@ private:
 	/// <param name="content"></param>
 	/// <param name="size"></param>
 	/// <param name="result"></param>
-	bool calculateCksum(unsigned char* content, uint32_t size, uint32_t& result);
+	bool calculateCksum(unsigned char* content, size_t size, uint32_t& result);
 
 	/// <summary>
 	/// Handles file response
@@ -147,10 +477,28 @@ private:
 	bool sendRequestToServer(Request& request, FileItem& fileItem);
 
 	/// <summary>
-	/// Receives response from server
+	/// Sends id of the request, if the version of the request has request ids
+	/// </summary>
+	/// <param name="request"></param>
+	bool sendRequestId(Request& request);
+
+	/// <summary>
+	/// Remembers a sent request which the server answers, and when it was sent if its round trip is sampled
+	/// </summary>
+	/// <param name="request"></param>
+	void trackRequest(Request& request);
+
+	/// <summary>
+	/// Receives response from server and handles it
 	/// </summary>
 	bool receiveResponseFromServer();
 
+	/// <summary>
+	/// Receives response from server
+	/// </summary>
+	/// <param name="response"></param>
+	bool receiveResponse(Response& response);
+
 	/// <summary>
 	/// Clears buffer
 	/// </summary>
@@ -159,11 +507,12 @@ private:
 	void clearBuffer(char message[], int length);
 
 	/// <summary>
-	/// Calculates cksum
+	/// Calculates cksum of a file, reading it chunk by chunk
 	/// </summary>
-	/// <param name="path"></param>
+	/// <param name="filePath"></param>
+	/// <param name="result"></param>
 	/// <returns></returns>
-	uint32_t calculateCksum(std::string filePath);
+	bool calculateCksum(std::string filePath, uint32_t& result);
 
 public:
 	/// <summary>
@@ -171,6 +520,12 @@ public:
 	/// </summary>
 	Client();
 
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	/// <param name="options"></param>
+	Client(const ClientOptions& options);
+
 	/// <summary>
 	/// Dtor
 	/// </summary>
@@ -188,9 +543,14 @@ public:
 	void generateRSAKeyPair();
 
 	/// <summary>
-	/// Sends encrypted file to server
+	/// Sends all the encrypted files to server over the same connection
+	/// </summary>
+	void sendFilesToServer();
+
+	/// <summary>
+	/// Keeps running and uploads the files written in the directories to send, over the same connection
 	/// </summary>
-	void sendFileToServer();
+	void watchFilesToServer();
 
 	/// <summary>
 	/// Disconnect from server
@@ -13,6 +13,10 @@ FileItem::FileItem() {
 	this->contentSize = 0;
 	this->filename = "";
 	this->messageContent = "";
+	this->cksum = 0;
+	this->codec = 0;
+	this->offset = 0;
+	this->fileSize = 0;
 }
 
 /// <summary>
@@ -23,11 +27,14 @@ FileItem::FileItem() {
 	/// <param name="messageContent"></param>
 FileItem::FileItem(std::array<unsigned char, UUID_LENGTH_FILEITEM> clientId, std::string filename, std::string messageContent) {
 	this->clientId = clientId;
-	this->filename = filename;
+	this->filename = std::move(filename);
 	this->filename.resize(FILENAME_LENGTH, '\0');
-	this->messageContent = messageContent;
-	this->contentSize = messageContent.size();
+	this->messageContent = std::move(messageContent);
+	this->contentSize = (uint32_t)this->messageContent.size();
 	this->cksum = 0;
+	this->codec = 0;
+	this->offset = 0;
+	this->fileSize = 0;
 }
 
 /// <summary>
@@ -39,10 +46,12 @@ FileItem::FileItem(std::array<unsigned char, UUID_LENGTH_FILEITEM> clientId, std
 /// <param name="cksum"></param>
 FileItem::FileItem(std::array<unsigned char, UUID_LENGTH_FILEITEM> clientId, uint32_t contentSize, std::string filename, uint32_t cksum) {
 	this->clientId = clientId;
-	filename = filename.substr(filename.find_first_of('\0'));
-	this->filename = filename;
+	this->filename = filename.substr(0, filename.find_first_of('\0'));
 	this->contentSize = contentSize;
 	this->cksum = cksum;
+	this->codec = 0;
+	this->offset = 0;
+	this->fileSize = 0;
 }
 
 /// <summary>
@@ -67,8 +76,8 @@ std::array<unsigned char, UUID_LENGTH_FILEITEM> FileItem::getClientId() {
 /// <summary>
 /// Returns filename
 /// </summary>
-/// <returns></returns>
-std::string FileItem::getFilename() {
+/// <returns>view of the filename, valid as long as the file item is</returns>
+std::string_view FileItem::getFilename() {
 	return this->filename;
 }
 
@@ -83,8 +92,8 @@ uint32_t FileItem::getContentSize() {
 /// <summary>
 /// Returns message content
 /// </summary>
-/// <returns>message content</returns>
-std::string FileItem::getMessageContent() {
+/// <returns>view of the message content, valid as long as the file item is</returns>
+std::string_view FileItem::getMessageContent() {
 	return this->messageContent;
 }
 
@@ -94,4 +103,46 @@ std::string FileItem::getMessageContent() {
 /// <returns>cksum</returns>
 uint32_t FileItem::getCksum() {
 	return this->cksum;
+}
+
+/// <summary>
+/// Returns codec the message content is compressed with
+/// </summary>
+/// <returns>codec</returns>
+uint8_t FileItem::getCodec() {
+	return this->codec;
+}
+
+/// <summary>
+/// Sets codec the message content is compressed with
+/// </summary>
+/// <param name="codec"></param>
+void FileItem::setCodec(uint8_t codec) {
+	this->codec = codec;
+}
+
+/// <summary>
+/// Returns offset of the message content in the file, if the content is a chunk of the file
+/// </summary>
+/// <returns>offset</returns>
+uint64_t FileItem::getOffset() {
+	return this->offset;
+}
+
+/// <summary>
+/// Returns size of the whole file, if the message content is a chunk of the file
+/// </summary>
+/// <returns>size of the file</returns>
+uint64_t FileItem::getFileSize() {
+	return this->fileSize;
+}
+
+/// <summary>
+/// Sets the message content as a chunk of a file
+/// </summary>
+/// <param name="offset">offset of the chunk in the file</param>
+/// <param name="fileSize">size of the whole file</param>
+void FileItem::setChunk(uint64_t offset, uint64_t fileSize) {
+	this->offset = offset;
+	this->fileSize = fileSize;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@ Author: Elad Sheffer
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 
@@ -43,6 +44,23 @@ union CksumHeader
 	char buffer[sizeof(uint32_t)];
 };
 
+#pragma pack(push, 1)
+class CksumData {
+
+public:
+	// members
+	uint32_t contentSize;
+	char filename[FILENAME_LENGTH];
+	uint32_t cksum;
+};
+#pragma pack(pop)
+
+union CksumReplyHeader
+{
+	CksumData cksumData;
+	char buffer[sizeof(CksumData)];
+};
+
 class FileItem {
 private:
 
@@ -52,6 +70,9 @@ private:
 	std::string filename;
 	std::string messageContent;
 	uint32_t cksum;
+	uint8_t codec;
+	uint64_t offset;
+	uint64_t fileSize;
 
 public:
 	/// <summary>
@@ -76,6 +97,26 @@ public:
 	/// <param name="cksum"></param>
 	FileItem(std::array<unsigned char, UUID_LENGTH_FILEITEM> clientId, uint32_t content_size ,std::string filename, uint32_t cksum);
 
+	/// <summary>
+	/// Copy ctor
+	/// </summary>
+	FileItem(const FileItem& other) = default;
+
+	/// <summary>
+	/// Move ctor - takes over the message content without copying it
+	/// </summary>
+	FileItem(FileItem&& other) noexcept = default;
+
+	/// <summary>
+	/// Copy assignment
+	/// </summary>
+	FileItem& operator=(const FileItem& other) = default;
+
+	/// <summary>
+	/// Move assignment - takes over the message content without copying it
+	/// </summary>
+	FileItem& operator=(FileItem&& other) noexcept = default;
+
 	/// <summary>
 	/// Dtor
 	/// </summary>
@@ -90,8 +131,8 @@ public:
 	/// <summary>
 	/// Returns filename
 	/// </summary>
-	/// <returns></returns>
-	std::string getFilename();
+	/// <returns>view of the filename, valid as long as the file item is</returns>
+	std::string_view getFilename();
 
 	/// <summary>
 	/// Returns size of content
@@ -102,12 +143,43 @@ public:
 	/// <summary>
 	/// Returns message content
 	/// </summary>
-	/// <returns> message content</returns>
-	std::string getMessageContent();
+	/// <returns>view of the message content, valid as long as the file item is</returns>
+	std::string_view getMessageContent();
 
 	/// <summary>
 	/// Returns cksum
 	/// </summary>
 	/// <returns>cksum</returns>
 	uint32_t getCksum();
+
+	/// <summary>
+	/// Returns codec the message content is compressed with
+	/// </summary>
+	/// <returns>codec</returns>
+	uint8_t getCodec();
+
+	/// <summary>
+	/// Sets codec the message content is compressed with
+	/// </summary>
+	/// <param name="codec"></param>
+	void setCodec(uint8_t codec);
+
+	/// <summary>
+	/// Returns offset of the message content in the file, if the content is a chunk of the file
+	/// </summary>
+	/// <returns>offset</returns>
+	uint64_t getOffset();
+
+	/// <summary>
+	/// Returns size of the whole file, if the message content is a chunk of the file
+	/// </summary>
+	/// <returns>size of the file</returns>
+	uint64_t getFileSize();
+
+	/// <summary>
+	/// Sets the message content as a chunk of a file
+	/// </summary>
+	/// <param name="offset">offset of the chunk in the file</param>
+	/// <param name="fileSize">size of the whole file</param>
+	void setChunk(uint64_t offset, uint64_t fileSize);
 };
\ No newline at end of file
@@ -1,11 +1,56 @@
 #include "client.h"
 #include "RSAWrapper.h"
 #include "Base64Wrapper.h"
+#include "ClientOptions.h"
+#include "PhaseProfiler.h"
+#include "ClientMetrics.h"
+#include "StartupProfiler.h"
 
 int main(int argc, char* argv[])
 {
-	Client client;
-	client.registerToServer();
-	client.generateRSAKeyPair();
-	client.sendFileToServer();
-}
\ No newline at end of file
+	auto optionsStart = std::chrono::steady_clock::now();
+	ClientOptions options;
+	if (!ClientOptions::parse(argc, argv, options)) {
+		ClientOptions::printUsage();
+		return 1;
+	}
+
+	// started once the options are known - the parsing is recorded after the fact
+	if (!options.startupProfilePath.empty()) {
+		StartupProfiler::start(options.startupProfilePath);
+		StartupProfiler::record("options", optionsStart, std::chrono::steady_clock::now());
+	}
+
+	if (!options.latencyReportPath.empty())
+		PhaseProfiler::start(options.latencyReportPath);
+	if (!options.tracePath.empty())
+		TraceRecorder::start(options.tracePath);
+	ClientMetrics::setTextfilePath(options.metricsPath);
+	{
+		StartupProfiler::Step step("logger_start");
+		Logger::start(options.logLevel, options.logFormat);
+	}
+
+	{
+		auto initStart = std::chrono::steady_clock::now();
+		Client client(options);
+		StartupProfiler::record("client_init", initStart, std::chrono::steady_clock::now());
+
+		// a lazy client connects and exchanges keys only once there are files to send
+		if (!options.lazyInit) {
+			client.registerToServer();
+			client.generateRSAKeyPair();
+		}
+		client.sendFilesToServer();
+
+		if (options.watchDebounceMs > 0)
+			client.watchFilesToServer();
+	}
+
+	// after the client is gone, so the report and the trace cover the phases of its thread pool too
+	PhaseProfiler::stop();
+	StartupProfiler::stop();
+	TraceRecorder::stop();
+	ClientMetrics::flush();
+	Logger::stop();
+}
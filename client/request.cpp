@@ -14,6 +14,7 @@ Request::Request() {
 	this->code = 0;
 	this->payloadSize = 0;
 	this->payload = "";
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -26,8 +27,9 @@ Request::Request(uint8_t version, uint16_t code, std::string payload) {
 	this->clientId = { 0 };
 	this->version = version;
 	this->code = code;
-	this->payload = payload;
+	this->payload = std::move(payload);
 	this->payloadSize = (uint32_t)this->payload.size();
+	this->requestId = 0;
 }
 
 
@@ -44,6 +46,7 @@ Request::Request(std::array<unsigned char, UUID_LENGTH> clientId, uint8_t versio
 	this->code = code;
 	this->payloadSize = payloadSize;
 	this->payload = "";
+	this->requestId = 0;
 }
 
 
@@ -60,6 +63,7 @@ Request::Request(std::array<unsigned char, UUID_LENGTH> clientId, uint8_t versio
 	this->code = code;
 	this->payload = "";
 	this->payloadSize = 0;
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -73,8 +77,9 @@ Request::Request(std::array<unsigned char, UUID_LENGTH> clientId, uint8_t versio
 	this->clientId = clientId;
 	this->version = version;
 	this->code = code;
-	this->payload = payload;
-	this->payloadSize = (uint32_t)payload.size();
+	this->payload = std::move(payload);
+	this->payloadSize = (uint32_t)this->payload.size();
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -87,10 +92,11 @@ Request::Request(std::array<unsigned char, UUID_LENGTH> clientId, uint8_t versio
 Request::Request(std::array<unsigned char, UUID_LENGTH> clientId, uint8_t version, std::string filename) {
 	this->clientId = clientId;
 	this->version = version;
-	this->filename = filename;
+	this->filename = std::move(filename);
 	this->code = 0;
 	this->payloadSize = 0;
 	this->payload = "";
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -103,6 +109,7 @@ Request::~Request() {
 	this->filename = "";
 	this->payloadSize = 0;
 	this->payload = "";
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -133,8 +140,8 @@ uint16_t Request::getCode() {
 /// <summary>
 /// Returns filename
 /// </summary>
-/// <returns></returns>
-std::string Request::getFilename(){
+/// <returns>view of the filename, valid as long as the request is</returns>
+std::string_view Request::getFilename(){
 	return this->filename;
 }
 
@@ -150,17 +157,25 @@ uint32_t Request::getPayloadSize() {
 /// <summary>
 /// Returns payload
 /// </summary>
-/// <returns>payload</returns>
-std::string Request::getPayload() {
+/// <returns>view of the payload, valid as long as the request is</returns>
+std::string_view Request::getPayload() {
 	return this->payload;
 }
 
+/// <summary>
+/// Returns request id
+/// </summary>
+/// <returns>request id</returns>
+uint32_t Request::getRequestId() {
+	return this->requestId;
+}
+
 /// <summary>
 /// Sets filename
 /// </summary>
 /// <param name="filename"></param>
 void Request::setFilename(std::string filename) {
-	this->filename = filename;
+	this->filename = std::move(filename);
 }
 
 /// <summary>
@@ -168,8 +183,8 @@ void Request::setFilename(std::string filename) {
 /// </summary>
 /// <param name="payload"></param>
 void Request::setPayload(std::string payload) {
-	this->payload = payload;
-	this->payloadSize = (uint32_t)payload.size();
+	this->payload = std::move(payload);
+	this->payloadSize = (uint32_t)this->payload.size();
 }
 
 /// <summary>
@@ -180,6 +195,14 @@ void Request::setCode(uint16_t code) {
 	this->code = code;
 }
 
+/// <summary>
+/// Sets request id
+/// </summary>
+/// <param name="requestId"></param>
+void Request::setRequestId(uint32_t requestId) {
+	this->requestId = requestId;
+}
+
 /// <summary>
 /// Parses Request Header
 /// </summary>
@@ -9,6 +9,7 @@ Author: Elad Sheffer
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 
@@ -18,7 +19,17 @@ const uint16_t CLIENT_CODE_SEND_FILE = 1103;
 const uint16_t CLIENT_CODE_CKSUM_OK = 1104;
 const uint16_t CLIENT_CODE_CKSUM_ERR = 1105;
 const uint16_t CLIENT_CODE_CKSUM_ERR_FINAL = 1106;
+const uint16_t CLIENT_CODE_FILE_DIGEST = 1107;
+const uint16_t CLIENT_CODE_SEND_DELTA = 1108;
+const uint16_t CLIENT_CODE_SEND_CHUNK = 1109;
 const uint8_t UUID_LENGTH = 16;
+const uint8_t LEGACY_VERSION = 3;
+const uint8_t VERSION_PIPELINING = 4;
+const uint8_t VERSION_COMPACT_FRAMING = 5;
+const uint8_t VERSION_COMPRESSION = 6;
+const uint8_t VERSION_DEDUP = 7;
+const uint8_t VERSION_DELTA = 8;
+const uint8_t VERSION_CHUNKED = 9;
 
 #pragma pack(push, 1)
 class RequestData {
@@ -38,6 +49,12 @@ union RequestHeader
 	char buffer[sizeof(RequestData)];
 };
 
+union RequestIdHeader
+{
+	uint32_t requestId;
+	char buffer[sizeof(uint32_t)];
+};
+
 class Request {
 private:
 
@@ -48,6 +65,7 @@ private:
 	std::string filename;
 	std::string payload;
 	uint32_t payloadSize;
+	uint32_t requestId;
 
 public:
 	/// <summary>
@@ -97,6 +115,26 @@ public:
 	/// <param name="filename"></param>
 	Request(std::array<unsigned char, UUID_LENGTH> clientId, uint8_t version, std::string filename);
 
+	/// <summary>
+	/// Copy ctor
+	/// </summary>
+	Request(const Request& other) = default;
+
+	/// <summary>
+	/// Move ctor - takes over the payload without copying it
+	/// </summary>
+	Request(Request&& other) noexcept = default;
+
+	/// <summary>
+	/// Copy assignment
+	/// </summary>
+	Request& operator=(const Request& other) = default;
+
+	/// <summary>
+	/// Move assignment - takes over the payload without copying it
+	/// </summary>
+	Request& operator=(Request&& other) noexcept = default;
+
 	/// <summary>
 	/// Dtor
 	/// </summary>
@@ -124,8 +162,8 @@ public:
 	/// <summary>
 	/// Returns filename
 	/// </summary>
-	/// <returns></returns>
-	std::string getFilename();
+	/// <returns>view of the filename, valid as long as the request is</returns>
+	std::string_view getFilename();
 
 	/// <summary>
 	/// Returns size of payload
@@ -136,8 +174,14 @@ public:
 	/// <summary>
 	/// Returns payload
 	/// </summary>
-	/// <returns>payload</returns>
-	std::string getPayload();
+	/// <returns>view of the payload, valid as long as the request is</returns>
+	std::string_view getPayload();
+
+	/// <summary>
+	/// Returns request id
+	/// </summary>
+	/// <returns>request id</returns>
+	uint32_t getRequestId();
 
 	/// <summary>
 	/// Sets filename
@@ -157,6 +201,12 @@ public:
 	/// <param name="code"></param>
 	void setCode(uint16_t code);
 
+	/// <summary>
+	/// Sets request id
+	/// </summary>
+	/// <param name="requestId"></param>
+	void setRequestId(uint32_t requestId);
+
 	/// <summary>
 	/// Parses Request Header
 	/// </summary>
@@ -13,6 +13,7 @@ Response::Response() {
 	this->code = 0;
 	this->payload = "";
 	this->payloadSize = 0;
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -24,14 +25,16 @@ Response::Response(uint8_t version) {
 	this->code = 0;
 	this->payloadSize = 0;
 	this->payload = "";
+	this->requestId = 0;
 }
 
 Response::Response(uint8_t version, uint16_t code, std::array<unsigned char, UUID_LENGTH_RESPONSE> clientId, std::string payload) {
 	this->version = version;
 	this->code = code;
-	this->payload = payload;
-	this->payloadSize = (uint32_t)payload.size();
+	this->payload = std::move(payload);
+	this->payloadSize = (uint32_t)this->payload.size();
 	this->clientId = clientId;
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -43,6 +46,7 @@ Response::~Response() {
 	this->clientId = { 0 };
 	this->payload = "";
 	this->payloadSize = 0;
+	this->requestId = 0;
 }
 
 /// <summary>
@@ -80,11 +84,19 @@ std::array<unsigned char, UUID_LENGTH_RESPONSE> Response::getClientId() {
 /// <summary>
 /// Returns payload
 /// </summary>
-/// <returns>payload</returns>
-std::string Response::getPayload() {
+/// <returns>view of the payload, valid as long as the response is</returns>
+std::string_view Response::getPayload() {
 	return this->payload;
 }
 
+/// <summary>
+/// Returns id of the request this response answers
+/// </summary>
+/// <returns>request id</returns>
+uint32_t Response::getRequestId() {
+	return this->requestId;
+}
+
 /// <summary>
 /// Sets code
 /// </summary>
@@ -98,11 +110,19 @@ void Response::setCode(uint16_t code) {
 /// </summary>
 /// <param name="payload"></param>
 void Response::setPayload(std::string payload) {
-	this->payload = payload;
-	this->payloadSize = (uint32_t)payload.size();
+	this->payload = std::move(payload);
+	this->payloadSize = (uint32_t)this->payload.size();
 
 }
 
+/// <summary>
+/// Sets id of the request this response answers
+/// </summary>
+/// <param name="requestId"></param>
+void Response::setRequestId(uint32_t requestId) {
+	this->requestId = requestId;
+}
+
 /// <summary>
 /// Parses Request Header
 /// </summary>
@@ -110,7 +130,7 @@ void Response::setPayload(std::string payload) {
 /// <returns></returns>
 ResponseHeader Response::deparseHeader(Response response) {
 
-	ResponseHeader responseHeader = { 0 };
+	ResponseHeader responseHeader = {};
 	responseHeader.responseData.version = response.getVersion();
 	responseHeader.responseData.code = response.getCode();
 	responseHeader.responseData.payloadSize = response.getPayloadSize();
@@ -8,6 +8,7 @@ Author: Elad Sheffer
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 
@@ -16,6 +17,10 @@ const uint16_t SERVER_CODE_REGISTRATION_ERR = 2101;
 const uint16_t SERVER_CODE_SWITCHING_KEYS = 2102;
 const uint16_t SERVER_CODE_CKSUM_READY = 2103;
 const uint16_t SERVER_CODE_MESSAGE_RECEIVED = 2104;
+const uint16_t SERVER_CODE_FILE_PRESENT = 2105;
+const uint16_t SERVER_CODE_FILE_MISSING = 2106;
+const uint16_t SERVER_CODE_FILE_SIGNATURES = 2107;
+const uint16_t SERVER_CODE_CHUNK_RECEIVED = 2108;
 const uint8_t UUID_LENGTH_RESPONSE = 16;
 
 #pragma pack(push, 1)
@@ -43,6 +48,7 @@ private:
 	std::array<unsigned char, UUID_LENGTH_RESPONSE> clientId;
 	uint32_t payloadSize;
 	std::string payload;
+	uint32_t requestId;
 
 public:
 
@@ -66,6 +72,25 @@ public:
 	/// <param name="payload"></param>
 	Response(uint8_t version, uint16_t code, std::array<unsigned char, UUID_LENGTH_RESPONSE> clientId, std::string payload);
 
+	/// <summary>
+	/// Copy ctor
+	/// </summary>
+	Response(const Response& other) = default;
+
+	/// <summary>
+	/// Move ctor - takes over the payload without copying it
+	/// </summary>
+	Response(Response&& other) noexcept = default;
+
+	/// <summary>
+	/// Copy assignment
+	/// </summary>
+	Response& operator=(const Response& other) = default;
+
+	/// <summary>
+	/// Move assignment - takes over the payload without copying it
+	/// </summary>
+	Response& operator=(Response&& other) noexcept = default;
 
 	/// <summary>
 	/// Dtor
@@ -100,8 +125,14 @@ public:
 	/// <summary>
 	/// Returns payload
 	/// </summary>
-	/// <returns>payload</returns>
-	std::string getPayload();
+	/// <returns>view of the payload, valid as long as the response is</returns>
+	std::string_view getPayload();
+
+	/// <summary>
+	/// Returns id of the request this response answers
+	/// </summary>
+	/// <returns>request id</returns>
+	uint32_t getRequestId();
 
 	/// <summary>
 	/// Sets code
@@ -116,6 +147,12 @@ public:
 	/// <param name="payload"></param>
 	void setPayload(std::string payload);
 
+	/// <summary>
+	/// Sets id of the request this response answers
+	/// </summary>
+	/// <param name="requestId"></param>
+	void setRequestId(uint32_t requestId);
+
 	/// <summary>
 	/// Parses Request Header
 	/// </summary>
@@ -0,0 +1,294 @@
+#include "LoadClient.h"
+#include "RSAWrapper.h"
+#include "AESWrapper.h"
+#include "Varint.h"
+#include "crc.h"
+#include <functional>
+#include <cstring>
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="host"></param>
+/// <param name="port"></param>
+/// <param name="clientName">name to register with, unique on the server</param>
+/// <param name="stats">statistics to record the phases of the session in</param>
+LoadClient::LoadClient(std::string host, std::string port, std::string clientName, PhaseStats& stats)
+	: stats(stats), socket(ioContext) {
+	this->host = host;
+	this->port = port;
+	this->clientName = clientName;
+	this->clientId = { 0 };
+	this->protocolVersion = LEGACY_VERSION;
+	this->lastRequestId = 0;
+}
+
+/// <summary>
+/// Runs a whole session - connects, registers, exchanges keys, and uploads and verifies files of random content
+/// </summary>
+/// <param name="fileSizes">size of every file to upload</param>
+/// <param name="random"></param>
+/// <returns>false if a phase failed</returns>
+bool LoadClient::run(const std::vector<size_t>& fileSizes, std::mt19937& random) {
+
+	// runs a phase, recording its latency if it succeeded and an error otherwise
+	auto phase = [this](const std::string& name, const std::function<bool()>& operation) {
+		auto start = std::chrono::steady_clock::now();
+		bool isSuccessful = false;
+		try {
+			isSuccessful = operation();
+		}
+		catch (std::exception& e) {
+			std::cerr << "Exception: " << this->clientName << " " << name << ": " << e.what() << std::endl;
+
+			// the stream can't be trusted after a failed read or write
+			boost::system::error_code error;
+			this->socket.close(error);
+		}
+
+		if (isSuccessful)
+			this->stats.record(name, std::chrono::steady_clock::now() - start);
+		else
+			this->stats.recordError(name);
+		return isSuccessful;
+	};
+
+	if (!phase("connect", [this]() { return this->connect(); })
+		|| !phase("register", [this]() { return this->registerToServer(); })
+		|| !phase("key_exchange", [this]() { return this->exchangeKeys(); }))
+		return false;
+
+	bool isSuccessful = true;
+	for (size_t i = 0; i < fileSizes.size(); i++) {
+
+		// random content, so the server can't take a shortcut on it
+		std::string content(fileSizes[i], '\0');
+		for (char& c : content)
+			c = (char)random();
+		std::string filename = "load" + std::to_string(i) + ".bin";
+
+		// a file whose cksum doesn't match is not confirmed, the session goes on with the next one
+		if (!phase("upload", [&]() { return this->uploadFile(filename, content); })) {
+			isSuccessful = false;
+			if (!this->socket.is_open())
+				break;
+			continue;
+		}
+
+		if (!phase("verify", [&]() { return this->verifyFile(filename); })) {
+			isSuccessful = false;
+			if (!this->socket.is_open())
+				break;
+			continue;
+		}
+
+		this->stats.recordUpload(content.size());
+	}
+
+	boost::system::error_code error;
+	this->socket.shutdown(tcp::socket::shutdown_both, error);
+	this->socket.close(error);
+
+	return isSuccessful;
+}
+
+/// <summary>
+/// Connects to server
+/// </summary>
+/// <returns></returns>
+bool LoadClient::connect() {
+	tcp::resolver resolver(this->ioContext);
+	boost::asio::connect(this->socket, resolver.resolve(this->host, this->port));
+
+	// requests are written whole, so there is nothing to gain from delaying the small ones
+	this->socket.set_option(tcp::no_delay(true));
+	return true;
+}
+
+/// <summary>
+/// Registers to server and negotiates the version
+/// </summary>
+/// <returns></returns>
+bool LoadClient::registerToServer() {
+
+	// registration is always sent in the legacy layout, and it negotiates the version for the next requests
+	this->protocolVersion = LEGACY_VERSION;
+	Request request(LOADGEN_VERSION, CLIENT_CODE_REGISTER, this->clientName);
+	this->sendRequest(request);
+
+	Response response;
+	this->receiveResponse(response);
+	if (response.getCode() != SERVER_CODE_REGISTRATION_OK) {
+		std::cout << this->clientName << ": registration failed" << std::endl;
+		return false;
+	}
+
+	this->protocolVersion = std::min(LOADGEN_VERSION, response.getVersion());
+	if (this->protocolVersion < LOADGEN_VERSION) {
+		std::cout << this->clientName << ": server speaks version " << (int)response.getVersion() << ", version "
+			<< (int)LOADGEN_VERSION << " is needed" << std::endl;
+		return false;
+	}
+
+	this->clientId = response.getClientId();
+	return true;
+}
+
+/// <summary>
+/// Sends a new public RSA key and decrypts the AES key the server answers with
+/// </summary>
+/// <returns></returns>
+bool LoadClient::exchangeKeys() {
+
+	RSAPrivateWrapper rsapriv;
+
+	std::string payload;
+	Varint::appendString(payload, this->clientName);
+	payload.append(rsapriv.getPublicKey());
+
+	Request request(this->clientId, this->protocolVersion, CLIENT_CODE_SEND_PUBLIC_KEY, std::move(payload));
+	this->sendRequest(request);
+
+	Response response;
+	this->receiveResponse(response);
+	if (response.getCode() != SERVER_CODE_SWITCHING_KEYS) {
+		std::cout << this->clientName << ": key exchange failed" << std::endl;
+		return false;
+	}
+
+	this->aesKey = rsapriv.decrypt(std::string(response.getPayload()));
+	return this->aesKey.size() == AESWrapper::DEFAULT_KEYLENGTH;
+}
+
+/// <summary>
+/// Sends the encrypted content of a file, and compares the cksum the server calculated with its own
+/// </summary>
+/// <param name="filename"></param>
+/// <param name="content"></param>
+/// <returns></returns>
+bool LoadClient::uploadFile(const std::string& filename, const std::string& content) {
+
+	AESWrapper aes((const unsigned char*)this->aesKey.data(), (unsigned int)this->aesKey.size());
+
+	// the payload is the length prefixed filename and the codec, followed by the encrypted content
+	std::string payload;
+	Varint::appendString(payload, filename);
+	payload.push_back((char)CODEC_NONE);
+	payload.append(aes.encrypt(content.data(), (unsigned int)content.size()));
+
+	Request request(this->clientId, this->protocolVersion, CLIENT_CODE_SEND_FILE, std::move(payload));
+	this->sendRequest(request);
+
+	Response response;
+	this->receiveResponse(response);
+	if (response.getCode() != SERVER_CODE_CKSUM_READY) {
+		std::cout << this->clientName << ": file \"" << filename << "\" was not received" << std::endl;
+		return false;
+	}
+
+	// the payload is the content size, the length prefixed filename and the cksum
+	std::string_view data = response.getPayload();
+	size_t offset = 0;
+	uint64_t contentSize = 0;
+	std::string receivedFilename;
+	uint32_t cksum = 0;
+	if (!Varint::read(data, offset, contentSize) || !Varint::readString(data, offset, receivedFilename)
+		|| data.size() < offset + sizeof(uint32_t)) {
+		std::cout << this->clientName << ": invalid cksum of file \"" << filename << "\"" << std::endl;
+		return false;
+	}
+	std::memcpy(&cksum, data.data() + offset, sizeof(uint32_t));
+
+	CRC crc;
+	crc.update((unsigned char*)content.data(), (uint32_t)content.size());
+	if (crc.digest() != cksum) {
+		std::cout << this->clientName << ": cksum of file \"" << filename << "\" doesn't match" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Confirms the cksum of a file to server
+/// </summary>
+/// <param name="filename"></param>
+/// <returns></returns>
+bool LoadClient::verifyFile(const std::string& filename) {
+
+	std::string payload;
+	Varint::appendString(payload, filename);
+
+	Request request(this->clientId, this->protocolVersion, CLIENT_CODE_CKSUM_OK, std::move(payload));
+	this->sendRequest(request);
+
+	Response response;
+	this->receiveResponse(response);
+	if (response.getCode() != SERVER_CODE_MESSAGE_RECEIVED) {
+		std::cout << this->clientName << ": file \"" << filename << "\" was not confirmed" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Sends request to server
+/// </summary>
+/// <param name="request"></param>
+void LoadClient::sendRequest(Request& request) {
+
+	request.setRequestId(++this->lastRequestId);
+
+	RequestHeader requestHeader = {};
+	requestHeader.requestData.clientId = request.getClientId();
+	requestHeader.requestData.version = request.getVersion();
+	requestHeader.requestData.code = request.getCode();
+	requestHeader.requestData.payloadSize = request.getPayloadSize();
+
+	RequestIdHeader requestIdHeader = {};
+	requestIdHeader.requestId = request.getRequestId();
+
+	// header, request id and payload are gathered into a single write
+	std::vector<boost::asio::const_buffer> buffers;
+	buffers.push_back(boost::asio::buffer(requestHeader.buffer, sizeof(RequestData)));
+
+	// registration is always sent in the legacy layout - without a request id
+	if (request.getCode() != CLIENT_CODE_REGISTER)
+		buffers.push_back(boost::asio::buffer(requestIdHeader.buffer, sizeof(uint32_t)));
+
+	std::string_view payload = request.getPayload();
+	buffers.push_back(boost::asio::buffer(payload.data(), payload.size()));
+
+	boost::asio::write(this->socket, buffers);
+}
+
+/// <summary>
+/// Receives response from server
+/// </summary>
+/// <param name="response"></param>
+void LoadClient::receiveResponse(Response& response) {
+
+	ResponseHeader responseHeader = {};
+	RequestIdHeader requestIdHeader = {};
+	std::array<unsigned char, UUID_LENGTH> clientId = { 0 };
+
+	std::vector<boost::asio::mutable_buffer> buffers;
+	buffers.push_back(boost::asio::buffer(responseHeader.buffer, sizeof(ResponseData)));
+	buffers.push_back(boost::asio::buffer(clientId.data(), UUID_LENGTH));
+	if (this->protocolVersion >= VERSION_PIPELINING)
+		buffers.push_back(boost::asio::buffer(requestIdHeader.buffer, sizeof(uint32_t)));
+	boost::asio::read(this->socket, buffers);
+
+	std::string payload(responseHeader.responseData.payloadSize, '\0');
+	if (!payload.empty())
+		boost::asio::read(this->socket, boost::asio::buffer(&payload[0], payload.size()));
+
+	response = Response(responseHeader.responseData.version, responseHeader.responseData.code, clientId, std::move(payload));
+	response.setRequestId(requestIdHeader.requestId);
+
+	// every request is answered before the next one is sent, so the answer must be to the last request
+	if (this->protocolVersion >= VERSION_PIPELINING && requestIdHeader.requestId != this->lastRequestId)
+		throw std::runtime_error("response to request " + std::to_string(requestIdHeader.requestId)
+			+ " while waiting for " + std::to_string(this->lastRequestId));
+}
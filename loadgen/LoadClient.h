@@ -0,0 +1,98 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <string>
+#include <vector>
+#include <array>
+#include <random>
+#include "request.h"
+#include "response.h"
+#include "PhaseStats.h"
+
+using boost::asio::ip::tcp;
+
+// the load generator speaks the compact framing with codecs - it sends the whole content of a file uncompressed
+const uint8_t LOADGEN_VERSION = VERSION_COMPRESSION;
+const uint8_t CODEC_NONE = 0;
+
+/// <summary>
+/// A simulated client - registers, exchanges keys, and uploads and verifies files over its own connection,
+/// recording the latency of every phase
+/// </summary>
+class LoadClient {
+
+private:
+	// members
+	std::string host;
+	std::string port;
+	std::string clientName;
+	PhaseStats& stats;
+	boost::asio::io_context ioContext;
+	tcp::socket socket;
+	std::array<unsigned char, UUID_LENGTH> clientId;
+	uint8_t protocolVersion;
+	uint32_t lastRequestId;
+	std::string aesKey;
+
+	/// <summary>
+	/// Connects to server
+	/// </summary>
+	/// <returns></returns>
+	bool connect();
+
+	/// <summary>
+	/// Registers to server and negotiates the version
+	/// </summary>
+	/// <returns></returns>
+	bool registerToServer();
+
+	/// <summary>
+	/// Sends a new public RSA key and decrypts the AES key the server answers with
+	/// </summary>
+	/// <returns></returns>
+	bool exchangeKeys();
+
+	/// <summary>
+	/// Sends the encrypted content of a file, and compares the cksum the server calculated with its own
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <param name="content"></param>
+	/// <returns></returns>
+	bool uploadFile(const std::string& filename, const std::string& content);
+
+	/// <summary>
+	/// Confirms the cksum of a file to server
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <returns></returns>
+	bool verifyFile(const std::string& filename);
+
+	/// <summary>
+	/// Sends request to server
+	/// </summary>
+	/// <param name="request"></param>
+	void sendRequest(Request& request);
+
+	/// <summary>
+	/// Receives response from server
+	/// </summary>
+	/// <param name="response"></param>
+	void receiveResponse(Response& response);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	/// <param name="host"></param>
+	/// <param name="port"></param>
+	/// <param name="clientName">name to register with, unique on the server</param>
+	/// <param name="stats">statistics to record the phases of the session in</param>
+	LoadClient(std::string host, std::string port, std::string clientName, PhaseStats& stats);
+
+	/// <summary>
+	/// Runs a whole session - connects, registers, exchanges keys, and uploads and verifies files of random content
+	/// </summary>
+	/// <param name="fileSizes">size of every file to upload</param>
+	/// <param name="random"></param>
+	/// <returns>false if a phase failed</returns>
+	bool run(const std::vector<size_t>& fileSizes, std::mt19937& random);
+};
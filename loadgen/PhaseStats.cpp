@@ -0,0 +1,118 @@
+#include "PhaseStats.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Ctor
+/// </summary>
+PhaseStats::PhaseStats() {
+	this->uploadedFiles = 0;
+	this->uploadedBytes = 0;
+}
+
+/// <summary>
+/// Records latency of a phase that completed
+/// </summary>
+/// <param name="phase"></param>
+/// <param name="latency"></param>
+void PhaseStats::record(const std::string& phase, std::chrono::steady_clock::duration latency) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->latencies[phase].push_back(std::chrono::duration<double, std::milli>(latency).count());
+}
+
+/// <summary>
+/// Records a phase that failed
+/// </summary>
+/// <param name="phase"></param>
+void PhaseStats::recordError(const std::string& phase) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->errors[phase]++;
+}
+
+/// <summary>
+/// Records a file the server verified
+/// </summary>
+/// <param name="bytes"></param>
+void PhaseStats::recordUpload(size_t bytes) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->uploadedFiles++;
+	this->uploadedBytes += bytes;
+}
+
+/// <summary>
+/// Returns the value below which a fraction of the sorted samples are
+/// </summary>
+/// <param name="sorted"></param>
+/// <param name="fraction"></param>
+/// <returns></returns>
+double PhaseStats::percentile(const std::vector<double>& sorted, double fraction) {
+
+	if (sorted.empty())
+		return 0;
+
+	// nearest rank - the smallest sample that at least the fraction of the samples are not above
+	size_t rank = (size_t)std::ceil(fraction * sorted.size());
+	return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+/// <summary>
+/// Writes throughput, and count, errors and p50/p99/p999 latency of every phase as a table
+/// </summary>
+/// <param name="out"></param>
+/// <param name="elapsed">duration of the whole run</param>
+void PhaseStats::writeText(std::ostream& out, std::chrono::steady_clock::duration elapsed) {
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	double seconds = std::chrono::duration<double>(elapsed).count();
+
+	out << std::fixed << std::setprecision(2);
+	out << "Elapsed: " << seconds << " s" << std::endl;
+	out << "Throughput: " << this->uploadedFiles / seconds << " files/s, "
+		<< this->uploadedBytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl << std::endl;
+
+	out << std::left << std::setw(14) << "phase" << std::right << std::setw(10) << "count" << std::setw(10) << "errors"
+		<< std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "p999 ms" << std::setw(12)
+		<< "max ms" << std::endl;
+
+	for (const std::string& phase : PHASES) {
+		std::vector<double>& samples = this->latencies[phase];
+		std::sort(samples.begin(), samples.end());
+
+		out << std::left << std::setw(14) << phase << std::right << std::setw(10) << samples.size() << std::setw(10)
+			<< this->errors[phase] << std::setw(12) << percentile(samples, 0.5) << std::setw(12)
+			<< percentile(samples, 0.99) << std::setw(12) << percentile(samples, 0.999) << std::setw(12)
+			<< (samples.empty() ? 0 : samples.back()) << std::endl;
+	}
+}
+
+/// <summary>
+/// Writes throughput, and count, errors and p50/p99/p999 latency of every phase in json
+/// </summary>
+/// <param name="out"></param>
+/// <param name="elapsed">duration of the whole run</param>
+void PhaseStats::writeJson(std::ostream& out, std::chrono::steady_clock::duration elapsed) {
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	double seconds = std::chrono::duration<double>(elapsed).count();
+
+	out << std::fixed << std::setprecision(3);
+	out << "{" << std::endl;
+	out << "  \"elapsed_s\": " << seconds << "," << std::endl;
+	out << "  \"files\": " << this->uploadedFiles << "," << std::endl;
+	out << "  \"bytes\": " << this->uploadedBytes << "," << std::endl;
+	out << "  \"files_per_s\": " << this->uploadedFiles / seconds << "," << std::endl;
+	out << "  \"mb_per_s\": " << this->uploadedBytes / (1024.0 * 1024.0) / seconds << "," << std::endl;
+	out << "  \"phases\": [" << std::endl;
+
+	for (size_t i = 0; i < PHASES.size(); i++) {
+		std::vector<double>& samples = this->latencies[PHASES[i]];
+		std::sort(samples.begin(), samples.end());
+
+		out << "    {\"phase\": \"" << PHASES[i] << "\", \"count\": " << samples.size() << ", \"errors\": "
+			<< this->errors[PHASES[i]] << ", \"p50_ms\": " << percentile(samples, 0.5) << ", \"p99_ms\": "
+			<< percentile(samples, 0.99) << ", \"p999_ms\": " << percentile(samples, 0.999) << ", \"max_ms\": "
+			<< (samples.empty() ? 0 : samples.back()) << "}" << (i + 1 < PHASES.size() ? "," : "") << std::endl;
+	}
+
+	out << "  ]" << std::endl << "}" << std::endl;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/// <summary>
+/// Phases of a simulated client session, in the order they happen
+/// </summary>
+const std::vector<std::string> PHASES = { "connect", "register", "key_exchange", "upload", "verify" };
+
+/// <summary>
+/// Latencies and errors of every phase, collected from all the simulated clients
+/// </summary>
+class PhaseStats {
+
+private:
+	// members
+	std::mutex mutex;
+	std::map<std::string, std::vector<double>> latencies;
+	std::map<std::string, uint64_t> errors;
+	uint64_t uploadedFiles;
+	uint64_t uploadedBytes;
+
+	/// <summary>
+	/// Returns the value below which a fraction of the sorted samples are
+	/// </summary>
+	/// <param name="sorted"></param>
+	/// <param name="fraction"></param>
+	/// <returns></returns>
+	static double percentile(const std::vector<double>& sorted, double fraction);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	PhaseStats();
+
+	/// <summary>
+	/// Records latency of a phase that completed
+	/// </summary>
+	/// <param name="phase"></param>
+	/// <param name="latency"></param>
+	void record(const std::string& phase, std::chrono::steady_clock::duration latency);
+
+	/// <summary>
+	/// Records a phase that failed
+	/// </summary>
+	/// <param name="phase"></param>
+	void recordError(const std::string& phase);
+
+	/// <summary>
+	/// Records a file the server verified
+	/// </summary>
+	/// <param name="bytes"></param>
+	void recordUpload(size_t bytes);
+
+	/// <summary>
+	/// Writes throughput, and count, errors and p50/p99/p999 latency of every phase as a table
+	/// </summary>
+	/// <param name="out"></param>
+	/// <param name="elapsed">duration of the whole run</param>
+	void writeText(std::ostream& out, std::chrono::steady_clock::duration elapsed);
+
+	/// <summary>
+	/// Writes throughput, and count, errors and p50/p99/p999 latency of every phase in json
+	/// </summary>
+	/// <param name="out"></param>
+	/// <param name="elapsed">duration of the whole run</param>
+	void writeJson(std::ostream& out, std::chrono::steady_clock::duration elapsed);
+};
@@ -0,0 +1,177 @@
+#include "LoadClient.h"
+#include "PhaseStats.h"
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+const size_t DEFAULT_CLIENTS = 8;
+const size_t DEFAULT_FILES = 4;
+const size_t DEFAULT_FILE_SIZE = 64 * 1024;
+const size_t MAX_FILE_SIZE = 1024 * 1024 * 1024;
+
+/// <summary>
+/// Distribution of the sizes of the uploaded files -
+/// fixed:<bytes>, uniform:<min>:<max> or lognormal:<median>:<sigma>
+/// </summary>
+struct SizeDistribution {
+	std::string kind = "fixed";
+	double first = DEFAULT_FILE_SIZE;
+	double second = 0;
+
+	/// <summary>
+	/// Draws the size of a file
+	/// </summary>
+	/// <param name="random"></param>
+	/// <returns></returns>
+	size_t draw(std::mt19937& random) const {
+		double size = this->first;
+		if (this->kind == "uniform")
+			size = std::uniform_real_distribution<double>(this->first, this->second)(random);
+		else if (this->kind == "lognormal")
+			size = std::lognormal_distribution<double>(std::log(this->first), this->second)(random);
+
+		// an empty file is not sent by the client, so neither is it here
+		return (size_t)std::min(std::max(size, 1.0), (double)MAX_FILE_SIZE);
+	}
+};
+
+/// <summary>
+/// Options of a load generator run
+/// </summary>
+struct LoadOptions {
+	std::string host = "127.0.0.1";
+	std::string port = "1234";
+	size_t clients = DEFAULT_CLIENTS;
+	size_t files = DEFAULT_FILES;
+	SizeDistribution sizes;
+	uint32_t seed = 0;
+	std::string format = "text";
+	std::string outPath;
+};
+
+/// <summary>
+/// Parses a distribution of file sizes
+/// </summary>
+/// <param name="value"></param>
+/// <param name="distribution"></param>
+/// <returns>false if the distribution is invalid</returns>
+bool parseSizeDistribution(const std::string& value, SizeDistribution& distribution) {
+
+	std::vector<std::string> parts;
+	std::stringstream stream(value);
+	std::string part;
+	while (std::getline(stream, part, ':'))
+		parts.push_back(part);
+
+	if (parts.size() == 2 && parts[0] == "fixed")
+		distribution = { parts[0], std::stod(parts[1]), 0 };
+	else if (parts.size() == 3 && (parts[0] == "uniform" || parts[0] == "lognormal"))
+		distribution = { parts[0], std::stod(parts[1]), std::stod(parts[2]) };
+	else
+		return false;
+
+	if (distribution.first < 1 || distribution.second < 0)
+		return false;
+	return distribution.kind != "uniform" || distribution.second >= distribution.first;
+}
+
+/// <summary>
+/// Parses command line arguments into options
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <param name="options"></param>
+/// <returns>true if all the arguments are valid, false otherwise</returns>
+bool parseOptions(int argc, char* argv[], LoadOptions& options) {
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+
+		try {
+			if (arg == "--host")
+				options.host = value;
+			else if (arg == "--port")
+				options.port = value;
+			else if (arg == "--clients" && std::stoul(value) > 0)
+				options.clients = std::stoul(value);
+			else if (arg == "--files")
+				options.files = std::stoul(value);
+			else if (arg == "--size-dist" && parseSizeDistribution(value, options.sizes))
+				continue;
+			else if (arg == "--seed")
+				options.seed = (uint32_t)std::stoul(value);
+			else if (arg == "--format" && (value == "text" || value == "json"))
+				options.format = value;
+			else if (arg == "--out")
+				options.outPath = value;
+			else
+				return false;
+		}
+		catch (std::exception&) {
+			return false;
+		}
+	}
+
+	// every option is followed by its value
+	return argc % 2 == 1;
+}
+
+/// <summary>
+/// Drives concurrent simulated clients against a server, each registering, exchanging keys and uploading
+/// and verifying files, and reports throughput, latency percentiles of every phase and errors
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int main(int argc, char* argv[])
+{
+	LoadOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		std::cout << "Usage: loadgen [--host <host>] [--port <port>] [--clients <count>] [--files <count>] "
+			"[--size-dist fixed:<bytes>|uniform:<min>:<max>|lognormal:<median>:<sigma>] [--seed <seed>] "
+			"[--format text|json] [--out <path>]" << std::endl;
+		return 1;
+	}
+
+	PhaseStats stats;
+
+	// names are registered once on the server, so every run gets its own
+	std::string runId = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < options.clients; i++) {
+		threads.emplace_back([&options, &stats, &runId, i]() {
+
+			// every client draws from its own generator, so a seed gives the same files whatever the scheduling
+			std::mt19937 random(options.seed + (uint32_t)i);
+			std::vector<size_t> fileSizes;
+			for (size_t j = 0; j < options.files; j++)
+				fileSizes.push_back(options.sizes.draw(random));
+
+			LoadClient client(options.host, options.port, "loadgen-" + runId + "-" + std::to_string(i), stats);
+			client.run(fileSizes, random);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	if (options.outPath.empty()) {
+		options.format == "json" ? stats.writeJson(std::cout, elapsed) : stats.writeText(std::cout, elapsed);
+		return 0;
+	}
+
+	std::ofstream out(options.outPath);
+	if (!out.is_open()) {
+		std::cout << "Cannot open " << options.outPath << std::endl;
+		return 1;
+	}
+	options.format == "json" ? stats.writeJson(out, elapsed) : stats.writeText(out, elapsed);
+	return 0;
+}
@@ -2,6 +2,8 @@
 # Author: Elad Sheffer
 
 import sqlite3
+import log
+import timing
 from datetime import datetime
 
 DB_FILE = "server.db"
@@ -20,18 +22,25 @@ class Database:
             CREATE TABLE IF NOT EXISTS clients(client_id CHAR(16) NOT NULL PRIMARY KEY, 
             client_name VARCHAR(127) NOT NULL, public_key CHAR(160), last_seen DATE, AES_key CHAR(32));
             CREATE TABLE IF NOT EXISTS files(client_id CHAR(16) NOT NULL, filename VARCHAR(255) NOT NULL, 
-            pathname VARCHAR(255) NOT NULL PRIMARY KEY, verified NUMERIC(1) NOT NULL);
+            pathname VARCHAR(255) NOT NULL PRIMARY KEY, verified NUMERIC(1) NOT NULL, cksum INTEGER, size INTEGER);
             """)
 
+            # adding the digest columns to a files table created by an older version
+            columns = [column[1] for column in conn.execute("PRAGMA table_info(files)")]
+            for column in ("cksum", "size"):
+                if column not in columns:
+                    conn.execute(f"ALTER TABLE files ADD COLUMN {column} INTEGER")
+
             conn.commit()
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def client_exists_by_name(client_name):
         conn = None
         try:
@@ -45,12 +54,13 @@ class Database:
             return True
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def client_exists_by_id(client_id):
         conn = None
         try:
@@ -64,12 +74,13 @@ class Database:
             return True
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def get_client_name(client_id):
         conn = None
         try:
@@ -84,13 +95,14 @@ class Database:
             return client_name
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
             return False
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def get_client_list():
         conn = None
         try:
@@ -102,12 +114,13 @@ class Database:
             return results
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def file_exists(client_id, filename):
         conn = None
         try:
@@ -121,12 +134,13 @@ class Database:
             return True
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def get_file_list():
         conn = None
         try:
@@ -138,12 +152,13 @@ class Database:
             return results
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def insert_new_client(client_name, response):
         conn = None
         client_id = response.get_client_id()
@@ -155,12 +170,13 @@ class Database:
                                                                                                      date_time])
             conn.commit()
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def insert_keys_of_client(client_name, public_key, aes_key):
         conn = None
         date_time = datetime.now().strftime("%d/%m/%Y %H:%M:%S")
@@ -171,13 +187,14 @@ class Database:
 
             conn.commit()
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
 
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def get_aes_key_of_client(client_id):
         conn = None
         try:
@@ -189,12 +206,13 @@ class Database:
             return results[0][0]
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def update_last_seen(client_id):
         date_time = datetime.now().strftime("%d/%m/%Y %H:%M:%S")
         conn = None
@@ -203,12 +221,13 @@ class Database:
             conn.execute("UPDATE clients SET last_seen = ? WHERE client_id = ?", [date_time, client_id])
             conn.commit()
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def insert_file_details(client_id, filename, pathname, verified):
         date_time = datetime.now().strftime("%d/%m/%Y %H:%M:%S")
         conn = None
@@ -221,12 +240,13 @@ class Database:
             conn.execute("UPDATE clients SET last_seen = ? WHERE client_id = ?", [date_time, client_id])
             conn.commit()
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def update_cksum_verification(client_id, filename, verified):
         date_time = datetime.now().strftime("%d/%m/%Y %H:%M:%S")
         conn = None
@@ -237,11 +257,44 @@ class Database:
             conn.execute("UPDATE clients SET last_seen = ? WHERE client_id = ?", [date_time, client_id])
             conn.commit()
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
+        finally:
+            conn.close()
+
+    @staticmethod
+    @timing.timed("sqlite")
+    def update_file_digest(client_id, filename, cksum, size):
+        conn = None
+        try:
+            conn = sqlite3.connect(DB_FILE)
+            conn.execute("UPDATE files SET cksum = ?, size = ? WHERE client_id = ? AND filename = ?", [cksum, size,
+                                                                                                       client_id,
+                                                                                                       filename])
+            conn.commit()
+        except Exception as e:
+            log.error("Exception occurred", error=repr(e))
+        finally:
+            conn.close()
+
+    @staticmethod
+    @timing.timed("sqlite")
+    def get_verified_file(client_id, filename):
+        conn = None
+        try:
+            conn = sqlite3.connect(DB_FILE)
+            c = conn.cursor()
+            c.execute("SELECT pathname, cksum, size FROM files where client_id = ? AND filename = ? AND verified = 1;",
+                      [client_id, filename])
+            return c.fetchone()
+
+        except Exception as e:
+            log.error("Exception occurred", error=repr(e))
+
         finally:
             conn.close()
 
     @staticmethod
+    @timing.timed("sqlite")
     def delete_file_of_client(client_id, filename):
         date_time = datetime.now().strftime("%d/%m/%Y %H:%M:%S")
         conn = None
@@ -251,6 +304,6 @@ class Database:
             conn.execute("UPDATE clients SET last_seen = ? WHERE client_id = ?", [date_time, client_id])
             conn.commit()
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
         finally:
             conn.close()
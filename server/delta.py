@@ -0,0 +1,117 @@
+# delta.py
+# Author: Elad Sheffer
+
+import hashlib
+import math
+import os
+from itertools import accumulate
+from struct import pack
+from varint import encode_varint, decode_varint
+
+DELTA_OP_COPY = 0
+DELTA_OP_LITERAL = 1
+STRONG_HASH_LENGTH = 16
+MIN_BLOCK_SIZE = 2048
+MAX_BLOCK_SIZE = 128 * 1024
+COPY_WINDOW_SIZE = 1024 * 1024  # copied blocks are read from the saved file in windows of at most this size
+
+
+def choose_block_size(file_size):
+    """
+    Chooses block size of the signatures of a file - about the square root of its size
+    :param file_size:
+    :return: block size
+    """
+    return max(MIN_BLOCK_SIZE, min(MAX_BLOCK_SIZE, math.isqrt(file_size)))
+
+
+def weak_checksum(block):
+    """
+    Calculates the rolling checksum of a block - the sum of its bytes and the sum of its bytes weighted by their
+    distance from the end of the block, each of them modulo 2^16
+    :param block:
+    :return: checksum
+    """
+    # the weighted sum is the sum of the running sums of the bytes
+    a = sum(block)
+    b = sum(accumulate(block))
+    return (a & 0xFFFF) | ((b & 0xFFFF) << 16)
+
+
+def strong_hash(block):
+    """
+    Calculates the strong hash of a block - a truncated SHA-256
+    :param block:
+    :return: hash
+    """
+    return hashlib.sha256(block).digest()[:STRONG_HASH_LENGTH]
+
+
+def block_signatures(file, file_size):
+    """
+    Builds the signatures of the full blocks of a file, reading it one block at a time
+    :param file: file opened for binary reading
+    :param file_size:
+    :return: block size and number of blocks in variable length encoding, then weak checksum and strong hash of
+    each block
+    """
+    block_size = choose_block_size(file_size)
+    block_count = file_size // block_size
+
+    signatures = bytearray(encode_varint(block_size) + encode_varint(block_count))
+    for i in range(block_count):
+        block = file.read(block_size)
+        if len(block) != block_size:
+            raise ValueError("Saved file is shorter than its size")
+        signatures += pack('<I', weak_checksum(block)) + strong_hash(block)
+
+    return bytes(signatures)
+
+
+def apply_delta(old_file, delta, new_file):
+    """
+    Rebuilds a file from the copy saved in server and a delta sent by the client, reading the copied blocks from
+    the saved copy and writing the new content as it is rebuilt
+    :param old_file: copy saved in server, opened for binary reading
+    :param delta: block size followed by instructions - copies of blocks of the old content and literal bytes
+    :param new_file: file opened for binary writing
+    :return: size of the new content
+    """
+    block_size, offset = decode_varint(delta)
+    if block_size == 0:
+        raise ValueError("Invalid block size")
+
+    old_size = os.fstat(old_file.fileno()).st_size
+    content_size = 0
+    while offset < len(delta):
+        op = delta[offset]
+        offset += 1
+
+        if op == DELTA_OP_COPY:
+            first_block, offset = decode_varint(delta, offset)
+            block_count, offset = decode_varint(delta, offset)
+            start = first_block * block_size
+            end = start + block_count * block_size
+            if end > old_size:
+                raise ValueError("Copy instruction out of the saved file")
+            old_file.seek(start)
+            while start < end:
+                window = old_file.read(min(COPY_WINDOW_SIZE, end - start))
+                if not window:
+                    raise ValueError("Saved file is shorter than its size")
+                new_file.write(window)
+                start += len(window)
+            content_size += block_count * block_size
+
+        elif op == DELTA_OP_LITERAL:
+            length, offset = decode_varint(delta, offset)
+            if offset + length > len(delta):
+                raise ValueError("Literal instruction out of the delta")
+            new_file.write(delta[offset:offset + length])
+            content_size += length
+            offset += length
+
+        else:
+            raise ValueError(f"Unknown delta instruction {op}")
+
+    return content_size
@@ -0,0 +1,119 @@
+# log.py
+# Author: Elad Sheffer
+
+import atexit
+import json
+import logging
+import logging.handlers
+import os
+import queue
+import sys
+import time
+
+LOG_FILE = "log.info"  # level and format of the log, "info text" if the file is missing
+LOGGER_NAME = "server"
+LEVELS = {"debug": logging.DEBUG, "info": logging.INFO, "warning": logging.WARNING, "error": logging.ERROR,
+          "off": logging.CRITICAL + 1}
+FORMATS = ("text", "json")
+
+__logger = logging.getLogger(LOGGER_NAME)
+__listener = None
+
+
+class TextFormatter(logging.Formatter):
+    """
+    Formats a record as its message followed by key=value of every field
+    """
+
+    def format(self, record):
+        line = record.getMessage()
+        for key, value in getattr(record, "fields", {}).items():
+            line += f" {key}={quote(value)}"
+        return line
+
+
+class JsonFormatter(logging.Formatter):
+    """
+    Formats a record as a json object, with time (UTC), level, message and the fields
+    """
+    converter = time.gmtime
+
+    def format(self, record):
+        obj = {"time": self.formatTime(record, "%Y-%m-%dT%H:%M:%S") + f".{int(record.msecs):03d}Z",
+               "level": record.levelname.lower(), "message": record.getMessage()}
+        obj.update(getattr(record, "fields", {}))
+        return json.dumps(obj, default=str)
+
+
+def quote(value):
+    """
+    Returns a field value as text, quoted if it could not be told apart from the next field otherwise
+    :param value:
+    :return:
+    """
+    text = str(value)
+    if text == "" or any(c in text for c in " \"=\t\r\n"):
+        return json.dumps(text)
+    return text
+
+
+def setup():
+    """
+    Starts the writer thread of the log - records are put in a queue by the threads of the sessions, and formatted
+    and written by the writer, so a session doesn't wait for the console
+    :return:
+    """
+    global __listener
+
+    level, fmt = "info", "text"
+    try:
+        if os.path.exists(LOG_FILE):
+            with open(LOG_FILE, "r") as file:
+                words = file.readline().split()
+            if len(words) > 0 and words[0] in LEVELS:
+                level = words[0]
+            if len(words) > 1 and words[1] in FORMATS:
+                fmt = words[1]
+    except Exception as e:
+        print("Exception occurred: " + repr(e))
+
+    handler = logging.StreamHandler(sys.stdout)
+    handler.setFormatter(JsonFormatter() if fmt == "json" else TextFormatter())
+
+    # the queue is unbounded - putting a record never blocks
+    records = queue.SimpleQueue()
+    __logger.handlers = [logging.handlers.QueueHandler(records)]
+    __logger.setLevel(LEVELS[level])
+    __logger.propagate = False
+
+    __listener = logging.handlers.QueueListener(records, handler)
+    __listener.start()
+    atexit.register(__listener.stop)
+
+
+def log(level, message, fields):
+    """
+    Logs a record - dropped before it is built if its level is disabled
+    :param level:
+    :param message:
+    :param fields:
+    :return:
+    """
+    if __logger.isEnabledFor(level):
+        __logger.log(level, message, extra={"fields": fields})
+
+
+def debug(message, **fields):
+    log(logging.DEBUG, message, fields)
+
+
+def info(message, **fields):
+    log(logging.INFO, message, fields)
+
+
+def warning(message, **fields):
+    log(logging.WARNING, message, fields)
+
+
+def error(message, **fields):
+    log(logging.ERROR, message, fields)
@@ -0,0 +1,144 @@
+# metrics.py
+# Author: Elad Sheffer
+
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+METRICS_PATH = "/metrics"
+CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8"
+LATENCY_BUCKETS = (0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30)  # seconds
+
+# name: (type, help)
+METRIC_DEFINITIONS = {
+    "upload_server_connections_total": ("counter", "Connections accepted from clients."),
+    "upload_server_connections_active": ("gauge", "Connections currently open."),
+    "upload_server_requests_total": ("counter", "Requests received by code."),
+    "upload_server_requests_in_flight": ("gauge", "Requests being handled."),
+    "upload_server_request_duration_seconds": ("histogram", "Time to handle a request, by code."),
+    "upload_server_request_phase_seconds": ("summary", "Time of the phases of handling a request, from the rest of "
+                                                       "its header to its response, by code and phase."),
+    "upload_server_bytes_received_total": ("counter", "Bytes of requests received from clients."),
+    "upload_server_bytes_sent_total": ("counter", "Bytes of responses sent to clients."),
+    "upload_server_files_received_total": ("counter", "Files saved and answered with their cksum."),
+    "upload_server_files_verified_total": ("counter", "Files whose cksum the client confirmed."),
+    "upload_server_files_unchanged_total": ("counter", "Files not sent because a verified copy is saved."),
+    "upload_server_cksum_failures_total": ("counter", "Cksum failures reported by clients, by whether it was the "
+                                                      "last time."),
+}
+
+
+class Metrics:
+    """
+    Counters, gauges, summaries and histograms of the server, shared by the threads of all the sessions and rendered in the
+    Prometheus text format
+    """
+    __lock = None
+    __values = None
+    __http_server = None
+
+    def __init__(self):
+        self.__lock = threading.Lock()
+
+        # values by name, then by the sorted label pairs
+        self.__values = {name: {} for name in METRIC_DEFINITIONS}
+
+    def inc(self, name, value=1, **labels):
+        """
+        Adds to a counter or a gauge
+        :param name:
+        :param value:
+        :param labels:
+        :return:
+        """
+        key = tuple(sorted(labels.items()))
+        with self.__lock:
+            values = self.__values[name]
+            values[key] = values.get(key, 0) + value
+
+    def dec(self, name, value=1, **labels):
+        """
+        Subtracts from a gauge
+        :param name:
+        :param value:
+        :param labels:
+        :return:
+        """
+        self.inc(name, -value, **labels)
+
+    def observe(self, name, seconds, **labels):
+        """
+        Adds an observation to a summary - its sum and count, or to a histogram - also the bucket it falls in
+        :param name:
+        :param seconds:
+        :param labels:
+        :return:
+        """
+        key = tuple(sorted(labels.items()))
+        with self.__lock:
+            values = self.__values[name]
+            if METRIC_DEFINITIONS[name][0] == "histogram":
+                total, count, buckets = values.get(key, (0.0, 0, [0] * len(LATENCY_BUCKETS)))
+                for i, bound in enumerate(LATENCY_BUCKETS):
+                    if seconds <= bound:
+                        buckets[i] += 1
+                        break
+                values[key] = (total + seconds, count + 1, buckets)
+            else:
+                total, count = values.get(key, (0.0, 0))
+                values[key] = (total + seconds, count + 1)
+
+    def render(self):
+        """
+        Renders all the metrics in the Prometheus text format
+        :return: the text
+        """
+        lines = []
+        with self.__lock:
+            for name, (metric_type, description) in METRIC_DEFINITIONS.items():
+                lines.append(f"# HELP {name} {description}")
+                lines.append(f"# TYPE {name} {metric_type}")
+                for key, value in sorted(self.__values[name].items()):
+                    pairs = [f'{label}="{label_value}"' for label, label_value in key]
+                    labels = "{" + ",".join(pairs) + "}" if pairs else ""
+                    if metric_type == "histogram":
+                        # buckets are cumulative - every one counts the observations up to its bound
+                        cumulative = 0
+                        for bound, bucket in zip(LATENCY_BUCKETS, value[2]):
+                            cumulative += bucket
+                            bucket_labels = ",".join(pairs + [f'le="{bound}"'])
+                            lines.append(f"{name}_bucket{{{bucket_labels}}} {cumulative}")
+                        bucket_labels = ",".join(pairs + ['le="+Inf"'])
+                        lines.append(f"{name}_bucket{{{bucket_labels}}} {value[1]}")
+                    if metric_type in ("summary", "histogram"):
+                        lines.append(f"{name}_sum{labels} {value[0]}")
+                        lines.append(f"{name}_count{labels} {value[1]}")
+                    else:
+                        lines.append(f"{name}{labels} {value}")
+        return "\n".join(lines) + "\n"
+
+    def serve(self, port):
+        """
+        Serves the metrics over HTTP on a port, from a thread of its own
+        :param port:
+        :return:
+        """
+        metrics = self
+
+        class MetricsHandler(BaseHTTPRequestHandler):
+            def do_GET(self):
+                if self.path != METRICS_PATH:
+                    self.send_error(404)
+                    return
+                body = metrics.render().encode("utf-8")
+                self.send_response(200)
+                self.send_header("Content-Type", CONTENT_TYPE)
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+            def log_message(self, format, *args):
+                # scrapes are not printed among the requests of clients
+                pass
+
+        self.__http_server = ThreadingHTTPServer(('', port), MetricsHandler)
+        threading.Thread(target=self.__http_server.serve_forever, daemon=True).start()
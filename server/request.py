@@ -13,8 +13,9 @@ class Request:
     __payload = None
     __payload_size = None
     __filename = None
+    __request_id = None
 
-    def __init__(self, client_id=b'', version=0, code=0, payload_size=0, payload=b'', filename=""):
+    def __init__(self, client_id=b'', version=0, code=0, payload_size=0, payload=b'', filename="", request_id=0):
         self.__client_id = struct.unpack('=' + str(UUID_LENGTH) + 's', struct.pack('=' + str(UUID_LENGTH) + 's',
                                                                                    client_id))
         self.__version = struct.unpack('=B', struct.pack('=B', version))
@@ -22,6 +23,7 @@ class Request:
         self.__payload = payload
         self.__payload_size = struct.unpack('=I', struct.pack('=I', payload_size))
         self.__filename = filename
+        self.__request_id = struct.unpack('=I', struct.pack('=I', request_id))
 
     def get_client_id(self):
         return self.__client_id[0]
@@ -41,6 +43,9 @@ class Request:
     def get_filename(self):
         return self.__filename
 
+    def get_request_id(self):
+        return self.__request_id[0]
+
     def set_client_id(self, client_id):
         self.__client_id = struct.unpack('=' + str(UUID_LENGTH) + 's', struct.pack('=' + str(UUID_LENGTH) + 's',
                                                                                    client_id))
@@ -51,6 +56,9 @@ class Request:
     def set_code(self, code):
         self.__code = struct.unpack('=H', struct.pack('=H', code))
 
+    def set_request_id(self, request_id):
+        self.__request_id = struct.unpack('=I', struct.pack('=I', request_id))
+
     def set_payload(self, payload):
         self.__payload = payload
         self.__payload_size = struct.unpack('=I', struct.pack('=I', self.__payload.__len__()))
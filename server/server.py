@@ -14,14 +14,29 @@ from Crypto.Cipher import PKCS1_OAEP, AES
 from Crypto.PublicKey import RSA
 import os
 import threading
+import time
+import zlib
 from crc import crc32
 from client import Client
 from file import File
+from varint import encode_varint, decode_varint, encode_string, decode_string
+from delta import block_signatures, apply_delta
+from metrics import Metrics
+import log
+import timing
 
 PORT_FILE = "port.info"
+METRICS_PORT_FILE = "metrics.info"  # port of the HTTP endpoint of the metrics, not served if the file is missing
 MAX_PORT = 65535
 DEFAULT_PORT = 1234  # Default port used by the server
-SERVER_VERSION = 3
+SERVER_VERSION = 9
+VERSION_PIPELINING = 4  # first version with request id in requests and responses
+VERSION_COMPACT_FRAMING = 5  # first version with length prefixed strings, every request byte counted as payload
+VERSION_COMPRESSION = 6  # first version with codec of the file content in file requests
+VERSION_DEDUP = 7  # first version with file digest requests
+VERSION_DELTA = 8  # first version with block signatures and delta file requests
+DELTA_MIN_FILE_SIZE = 64 * 1024  # smaller saved files are sent again in full
+VERSION_CHUNKED = 9  # first version with files sent in chunks
 CLIENT_NAME_LENGTH = 255
 PUBLIC_KEY_SIZE = 160
 
@@ -29,18 +44,28 @@ UUID_LENGTH = 16
 AES_KEY_SIZE = 16
 FILENAME_LENGTH = 255
 
+CODEC_NONE = 0
+CODEC_ZLIB = 1
+
 CLIENT_CODE_REGISTER = 1100
 CLIENT_CODE_SEND_PUBLIC_KEY = 1101
 CLIENT_CODE_SEND_FILE = 1103
 CLIENT_CODE_CKSUM_OK = 1104
 CLIENT_CODE_CKSUM_ERR = 1105
 CLIENT_CODE_CKSUM_ERR_FINAL = 1106
+CLIENT_CODE_FILE_DIGEST = 1107
+CLIENT_CODE_SEND_DELTA = 1108
+CLIENT_CODE_SEND_CHUNK = 1109
 
 SERVER_CODE_REGISTRATION_OK = 2100
 SERVER_CODE_REGISTRATION_ERR = 2101
 SERVER_CODE_SWITCHING_KEYS = 2102
 SERVER_CODE_CKSUM_READY = 2103
 SERVER_CODE_MESSAGE_RECEIVED = 2104
+SERVER_CODE_FILE_PRESENT = 2105
+SERVER_CODE_FILE_MISSING = 2106
+SERVER_CODE_FILE_SIGNATURES = 2107
+SERVER_CODE_CHUNK_RECEIVED = 2108
 
 CLIENT_CLOSED_CONNECTION_1 = 10053
 CLIENT_CLOSED_CONNECTION_2 = 10054
@@ -56,11 +81,21 @@ class Server:
     database = None
     __client_map = None
     __file_map = None
+    __chunked_uploads = None
+    __chunks_lock = None
+    metrics = None
+    slow_request_ms = None
 
     def __init__(self):
+        log.setup()
+        self.slow_request_ms = timing.load_slow_request_ms()
         self.load_port()
         self.database = Database()
+        self.__chunked_uploads = {}
+        self.__chunks_lock = threading.Lock()
+        self.metrics = Metrics()
         self.load_data_from_database()
+        self.serve_metrics()
         self.open_server()
 
     def load_port(self):
@@ -80,7 +115,7 @@ class Server:
             with open(port_file, "r") as file:
 
                 if not file.readable():
-                    print("Unable to read file")
+                    log.error("Unable to read file", path=port_file)
 
                 else:
                     # reading first (and only) line of the file of the port and stripping from white spaces if any
@@ -94,13 +129,35 @@ class Server:
                         self.port = DEFAULT_PORT
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
             # taking default port in case there's a problem with the file opening or reading
             port = DEFAULT_PORT
 
         finally:
             return port
 
+    def serve_metrics(self):
+        """
+        Serves the metrics over HTTP, on the port in the metrics file if there is one
+        :return:
+        """
+        try:
+            if not os.path.exists(METRICS_PORT_FILE):
+                return
+
+            with open(METRICS_PORT_FILE, "r") as file:
+                port = file.readline().strip()
+
+            if not port.isnumeric() or int(port) not in range(1, MAX_PORT + 1):
+                log.error("Invalid port of metrics", port=port)
+                return
+
+            self.metrics.serve(int(port))
+            log.info("Serving metrics", port=port)
+
+        except Exception as e:
+            log.error("Exception occurred", error=repr(e))
+
     def load_data_from_database(self):
         """
         Loads data from data base
@@ -133,7 +190,7 @@ class Server:
                 self.__client_map[item[CLIENT_ID]].add_file(item[FILE_PATH], file)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
     def open_server(self):
         """
@@ -148,22 +205,21 @@ class Server:
                 # put the socket into listening mode
                 self.sock.listen()
 
-                print("Server is on.")
-                print(f"Listening on port: {self.port}")
-                print("Waiting for clients to connect...\n")
+                log.info("Server is on, waiting for clients to connect", port=self.port)
 
                 # a forever loop until client wants to exit
                 while True:
                     # establish connection with client
                     conn, addr = self.sock.accept()
 
-                    print(f'New client connected from {addr[0]} : {addr[1]}\n')
+                    log.info("New client connected", host=addr[0], port=addr[1])
+                    self.metrics.inc("upload_server_connections_total")
 
                     # Start a new thread of client and return its identifier
                     threading.Thread(target=self.session, args=(conn, addr)).start()
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
     def session(self, conn, addr):
         """
@@ -172,69 +228,142 @@ class Server:
         :param addr:
         :return:
         """
+        self.metrics.inc("upload_server_connections_active")
         try:
             while True:
 
                 # receiving request data (header) from client
                 frmt = '<' + str(UUID_LENGTH) + 'sBHI'
                 request_data = conn.recv(calcsize(frmt))
+                self.metrics.inc("upload_server_bytes_received_total", len(request_data))
 
                 if request_data:
+                    # the request is timed from its first bytes - the wait for them is the idle time of the client
+                    timing.start()
+
+                    # completing the header if it arrived in parts
+                    request_data += self.recv_exact(conn, calcsize(frmt) - len(request_data))
+
                     # converting the request data stream to items of request object
                     client_id, client_version, code, payload_size = unpack(frmt, request_data)
 
                     # creating a request object with the relevant information that came from the client
                     request = Request(client_id, client_version, code, payload_size)
 
+                    # registration is always sent in the legacy layout - the version is negotiated by it
+                    if code != CLIENT_CODE_REGISTER and client_version >= VERSION_PIPELINING:
+                        request.set_request_id(unpack('<I', self.recv_exact(conn, calcsize('<I')))[0])
+
                     # receiving payload according to payload size
-                    payload = conn.recv(payload_size)
+                    payload = self.recv_exact(conn, payload_size)
 
                     # handling request according to the code inside the request
-                    self.handle_request(conn, request, payload)
-
-                    print("Waiting for clients to send request...")
+                    self.metrics.inc("upload_server_requests_total", code=code)
+                    self.metrics.inc("upload_server_requests_in_flight")
+                    started = time.perf_counter()
+                    try:
+                        self.handle_request(conn, request, payload)
+                    finally:
+                        self.metrics.dec("upload_server_requests_in_flight")
+                        self.metrics.observe("upload_server_request_duration_seconds",
+                                             time.perf_counter() - started, code=code)
+                        self.record_timing(request)
 
                 else:
 
                     # if 0 data received from client:
-                    print("Client closed connection.")
-                    print(f'closing connection from host: {addr[0]} port: {addr[1]}\n')
-                    print("Waiting for clients to send request...")
+                    log.info("Client closed connection", host=addr[0], port=addr[1])
                     conn.close()
                     break
         except Exception as e:
 
             # in case of exception - closing connection with the client
             if e.args[0] == CLIENT_CLOSED_CONNECTION_1 or e.args[0] == CLIENT_CLOSED_CONNECTION_2:
-                print("Client closed connection.")
+                log.info("Client closed connection", host=addr[0], port=addr[1])
             else:
-                print("Exception occurred: " + repr(e))
-            print(f'closing connection from host: {addr[0]} port: {addr[1]}\n')
-            print("Waiting for clients to send request...")
+                log.error("Exception occurred, closing connection", error=repr(e), host=addr[0], port=addr[1])
             conn.close()
+        finally:
+            self.metrics.dec("upload_server_connections_active")
 
-    @staticmethod
-    def handle_client_doesnt_exit(conn):
+    def record_timing(self, request):
+        """
+        Records the time of the phases of a request that was handled, and logs them if the request was slow
+        :param request:
+        :return:
+        """
+        timer, seconds = timing.finish()
+        if timer is None:
+            return
+
+        code = request.get_code()
+        for name, phase_seconds in timer.phases.items():
+            self.metrics.observe("upload_server_request_phase_seconds", phase_seconds, code=code, phase=name)
+
+        if seconds * 1000 >= self.slow_request_ms:
+            phases = {f"{name}_ms": round(phase_seconds * 1000, 3) for name, phase_seconds in
+                      sorted(timer.phases.items(), key=lambda item: item[1], reverse=True)}
+            log.warning("Slow request", code=code, client_id=request.get_client_id().hex(),
+                        total_ms=round(seconds * 1000, 3), **phases)
+
+    @timing.timed("recv")
+    def recv_exact(self, conn, size):
+        """
+        Receives exactly size bytes from the client - a single recv may return less than asked
+        :param conn:
+        :param size:
+        :return: the received bytes
+        """
+        data = b''
+        while len(data) < size:
+            chunk = conn.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("Client closed connection in the middle of a request")
+            data += chunk
+        self.metrics.inc("upload_server_bytes_received_total", len(data))
+        return data
+
+    @timing.timed("send")
+    def send_response(self, conn, request, response):
+        """
+        Sends response to client, in the layout of the version of the request it answers
+        :param conn:
+        :param request:
+        :param response:
+        :return:
+        """
+        # answering with the highest version both client and server speak
+        version = min(response.get_version(), request.get_version())
+
+        # converting response object to response data stream
+        response_data = pack('=BHI' + str(UUID_LENGTH) + 's', version, response.get_code(),
+                             response.get_payload_size(), response.get_client_id())
+
+        # echoing the request id so the client can match the response to its request
+        if request.get_code() != CLIENT_CODE_REGISTER and request.get_version() >= VERSION_PIPELINING:
+            response_data += pack('<I', request.get_request_id())
+
+        conn.sendall(response_data + response.get_payload())
+        self.metrics.inc("upload_server_bytes_sent_total", len(response_data) + response.get_payload_size())
+
+    def handle_client_doesnt_exit(self, conn, request):
         """
         Handles case client doesn't exist
         :param conn:
+        :param request:
         :return:
         """
         try:
-            print("client doesn't exist in database\n")
+            log.warning("Client doesn't exist in database", client_id=request.get_client_id().hex())
 
             # sending error because client doesn't exist:
             response = Response(version=SERVER_VERSION, code=SERVER_CODE_REGISTRATION_ERR)
 
-            # converting response object to response data stream and sending response to the client
-            # with error code and client id
-            response_data = pack('=BHI' + str(UUID_LENGTH) + 's', response.get_version(),
-                                 response.get_code(),
-                                 response.get_payload_size(), response.get_client_id())
-            conn.send(response_data)
+            # sending response to the client with error code and client id
+            self.send_response(conn, request, response)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
     def handle_request(self, conn, request, payload):
         """
@@ -247,48 +376,64 @@ class Server:
         code = request.get_code()
         try:
             if code != CLIENT_CODE_REGISTER and not self.database.client_exists_by_id(request.get_client_id()):
-                self.handle_client_doesnt_exit(conn)
+                self.handle_client_doesnt_exit(conn, request)
                 return
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
         if code == CLIENT_CODE_REGISTER:
-            self.handle_client_registration(conn, payload)
+            self.handle_client_registration(conn, request, payload)
         elif code == CLIENT_CODE_SEND_PUBLIC_KEY:
             self.send_aes_key_to_client(conn, request, payload)
         elif code == CLIENT_CODE_SEND_FILE:
-            self.handle_file_request(conn, request)
+            self.handle_file_request(conn, request, payload)
         elif code == CLIENT_CODE_CKSUM_OK:
-            self.handle_cksum_ok(conn, request)
+            self.handle_cksum_ok(conn, request, payload)
         elif code == CLIENT_CODE_CKSUM_ERR:
-            self.handle_cksum_err(conn, request)
+            self.handle_cksum_err(conn, request, payload)
         elif code == CLIENT_CODE_CKSUM_ERR_FINAL:
-            self.handle_cksum_err_final(conn, request)
+            self.handle_cksum_err_final(conn, request, payload)
+        elif code == CLIENT_CODE_FILE_DIGEST:
+            self.handle_file_digest(conn, request, payload)
+        elif code == CLIENT_CODE_SEND_DELTA:
+            self.handle_file_request(conn, request, payload, delta=True)
+        elif code == CLIENT_CODE_SEND_CHUNK:
+            self.handle_file_chunk(conn, request, payload)
+
+    def receive_filename(self, conn, request, payload):
+        """
+        Receives filename of a cksum request
+        :param conn:
+        :param request:
+        :param payload:
+        :return: filename
+        """
+        if request.get_version() >= VERSION_COMPACT_FRAMING:
+            # the payload is the length prefixed filename
+            filename, offset = decode_string(payload)
+        else:
+            # receiving filename data with a fixed length from client
+            frmt = '<' + str(FILENAME_LENGTH) + 's'
+            filename = self.recv_exact(conn, calcsize(frmt))
+
+        # converting the filename data to filename string and stripping from null terminated chars
+        return str(filename.decode('UTF-8')).strip("\0")
 
-    def handle_cksum_err_final(self, conn, request):
+    def handle_cksum_err_final(self, conn, request, payload):
         """
         Handles cksum mismatch between server and client - for the last time
         :param conn:
         :param request:
+        :param payload:
         :return:
         """
         try:
-            # receiving filename data from client
-            frmt = '<' + str(FILENAME_LENGTH) + 's'
-            filename = conn.recv(calcsize(frmt))
-
-            # converting the filename data to filename string and stripping from null terminated chars
-            filename = str(filename.decode('UTF-8')).strip("\0").lower()
+            # receiving filename from client
+            filename = self.receive_filename(conn, request, payload).lower()
 
             client_name = self.database.get_client_name(request.get_client_id())
-            if client_name:
-                print(f"Received request from client \"{client_name}\" - cksum of file \"{filename}\" failed. This was "
-                      f"the last time")
-            else:
-                print(f"Received request from client - cksum of file \"{filename}\" failed. This was "
-                      f"the last time")
-
-            print("Deleting this file\n")
+            log.error("Cksum of file failed for the last time, deleting it", client=client_name, file=filename)
+            self.metrics.inc("upload_server_cksum_failures_total", final="true")
 
             # deleting file from disk of server - according to its path
             file_path = f"files\\{request.get_client_id().hex()}\\{filename}"
@@ -311,94 +456,118 @@ class Server:
             response = Response(version=SERVER_VERSION, code=SERVER_CODE_MESSAGE_RECEIVED,
                                 client_id=request.get_client_id())
 
-            # converting response object to response data stream and sending response to the client
-            # with "message received" code
-            response_data = pack('=BHI' + str(UUID_LENGTH) + 's',
-                                 response.get_version(), response.get_code(), response.get_payload_size(),
-                                 response.get_client_id())
-            conn.send(response_data)
+            # sending response to the client with "message received" code
+            self.send_response(conn, request, response)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
-    def handle_cksum_err(self, conn, request):
+    def handle_cksum_err(self, conn, request, payload):
         """
         Handles cksum mismatch between server and client
         :param request:
         :param conn:
+        :param payload:
         :return:
         """
         try:
-            # receiving filename data from client
-            frmt = '<' + str(FILENAME_LENGTH) + 's'
-            filename = conn.recv(calcsize(frmt))
-
-            # converting the filename data to filename string and stripping from null terminated chars
-            filename = str(filename.decode('UTF-8')).strip("\0")
+            # receiving filename from client
+            filename = self.receive_filename(conn, request, payload)
             client_name = self.database.get_client_name(request.get_client_id())
-            if client_name:
-                print(f"Received request from client \"{client_name}\" - cksum of file \"{filename}\" failed. client "
-                      f"will send file again...\n")
-            else:
-                print(f"Received request from client - cksum of file \"{filename}\" failed. client "
-                      f"will send file again...\n")
+            log.warning("Cksum of file failed, client will send file again", client=client_name, file=filename)
+            self.metrics.inc("upload_server_cksum_failures_total", final="false")
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
-    def handle_cksum_ok(self, conn, request):
+    def handle_cksum_ok(self, conn, request, payload):
         """
         Handles cksum match between server and client
         :param conn:
         :param request:
+        :param payload:
         :return:
         """
         try:
             client_name = self.database.get_client_name(request.get_client_id())
-            if client_name:
-                print(f"Received request from client \"{client_name}\" - cksum succeeded")
-            else:
-                print(f"Received request from client - cksum succeeded")
-
-            # receiving filename data from client
-            frmt = '<' + str(FILENAME_LENGTH) + 's'
-            filename = conn.recv(calcsize(frmt))
 
-            # converting the filename data to filename string and stripping from null terminated chars
-            filename = str(filename.decode('UTF-8')).strip("\0").lower()
+            # receiving filename from client
+            filename = self.receive_filename(conn, request, payload).lower()
+            log.info("Cksum of file succeeded", client=client_name, file=filename)
 
             # updating verification to "True" in file details on the database
             self.database.update_cksum_verification(request.get_client_id(), filename, True)
+            self.metrics.inc("upload_server_files_verified_total")
 
             # creating a response object with the relevant information to send to client
             # "switching keys" code and encrypted aes key
             response = Response(version=SERVER_VERSION, code=SERVER_CODE_MESSAGE_RECEIVED,
                                 client_id=request.get_client_id())
 
-            # converting response object to response data stream and sending response to the client
-            # with "message received" code
-            response_data = pack('=BHI' + str(UUID_LENGTH) + 's',
-                                 response.get_version(), response.get_code(), response.get_payload_size(),
-                                 response.get_client_id())
-            conn.send(response_data)
+            # sending response to the client with "message received" code
+            self.send_response(conn, request, response)
 
-            print("Sent response to client - confirm message reception\n")
+            log.debug("Sent response to client - confirm message reception")
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
-    def handle_client_registration(self, conn, payload):
+    def handle_file_digest(self, conn, request, payload):
+        """
+        Handles file digest request - tells the client whether a verified copy of the file is already saved
+        :param conn:
+        :param request:
+        :param payload:
+        :return:
+        """
+        try:
+            # the payload is the length prefixed filename, the size of the file (variable length) and its cksum
+            filename, offset = decode_string(payload)
+            filename = str(filename.decode('UTF-8')).lower()
+            size, offset = decode_varint(payload, offset)
+            cksum, = unpack('<I', payload[offset:offset + 4])
+
+            # the file is present only if it was verified with the same content and is still on disk
+            present = False
+            saved_file = self.database.get_verified_file(request.get_client_id(), filename)
+            if saved_file:
+                pathname, saved_cksum, saved_size = saved_file
+                present = saved_cksum == cksum and saved_size == size and os.path.exists(pathname) \
+                    and os.path.getsize(pathname) == size
+
+            # an older copy of the file lets the client send only the blocks that changed
+            file_path = f"files\\{request.get_client_id().hex()}\\{filename}"
+            if present:
+                log.info("File is unchanged, client doesn't need to send it", file=filename)
+                response = Response(SERVER_VERSION, SERVER_CODE_FILE_PRESENT, request.get_client_id())
+                self.metrics.inc("upload_server_files_unchanged_total")
+            elif request.get_version() >= VERSION_DELTA and os.path.exists(file_path) \
+                    and os.path.getsize(file_path) >= DELTA_MIN_FILE_SIZE:
+                log.debug("File is changed, sending block signatures of the saved copy", file=filename)
+                with timing.phase("delta"), open(file_path, "rb") as file:
+                    signatures = block_signatures(file, os.fstat(file.fileno()).st_size)
+                response = Response(SERVER_VERSION, SERVER_CODE_FILE_SIGNATURES, request.get_client_id(), signatures)
+            else:
+                log.debug("File is missing or changed, client needs to send it", file=filename)
+                response = Response(SERVER_VERSION, SERVER_CODE_FILE_MISSING, request.get_client_id())
+
+            self.send_response(conn, request, response)
+
+        except Exception as e:
+            log.error("Exception occurred", error=repr(e))
+
+    def handle_client_registration(self, conn, request, payload):
         """
         Handles client registration request
         :param conn:
+        :param request:
         :param payload:
         :return:
         """
-        print("Received request from client - registration to server")
         try:
             # converting the payload data to client name string and stripping from null terminated chars
             client_name = str(payload.decode('UTF-8')).strip("\0")
-            print(f"Client is asking to register with client name \"{client_name}\"")
+            log.debug("Client is asking to register", client=client_name)
             if not self.database.client_exists_by_name(client_name):
                 # in case client name doesn't exist yet:
                 # generating a random client id
@@ -414,21 +583,18 @@ class Server:
                 # inserting new client details to the database
                 self.database.insert_new_client(client_name, response)
 
-                print("Sending response to client: Successful Registration\n")
+                log.info("Client registered", client=client_name)
             else:
                 # in case client name already exists:
                 response = Response(version=SERVER_VERSION, code=SERVER_CODE_REGISTRATION_ERR)
 
-                print("Sending response to client: Registration Failed\n")
+                log.info("Registration failed, client name exists", client=client_name)
 
-            # converting response object to response data stream and sending response to the client
-            # with a successful registration code and client id
-            response_data = pack('=BHI' + str(UUID_LENGTH) + 's', response.get_version(), response.get_code(),
-                                 response.get_payload_size(), response.get_client_id())
-            conn.send(response_data)
+            # sending response to the client with the registration code and client id
+            self.send_response(conn, request, response)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
     def send_aes_key_to_client(self, conn, request, payload):
         """
@@ -440,15 +606,16 @@ class Server:
         """
         try:
             client_name = self.database.get_client_name(request.get_client_id())
-            if client_name:
-                print(f"Received request from client \"{client_name}\" - client is asking for AES key")
-            else:
-                print(f"Received request from client - client is asking for AES key")
+            log.debug("Client is asking for AES key", client=client_name)
             client_id = request.get_client_id()
 
             # receiving client name and public key from client
-            frmt = '<' + str(CLIENT_NAME_LENGTH) + 's' + str(PUBLIC_KEY_SIZE) + 's'
-            client_name, public_key = unpack(frmt, payload)
+            if request.get_version() >= VERSION_COMPACT_FRAMING:
+                client_name, offset = decode_string(payload)
+                public_key = payload[offset:]
+            else:
+                frmt = '<' + str(CLIENT_NAME_LENGTH) + 's' + str(PUBLIC_KEY_SIZE) + 's'
+                client_name, public_key = unpack(frmt, payload)
 
             # converting the client name data to client name string and stripping from null terminated chars
             client_name = client_name.decode('UTF-8').strip("\0")
@@ -464,109 +631,228 @@ class Server:
             cipher = PKCS1_OAEP.new(rsa_public_key)
 
             # encrypting aes key with RSA public key
-            cipher_aes_key = cipher.encrypt(aes_key)
-
-            # getting the length of encrypted aes key
-            cipher_aes_key_length = len(cipher_aes_key)
+            with timing.phase("rsa"):
+                cipher_aes_key = cipher.encrypt(aes_key)
 
             # creating a response object with the relevant information to send to client
             # "switching keys" code and encrypted aes key
             response = Response(version=SERVER_VERSION, code=SERVER_CODE_SWITCHING_KEYS, client_id=client_id,
                                 payload=cipher_aes_key)
 
-            # converting response object to response data stream and sending response to the client
-            # with "switching keys" code and encrypted aes key
-            response_data = pack('=BHI' + str(UUID_LENGTH) + 's' + str(cipher_aes_key_length) + 's',
-                                 response.get_version(), response.get_code(), response.get_payload_size(),
-                                 response.get_client_id(), response.get_payload())
-            conn.send(response_data)
+            # sending response to the client with "switching keys" code and encrypted aes key
+            self.send_response(conn, request, response)
 
-            print("Sent response to client - sent key\n")
+            log.info("Sent AES key to client", client=client_name)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
-    def handle_file_request(self, conn, request):
+    def handle_file_request(self, conn, request, payload, delta=False):
         """
         Handle file request from client
         :param conn:
         :param request:
+        :param payload:
+        :param delta: whether the content is a delta against the saved copy of the file
         :return:
         """
         try:
+            if request.get_version() >= VERSION_COMPACT_FRAMING:
+                # the payload is the length prefixed filename followed by the encrypted content
+                # from compression version on, the codec of the content comes between them
+                filename, offset = decode_string(payload)
+                filename = str(filename.decode('UTF-8')).lower()
+                codec = CODEC_NONE
+                if request.get_version() >= VERSION_COMPRESSION:
+                    codec = payload[offset]
+                    offset += 1
+                self.process_file_content(conn, request, filename, payload[offset:], codec, delta)
+                return
+
             # receiving request data from client
             frmt = '=' + str(UUID_LENGTH) + 'sI' + str(FILENAME_LENGTH) + 's'
-            file_data = conn.recv(calcsize(frmt))
+            file_data = self.recv_exact(conn, calcsize(frmt))
 
             if file_data:
                 # converting the request data stream to items of request object
                 client_id, content_size, filename = unpack(frmt, file_data)
                 filename = str(filename.decode('UTF-8')).strip("\0").lower()
 
-                encrypted_content_file = conn.recv(content_size)
+                encrypted_content_file = self.recv_exact(conn, content_size)
 
                 # continue processing the file
                 self.process_file_content(conn, request, filename, encrypted_content_file)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
 
-    def process_file_content(self, conn, request, filename, encrypted_content_file):
+    def process_file_content(self, conn, request, filename, encrypted_content_file, codec=CODEC_NONE, delta=False):
         """
         Processes file content - saves it on server disk and checks cksum
         :param conn:
         :param request:
         :param filename:
         :param encrypted_content_file:
+        :param codec: codec the content was compressed with before it was encrypted
+        :param delta: whether the content is a delta against the saved copy of the file
         :return:
         """
         try:
             client_name = self.database.get_client_name(request.get_client_id())
-            if client_name:
-                print(f'Received request from client \"{client_name}\" - file: "{filename}" to store in server')
-            else:
-                print(f'Received request from client - file: "{filename}" to store in server')
-
-            # getting AES key from database
-            aes_key = self.database.get_aes_key_of_client(request.get_client_id())
-
-            # setting initialization vector to zeros of block size
-            iv = ("\x00" * AES.block_size).encode("utf8")
-
-            # getting AES key object
-            cipher = AES.new(aes_key, AES.MODE_CBC, iv=iv)
-
-            # decrypting file content with AES key object
-            decrypted_content_file = unpad(cipher.decrypt(encrypted_content_file), AES.block_size)
+            log.debug("Received file to store in server", client=client_name, file=filename)
 
-            # creating "files" directory if not exist
-            dir_name = f"files"
-            if not os.path.exists(dir_name):
-                os.mkdir(dir_name)
-            # creating client id directory inside "files" directory, if not exist
-            dir_name = dir_name + "\\" + request.get_client_id().hex()
-            if not os.path.exists(dir_name):
-                os.mkdir(dir_name)
+            # decrypting and decompressing the file content
+            decrypted_content_file = self.decrypt_content(request, encrypted_content_file, codec)
 
             # appending file path of the file
-            file_path = f"files\\{request.get_client_id().hex()}\\{filename}"
+            file_path = self.prepare_file_path(request, filename)
+
+            # rebuilding the file from the saved copy and the blocks that changed, next to the saved copy which it
+            # replaces once it is complete
+            if delta:
+                log.debug("Rebuilding file from the saved copy and the delta", file=filename)
+                delta_path = file_path + ".delta"
+                with timing.phase("delta"), open(file_path, "rb") as old_file, open(delta_path, "wb") as new_file:
+                    content_size = apply_delta(old_file, decrypted_content_file, new_file)
+                with timing.phase("write"):
+                    os.replace(delta_path, file_path)
+                self.complete_file(conn, request, filename, file_path, content_size)
+                return
 
             # opening file to write the file content sent by the client
-            with open(file_path, "wb") as file:
+            with timing.phase("write"), open(file_path, "wb") as file:
                 if not file.writable():
-                    print("Unable to write file")
+                    log.error("Unable to write file", path=file_path)
                 else:
 
                     # writing file content of the client to output file in server disk
                     file.write(decrypted_content_file)
 
+            self.complete_file(conn, request, filename, file_path, len(decrypted_content_file))
+
+        except Exception as e:
+            log.error("Exception occurred", error=repr(e))
+
+    def handle_file_chunk(self, conn, request, payload):
+        """
+        Handles a chunk of a file - writes it at its offset, and completes the file once all of its bytes arrived
+        :param conn:
+        :param request:
+        :param payload:
+        :return:
+        """
+        try:
+            # the payload is the length prefixed filename, the codec, the offset of the chunk and the size of the file
+            # (both variable length) followed by the encrypted chunk
+            filename, offset = decode_string(payload)
+            filename = str(filename.decode('UTF-8')).lower()
+            codec = payload[offset]
+            chunk_offset, offset = decode_varint(payload, offset + 1)
+            file_size, offset = decode_varint(payload, offset)
+
+            chunk = self.decrypt_content(request, payload[offset:], codec)
+            file_path = self.prepare_file_path(request, filename)
+            part_path = file_path + ".part"
+
+            # the chunks of a file may arrive in any order - each one is written at its own offset
+            # the received chunks outlive the connection, so a client that reconnects sends only the missing ones
+            with self.__chunks_lock:
+                key = (request.get_client_id(), filename)
+                upload = self.__chunked_uploads.get(key)
+                if upload is None or upload["size"] != file_size or not os.path.exists(part_path):
+                    open(part_path, "wb").close()
+                    upload = {"size": file_size, "chunks": {}}
+                    self.__chunked_uploads[key] = upload
+
+                with timing.phase("write"), open(part_path, "r+b") as file:
+                    file.seek(chunk_offset)
+                    file.write(chunk)
+
+                # a chunk sent again after a broken connection replaces its first copy, and is counted once
+                upload["chunks"][chunk_offset] = len(chunk)
+                is_complete = sum(upload["chunks"].values()) >= file_size
+                if is_complete:
+                    del self.__chunked_uploads[key]
+
+            if not is_complete:
+                response = Response(SERVER_VERSION, SERVER_CODE_CHUNK_RECEIVED, request.get_client_id())
+                self.send_response(conn, request, response)
+                return
+
+            log.debug("Received all chunks of file", file=filename, size=file_size)
+            with timing.phase("write"):
+                os.replace(part_path, file_path)
+            self.complete_file(conn, request, filename, file_path, file_size)
+
+        except Exception as e:
+            log.error("Exception occurred", error=repr(e))
+
+    def decrypt_content(self, request, encrypted_content, codec):
+        """
+        Decrypts content sent by the client and decompresses it
+        :param request:
+        :param encrypted_content:
+        :param codec: codec the content was compressed with before it was encrypted
+        :return: the original content
+        """
+        # getting AES key from database
+        aes_key = self.database.get_aes_key_of_client(request.get_client_id())
+
+        # setting initialization vector to zeros of block size
+        iv = ("\x00" * AES.block_size).encode("utf8")
+
+        # getting AES key object
+        cipher = AES.new(aes_key, AES.MODE_CBC, iv=iv)
+
+        # decrypting content with AES key object
+        with timing.phase("decrypt"):
+            decrypted_content = unpad(cipher.decrypt(encrypted_content), AES.block_size)
+
+        # decompressing the content, so the file is saved and its cksum calculated over the original content
+        with timing.phase("decompress"):
+            return self.decompress_content(decrypted_content, codec)
+
+    @staticmethod
+    def prepare_file_path(request, filename):
+        """
+        Returns the path of a file of a client, creating the directories of the client if needed
+        :param request:
+        :param filename:
+        :return: file path
+        """
+        # creating "files" directory if not exist
+        dir_name = f"files"
+        if not os.path.exists(dir_name):
+            os.mkdir(dir_name)
+        # creating client id directory inside "files" directory, if not exist
+        dir_name = dir_name + "\\" + request.get_client_id().hex()
+        if not os.path.exists(dir_name):
+            os.mkdir(dir_name)
+
+        return f"files\\{request.get_client_id().hex()}\\{filename}"
+
+    def complete_file(self, conn, request, filename, file_path, content_size):
+        """
+        Registers a file saved on server disk, calculates its cksum and sends it to the client
+        :param conn:
+        :param request:
+        :param filename:
+        :param file_path:
+        :param content_size:
+        :return:
+        """
+        try:
+            # a file completed as a whole or as a delta makes the chunks received of it before obsolete
+            with self.__chunks_lock:
+                self.__chunked_uploads.pop((request.get_client_id(), filename), None)
+
             # creating new file object and inserting it to file map with file path as key and file object as value
             file = File(client_id=request.get_client_id(), filename=filename, pathname=file_path)
             self.__file_map[file_path] = file
             self.__client_map[request.get_client_id()].add_file(file_path, file)
 
             # calculating cksum of the decrypted content file
-            print(f"Calculating cksum of file \"{filename}\". It may take a while. Please Wait...")
+            log.debug("Calculating cksum of file", file=filename)
             cksum = self.cksum_calc(file_path)
 
             if not self.database.file_exists(request.get_client_id(), filename):
@@ -576,32 +862,59 @@ class Server:
                 # just updating verified cksum to "False"
                 self.database.update_cksum_verification(request.get_client_id(), filename, False)
 
-            # creating a response object with the relevant information to send to client
-            # "cksum ready" code
-            response = Response(SERVER_VERSION, SERVER_CODE_CKSUM_READY, request.get_client_id())
+            # saving the digest of the file, so an unchanged file doesn't need to be sent again once verified
+            self.database.update_file_digest(request.get_client_id(), filename, cksum, content_size)
+
+            if request.get_version() >= VERSION_COMPACT_FRAMING:
+                # packing content size, length prefixed filename and cksum
+                cksum_data = encode_varint(content_size) + encode_string(filename.encode("utf8")) + pack('<I', cksum)
+            else:
+                # padding filename with null terminated chars to get to client name length
+                filename = filename + (CLIENT_NAME_LENGTH - len(filename)) * "\x00"
 
-            # padding filename with null terminated chars to get to client name length
-            filename = filename + (CLIENT_NAME_LENGTH - len(filename)) * "\x00"
+                # converting filename from string to bytes
+                filename_data = filename.encode("utf8")
 
-            # converting filename from string to bytes
-            filename_data = filename.encode("utf8")
+                # packing content size, filename and cksum
+                cksum_data = pack('<I' + str(FILENAME_LENGTH) + 's' + 'I', content_size, filename_data, cksum)
 
-            # converting response object to response data stream and sending response to the client
-            response_data = pack('=BHI' + str(UUID_LENGTH) + 's' + 'I',
-                                 response.get_version(), response.get_code(), response.get_payload_size(),
-                                 response.get_client_id(), len(decrypted_content_file))
-            conn.send(response_data)
+            # creating a response object with the relevant information to send to client
+            # "cksum ready" code
+            if request.get_version() >= VERSION_PIPELINING:
+                # the cksum details are the payload of the response
+                response = Response(SERVER_VERSION, SERVER_CODE_CKSUM_READY, request.get_client_id(), cksum_data)
+                self.send_response(conn, request, response)
+            else:
+                # legacy layout - the cksum details follow a response without payload
+                response = Response(SERVER_VERSION, SERVER_CODE_CKSUM_READY, request.get_client_id())
+                self.send_response(conn, request, response)
+                with timing.phase("send"):
+                    conn.sendall(cksum_data)
+                self.metrics.inc("upload_server_bytes_sent_total", len(cksum_data))
 
-            # packing filename and cksum and sending them to the client
-            response_data = pack('<' + str(FILENAME_LENGTH) + 's' + 'I', filename_data, cksum)
-            conn.send(response_data)
+            self.metrics.inc("upload_server_files_received_total")
 
-            print(f"Sent file confirmation with cksum ({cksum}) to client\n")
+            log.info("Received file", file=filename.rstrip("\0"), size=content_size, cksum=cksum)
 
         except Exception as e:
-            print("Exception occurred: " + repr(e))
+            log.error("Exception occurred", error=repr(e))
+
+    @staticmethod
+    def decompress_content(content, codec):
+        """
+        Decompresses file content according to the codec it was compressed with
+        :param content:
+        :param codec:
+        :return: the original content
+        """
+        if codec == CODEC_NONE:
+            return content
+        if codec == CODEC_ZLIB:
+            return zlib.decompress(content)
+        raise ValueError(f"Unknown codec {codec}")
 
     @staticmethod
+    @timing.timed("cksum")
     def cksum_calc(file_path):
         """
         Calculates cksum of file
@@ -0,0 +1,136 @@
+# timing.py
+# Author: Elad Sheffer
+
+import functools
+import os
+import threading
+import time
+from contextlib import contextmanager
+
+import log
+
+SLOW_REQUEST_FILE = "slow.info"  # milliseconds from which a request is logged with its phases, 1000 if missing
+DEFAULT_SLOW_REQUEST_MS = 1000
+OTHER_PHASE = "other"  # time of a request outside all of its phases
+
+__local = threading.local()
+
+
+class RequestTimer:
+    """
+    Time spent in every phase of handling a request. Phases may nest - the time of a nested phase is taken out of
+    the phase around it, so the phases and "other" add up to the time of the request
+    """
+
+    def __init__(self):
+        self.started = time.perf_counter()
+        self.phases = {}
+        self.__stack = []
+        self.__mark = self.started
+
+    def enter(self, name):
+        """
+        Starts a phase, pausing the phase it is nested in
+        :param name:
+        :return:
+        """
+        now = time.perf_counter()
+        self.__charge(now)
+        self.__stack.append(name)
+
+    def exit(self):
+        """
+        Ends the last phase started, resuming the phase it is nested in
+        :return:
+        """
+        now = time.perf_counter()
+        self.__charge(now)
+        self.__stack.pop()
+
+    def __charge(self, now):
+        name = self.__stack[-1] if self.__stack else OTHER_PHASE
+        self.phases[name] = self.phases.get(name, 0.0) + now - self.__mark
+        self.__mark = now
+
+    def finish(self):
+        """
+        Ends the request
+        :return: seconds since the request started
+        """
+        now = time.perf_counter()
+        while self.__stack:
+            self.__charge(now)
+            self.__stack.pop()
+        self.__charge(now)
+        return now - self.started
+
+
+def load_slow_request_ms():
+    """
+    Loads the threshold of slow requests from its file - 0 logs every request
+    :return: milliseconds
+    """
+    try:
+        if os.path.exists(SLOW_REQUEST_FILE):
+            with open(SLOW_REQUEST_FILE, "r") as file:
+                value = file.readline().strip()
+            if value.isnumeric():
+                return int(value)
+            log.error("Invalid threshold of slow requests", value=value)
+    except Exception as e:
+        log.error("Exception occurred", error=repr(e))
+    return DEFAULT_SLOW_REQUEST_MS
+
+
+def start():
+    """
+    Starts timing the request handled by the current thread
+    :return: the timer
+    """
+    __local.timer = RequestTimer()
+    return __local.timer
+
+
+def finish():
+    """
+    Ends timing the request handled by the current thread
+    :return: the timer and the seconds of the request
+    """
+    timer = getattr(__local, "timer", None)
+    __local.timer = None
+    return timer, timer.finish() if timer else 0.0
+
+
+@contextmanager
+def phase(name):
+    """
+    Counts the time of a block as a phase of the request handled by the current thread - nothing is counted outside
+    of a request, such as loading the database at startup
+    :param name:
+    :return:
+    """
+    timer = getattr(__local, "timer", None)
+    if timer is None:
+        yield
+        return
+
+    timer.enter(name)
+    try:
+        yield
+    finally:
+        timer.exit()
+
+
+def timed(name):
+    """
+    Decorator counting the time of every call of a function as a phase
+    :param name:
+    :return:
+    """
+    def decorator(function):
+        @functools.wraps(function)
+        def wrapper(*args, **kwargs):
+            with phase(name):
+                return function(*args, **kwargs)
+        return wrapper
+    return decorator
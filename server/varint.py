@@ -0,0 +1,63 @@
+# varint.py
+# Author: Elad Sheffer
+
+MAX_VARINT_LENGTH = 10
+
+
+def encode_varint(value):
+    """
+    Encodes a number in variable length encoding - 7 bits in each byte, least significant first,
+    the high bit of a byte is set if more bytes follow
+    :param value:
+    :return: encoded bytes
+    """
+    data = bytearray()
+    while value >= 0x80:
+        data.append((value & 0x7F) | 0x80)
+        value >>= 7
+    data.append(value)
+    return bytes(data)
+
+
+def decode_varint(data, offset=0):
+    """
+    Decodes a number in variable length encoding
+    :param data:
+    :param offset: offset to read from
+    :return: the number and the offset past it
+    """
+    value = 0
+    for i in range(MAX_VARINT_LENGTH):
+        if offset >= len(data):
+            break
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << (7 * i)
+
+        # the last byte of the number doesn't have the high bit set
+        if not byte & 0x80:
+            return value, offset
+
+    raise ValueError("Invalid variable length number")
+
+
+def encode_string(data):
+    """
+    Encodes bytes prefixed with their length in variable length encoding
+    :param data:
+    :return: encoded bytes
+    """
+    return encode_varint(len(data)) + data
+
+
+def decode_string(data, offset=0):
+    """
+    Decodes bytes prefixed with their length in variable length encoding
+    :param data:
+    :param offset: offset to read from
+    :return: the bytes and the offset past them
+    """
+    length, offset = decode_varint(data, offset)
+    if offset + length > len(data):
+        raise ValueError("Invalid length prefixed string")
+    return data[offset:offset + length], offset + length
@@ -0,0 +1,167 @@
+#include "MemoryStore.h"
+#include <stdexcept>
+#include <cstring>
+
+/// <summary>
+/// Ctor
+/// </summary>
+MemoryStore::MemoryStore() : random(std::random_device()()) {
+}
+
+/// <summary>
+/// Registers a new client with a random id
+/// </summary>
+/// <param name="name"></param>
+/// <param name="clientId"></param>
+/// <returns>false if a client with the name is already registered</returns>
+bool MemoryStore::registerClient(const std::string& name, ClientId& clientId) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	if (!this->clientNames.insert(name).second)
+		return false;
+
+	do {
+		for (unsigned char& c : clientId)
+			c = (unsigned char)this->random();
+	} while (this->clients.count(clientId) > 0);
+
+	this->clients[clientId] = { name, "" };
+	return true;
+}
+
+/// <summary>
+/// Returns true if a client is registered
+/// </summary>
+/// <param name="clientId"></param>
+/// <returns></returns>
+bool MemoryStore::clientExists(const ClientId& clientId) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->clients.count(clientId) > 0;
+}
+
+/// <summary>
+/// Saves the AES key of a client
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="aesKey"></param>
+void MemoryStore::setAesKey(const ClientId& clientId, const std::string& aesKey) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto client = this->clients.find(clientId);
+	if (client != this->clients.end())
+		client->second.aesKey = aesKey;
+}
+
+/// <summary>
+/// Returns the AES key of a client
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="aesKey"></param>
+/// <returns>false if the client has no key yet</returns>
+bool MemoryStore::getAesKey(const ClientId& clientId, std::string& aesKey) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto client = this->clients.find(clientId);
+	if (client == this->clients.end() || client->second.aesKey.empty())
+		return false;
+
+	aesKey = client->second.aesKey;
+	return true;
+}
+
+/// <summary>
+/// Saves the content of a file as not verified yet, replacing an earlier copy of it
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="filename"></param>
+/// <param name="content">taken over by the store</param>
+/// <param name="cksum"></param>
+void MemoryStore::saveFile(const ClientId& clientId, const std::string& filename, std::string content, uint32_t cksum) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	// a file completed as a whole makes the chunks received of it before obsolete
+	this->chunkedUploads.erase({ clientId, filename });
+	this->files[{ clientId, filename }] = { std::move(content), cksum, false };
+}
+
+/// <summary>
+/// Marks a file as verified by the client
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="filename"></param>
+void MemoryStore::verifyFile(const ClientId& clientId, const std::string& filename) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto file = this->files.find({ clientId, filename });
+	if (file != this->files.end())
+		file->second.isVerified = true;
+}
+
+/// <summary>
+/// Deletes a file
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="filename"></param>
+void MemoryStore::deleteFile(const ClientId& clientId, const std::string& filename) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->files.erase({ clientId, filename });
+}
+
+/// <summary>
+/// Returns true if a verified copy of a file with the same size and cksum is saved
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="filename"></param>
+/// <param name="size"></param>
+/// <param name="cksum"></param>
+/// <returns></returns>
+bool MemoryStore::isFilePresent(const ClientId& clientId, const std::string& filename, uint64_t size, uint32_t cksum) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto file = this->files.find({ clientId, filename });
+	return file != this->files.end() && file->second.isVerified && file->second.content.size() == size
+		&& file->second.cksum == cksum;
+}
+
+/// <summary>
+/// Writes a chunk of a file at its offset
+/// </summary>
+/// <param name="clientId"></param>
+/// <param name="filename"></param>
+/// <param name="offset"></param>
+/// <param name="fileSize"></param>
+/// <param name="chunk"></param>
+/// <param name="content">the whole file, once all of its bytes arrived</param>
+/// <returns>true if the chunk completed the file</returns>
+bool MemoryStore::writeChunk(const ClientId& clientId, const std::string& filename, uint64_t offset, uint64_t fileSize,
+	const std::string& chunk, std::string& content) {
+
+	if (offset > fileSize || chunk.size() > fileSize - offset)
+		throw std::out_of_range("chunk of " + std::to_string(chunk.size()) + " bytes at offset "
+			+ std::to_string(offset) + " is past the end of a file of " + std::to_string(fileSize) + " bytes");
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	// the chunks of a file may arrive in any order - each one is written at its own offset
+	auto key = std::make_pair(clientId, filename);
+	auto upload = this->chunkedUploads.find(key);
+	if (upload == this->chunkedUploads.end() || upload->second.fileSize != fileSize) {
+		ChunkedUpload newUpload = { fileSize, std::string((size_t)fileSize, '\0'), {} };
+		upload = this->chunkedUploads.insert_or_assign(key, std::move(newUpload)).first;
+	}
+
+	if (!chunk.empty())
+		std::memcpy(&upload->second.content[(size_t)offset], chunk.data(), chunk.size());
+
+	// a chunk sent again after a broken connection replaces its first copy, and is counted once
+	upload->second.chunks[offset] = chunk.size();
+	uint64_t receivedBytes = 0;
+	for (const auto& received : upload->second.chunks)
+		receivedBytes += received.second;
+	if (receivedBytes < fileSize)
+		return false;
+
+	content = std::move(upload->second.content);
+	this->chunkedUploads.erase(upload);
+	return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <array>
+#include <map>
+#include <set>
+#include <mutex>
+#include <random>
+#include "request.h"
+
+typedef std::array<unsigned char, UUID_LENGTH> ClientId;
+
+/// <summary>
+/// What the stand-in server keeps of a client - the database row of the real server
+/// </summary>
+struct StoredClient {
+	std::string name;
+	std::string aesKey;
+};
+
+/// <summary>
+/// A received file - its content stays in memory instead of on disk
+/// </summary>
+struct StoredFile {
+	std::string content;
+	uint32_t cksum;
+	bool isVerified;
+};
+
+/// <summary>
+/// A file sent in chunks, assembled in memory until all of its bytes arrived
+/// </summary>
+struct ChunkedUpload {
+	uint64_t fileSize;
+	std::string content;
+	std::map<uint64_t, size_t> chunks;
+};
+
+/// <summary>
+/// Clients, keys and files of the stand-in server, shared by all of its sessions.
+/// Everything is kept in memory, so nothing outlives the process
+/// </summary>
+class MemoryStore {
+
+private:
+	// members
+	std::mutex mutex;
+	std::mt19937_64 random;
+	std::set<std::string> clientNames;
+	std::map<ClientId, StoredClient> clients;
+	std::map<std::pair<ClientId, std::string>, StoredFile> files;
+	std::map<std::pair<ClientId, std::string>, ChunkedUpload> chunkedUploads;
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	MemoryStore();
+
+	/// <summary>
+	/// Registers a new client with a random id
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="clientId"></param>
+	/// <returns>false if a client with the name is already registered</returns>
+	bool registerClient(const std::string& name, ClientId& clientId);
+
+	/// <summary>
+	/// Returns true if a client is registered
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <returns></returns>
+	bool clientExists(const ClientId& clientId);
+
+	/// <summary>
+	/// Saves the AES key of a client
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="aesKey"></param>
+	void setAesKey(const ClientId& clientId, const std::string& aesKey);
+
+	/// <summary>
+	/// Returns the AES key of a client
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="aesKey"></param>
+	/// <returns>false if the client has no key yet</returns>
+	bool getAesKey(const ClientId& clientId, std::string& aesKey);
+
+	/// <summary>
+	/// Saves the content of a file as not verified yet, replacing an earlier copy of it
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="filename"></param>
+	/// <param name="content">taken over by the store</param>
+	/// <param name="cksum"></param>
+	void saveFile(const ClientId& clientId, const std::string& filename, std::string content, uint32_t cksum);
+
+	/// <summary>
+	/// Marks a file as verified by the client
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="filename"></param>
+	void verifyFile(const ClientId& clientId, const std::string& filename);
+
+	/// <summary>
+	/// Deletes a file
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="filename"></param>
+	void deleteFile(const ClientId& clientId, const std::string& filename);
+
+	/// <summary>
+	/// Returns true if a verified copy of a file with the same size and cksum is saved
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="filename"></param>
+	/// <param name="size"></param>
+	/// <param name="cksum"></param>
+	/// <returns></returns>
+	bool isFilePresent(const ClientId& clientId, const std::string& filename, uint64_t size, uint32_t cksum);
+
+	/// <summary>
+	/// Writes a chunk of a file at its offset
+	/// </summary>
+	/// <param name="clientId"></param>
+	/// <param name="filename"></param>
+	/// <param name="offset"></param>
+	/// <param name="fileSize"></param>
+	/// <param name="chunk"></param>
+	/// <param name="content">the whole file, once all of its bytes arrived</param>
+	/// <returns>true if the chunk completed the file</returns>
+	bool writeChunk(const ClientId& clientId, const std::string& filename, uint64_t offset, uint64_t fileSize,
+		const std::string& chunk, std::string& content);
+};
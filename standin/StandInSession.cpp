@@ -0,0 +1,482 @@
+#include "StandInSession.h"
+#include "fileitem.h"
+#include "AESWrapper.h"
+#include "RSAWrapper.h"
+#include "CompressionWrapper.h"
+#include "Varint.h"
+#include "crc.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+/// <summary>
+/// Adds the counts of another session - but its duration, since sessions overlap
+/// </summary>
+/// <param name="other"></param>
+void SessionStats::add(const SessionStats& other) {
+	this->requests += other.requests;
+	this->files += other.files;
+	this->contentBytes += other.contentBytes;
+	this->bytesReceived += other.bytesReceived;
+	this->bytesSent += other.bytesSent;
+	this->handlingTime += other.handlingTime;
+}
+
+/// <summary>
+/// Writes the counts in a line, with the content throughput over the duration
+/// </summary>
+/// <param name="out"></param>
+/// <param name="name"></param>
+void SessionStats::write(std::ostream& out, const std::string& name) const {
+
+	double seconds = std::chrono::duration<double>(this->duration).count();
+	double handlingSeconds = std::chrono::duration<double>(this->handlingTime).count();
+	double megabytes = (double)this->contentBytes / (1024 * 1024);
+
+	out << name << ": " << this->requests << " requests, " << this->files << " files, " << this->contentBytes
+		<< " content bytes, " << this->bytesReceived << " bytes received, " << this->bytesSent << " bytes sent, "
+		<< std::fixed << std::setprecision(3) << seconds << "s (handling " << handlingSeconds << "s), "
+		<< std::setprecision(2) << (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << std::endl;
+}
+
+/// <summary>
+/// Ctor
+/// </summary>
+/// <param name="socket">connected socket of the client</param>
+/// <param name="store"></param>
+/// <param name="maxVersion">highest protocol version to answer with</param>
+StandInSession::StandInSession(tcp::socket socket, MemoryStore& store, uint8_t maxVersion)
+	: socket(std::move(socket)), store(store) {
+	this->maxVersion = maxVersion;
+}
+
+/// <summary>
+/// Answers the requests of the client until it closes the connection
+/// </summary>
+void StandInSession::run() {
+
+	auto start = std::chrono::steady_clock::now();
+	try {
+		Request request;
+		while (this->receiveRequest(request)) {
+			auto handlingStart = std::chrono::steady_clock::now();
+			bool canGoOn = this->handleRequest(request);
+			this->stats.handlingTime += std::chrono::steady_clock::now() - handlingStart;
+			this->stats.requests++;
+			if (!canGoOn)
+				break;
+		}
+	}
+	catch (std::exception& e) {
+		std::cerr << "Exception: " << e.what() << ", closing connection" << std::endl;
+	}
+
+	boost::system::error_code error;
+	this->socket.shutdown(tcp::socket::shutdown_both, error);
+	this->socket.close(error);
+
+	this->stats.duration = std::chrono::steady_clock::now() - start;
+}
+
+/// <summary>
+/// Returns the counts of the session
+/// </summary>
+/// <returns></returns>
+const SessionStats& StandInSession::getStats() const {
+	return this->stats;
+}
+
+/// <summary>
+/// Receives exactly the size of a buffer from the client
+/// </summary>
+/// <param name="buffer"></param>
+/// <param name="size"></param>
+void StandInSession::receiveExact(char* buffer, size_t size) {
+	if (size == 0)
+		return;
+	boost::asio::read(this->socket, boost::asio::buffer(buffer, size));
+	this->stats.bytesReceived += size;
+}
+
+/// <summary>
+/// Receives a request - header, request id (from the pipelining version on, but registration) and payload
+/// </summary>
+/// <param name="request"></param>
+/// <returns>false if the client closed the connection</returns>
+bool StandInSession::receiveRequest(Request& request) {
+
+	RequestHeader requestHeader = {};
+	boost::system::error_code error;
+	boost::asio::read(this->socket, boost::asio::buffer(requestHeader.buffer, sizeof(RequestData)), error);
+	if (error == boost::asio::error::eof || error == boost::asio::error::connection_reset)
+		return false;
+	if (error)
+		throw boost::system::system_error(error);
+	this->stats.bytesReceived += sizeof(RequestData);
+
+	RequestData& requestData = requestHeader.requestData;
+
+	// registration is always sent in the legacy layout - the version is negotiated by it
+	RequestIdHeader requestIdHeader = {};
+	if (requestData.code != CLIENT_CODE_REGISTER && requestData.version >= VERSION_PIPELINING)
+		this->receiveExact(requestIdHeader.buffer, sizeof(uint32_t));
+
+	std::string payload(requestData.payloadSize, '\0');
+	this->receiveExact(&payload[0], payload.size());
+
+	request = Request(requestData.clientId, requestData.version, requestData.code, std::move(payload));
+	request.setRequestId(requestIdHeader.requestId);
+	return true;
+}
+
+/// <summary>
+/// Sends response to client, in the layout of the version of the request it answers
+/// </summary>
+/// <param name="request"></param>
+/// <param name="response"></param>
+void StandInSession::sendResponse(Request& request, Response& response) {
+
+	// answering with the highest version both client and server speak
+	ResponseHeader responseHeader = {};
+	responseHeader.responseData.version = std::min(response.getVersion(), request.getVersion());
+	responseHeader.responseData.code = response.getCode();
+	responseHeader.responseData.payloadSize = response.getPayloadSize();
+	std::array<unsigned char, UUID_LENGTH_RESPONSE> clientId = response.getClientId();
+
+	// header, client id, request id and payload are gathered into a single write
+	std::vector<boost::asio::const_buffer> buffers;
+	buffers.push_back(boost::asio::buffer(responseHeader.buffer, sizeof(ResponseData)));
+	buffers.push_back(boost::asio::buffer(clientId.data(), clientId.size()));
+
+	// echoing the request id so the client can match the response to its request
+	RequestIdHeader requestIdHeader = {};
+	requestIdHeader.requestId = request.getRequestId();
+	if (request.getCode() != CLIENT_CODE_REGISTER && request.getVersion() >= VERSION_PIPELINING)
+		buffers.push_back(boost::asio::buffer(requestIdHeader.buffer, sizeof(uint32_t)));
+
+	std::string_view payload = response.getPayload();
+	buffers.push_back(boost::asio::buffer(payload.data(), payload.size()));
+
+	this->stats.bytesSent += boost::asio::write(this->socket, buffers);
+}
+
+/// <summary>
+/// Handles request from client
+/// </summary>
+/// <param name="request"></param>
+/// <returns>false if the connection can't go on</returns>
+bool StandInSession::handleRequest(Request& request) {
+
+	uint16_t code = request.getCode();
+	if (code != CLIENT_CODE_REGISTER && !this->store.clientExists(request.getClientId())) {
+		std::cout << "Client doesn't exist" << std::endl;
+		Response response(this->maxVersion, SERVER_CODE_REGISTRATION_ERR, { 0 }, "");
+		this->sendResponse(request, response);
+		return true;
+	}
+
+	switch (code) {
+	case CLIENT_CODE_REGISTER:
+		this->handleRegistration(request);
+		return true;
+	case CLIENT_CODE_SEND_PUBLIC_KEY:
+		this->sendAesKey(request);
+		return true;
+	case CLIENT_CODE_SEND_FILE:
+		this->handleFile(request);
+		return true;
+	case CLIENT_CODE_CKSUM_OK:
+	case CLIENT_CODE_CKSUM_ERR:
+	case CLIENT_CODE_CKSUM_ERR_FINAL:
+		this->handleCksum(request);
+		return true;
+	case CLIENT_CODE_FILE_DIGEST:
+		this->handleFileDigest(request);
+		return true;
+	case CLIENT_CODE_SEND_CHUNK:
+		this->handleChunk(request);
+		return true;
+	default:
+		// block signatures are never sent, so a delta request can't be applied to anything
+		std::cout << "Unsupported request " << code << ", closing connection" << std::endl;
+		return false;
+	}
+}
+
+/// <summary>
+/// Handles client registration request
+/// </summary>
+/// <param name="request"></param>
+void StandInSession::handleRegistration(Request& request) {
+
+	// the payload is the client name padded with null chars
+	std::string_view payload = request.getPayload();
+	std::string clientName(payload.substr(0, payload.find('\0')));
+
+	ClientId clientId = { 0 };
+	if (this->store.registerClient(clientName, clientId)) {
+		Response response(this->maxVersion, SERVER_CODE_REGISTRATION_OK, clientId, "");
+		this->sendResponse(request, response);
+	}
+	else {
+		std::cout << "Registration failed, client name exists: " << clientName << std::endl;
+		Response response(this->maxVersion, SERVER_CODE_REGISTRATION_ERR, { 0 }, "");
+		this->sendResponse(request, response);
+	}
+}
+
+/// <summary>
+/// Generates an AES key for the client and sends it encrypted with the public RSA key of the client
+/// </summary>
+/// <param name="request"></param>
+void StandInSession::sendAesKey(Request& request) {
+
+	// the payload is the client name (length prefixed, or padded to a fixed length) followed by the public key
+	std::string_view payload = request.getPayload();
+	size_t offset = CLIENT_NAME_LENGTH;
+	std::string clientName;
+	if (request.getVersion() >= VERSION_COMPACT_FRAMING) {
+		offset = 0;
+		if (!Varint::readString(payload, offset, clientName))
+			throw std::invalid_argument("invalid client name in key exchange");
+	}
+	if (payload.size() < offset + PUBLIC_KEY_SIZE)
+		throw std::invalid_argument("invalid public key in key exchange");
+
+	unsigned char aesKey[AESWrapper::DEFAULT_KEYLENGTH];
+	AESWrapper::GenerateKey(aesKey, AESWrapper::DEFAULT_KEYLENGTH);
+	std::string key((const char*)aesKey, AESWrapper::DEFAULT_KEYLENGTH);
+	this->store.setAesKey(request.getClientId(), key);
+
+	RSAPublicWrapper rsapub(std::string(payload.substr(offset, PUBLIC_KEY_SIZE)));
+	Response response(this->maxVersion, SERVER_CODE_SWITCHING_KEYS, request.getClientId(), rsapub.encrypt(key));
+	this->sendResponse(request, response);
+}
+
+/// <summary>
+/// Handles file request - the whole content of a file
+/// </summary>
+/// <param name="request"></param>
+void StandInSession::handleFile(Request& request) {
+
+	if (request.getVersion() >= VERSION_COMPACT_FRAMING) {
+
+		// the payload is the length prefixed filename followed by the encrypted content
+		// from compression version on, the codec of the content comes between them
+		std::string_view payload = request.getPayload();
+		size_t offset = 0;
+		std::string filename;
+		uint8_t codec = CODEC_NONE;
+		if (!Varint::readString(payload, offset, filename))
+			throw std::invalid_argument("invalid filename in file request");
+		if (request.getVersion() >= VERSION_COMPRESSION) {
+			if (offset >= payload.size())
+				throw std::invalid_argument("missing codec in file request");
+			codec = (uint8_t)payload[offset++];
+		}
+
+		std::string content = this->decryptContent(request, payload.data() + offset, payload.size() - offset, codec);
+		this->completeFile(request, normalizeFilename(filename), std::move(content));
+		return;
+	}
+
+	// legacy layout - the client id, content size and a fixed length filename follow the request, then the content
+	FileHeader fileHeader = {};
+	this->receiveExact(fileHeader.buffer, sizeof(FileData));
+	std::string filename(FILENAME_LENGTH, '\0');
+	this->receiveExact(&filename[0], filename.size());
+	std::string encryptedContent(fileHeader.fileData.contentSize, '\0');
+	this->receiveExact(&encryptedContent[0], encryptedContent.size());
+
+	std::string content = this->decryptContent(request, encryptedContent.data(), encryptedContent.size(), CODEC_NONE);
+	this->completeFile(request, normalizeFilename(filename), std::move(content));
+}
+
+/// <summary>
+/// Handles a chunk of a file - answers 2108, or the cksum once all the bytes of the file arrived
+/// </summary>
+/// <param name="request"></param>
+void StandInSession::handleChunk(Request& request) {
+
+	// the payload is the length prefixed filename, the codec, the offset of the chunk and the size of the file
+	// (both variable length) followed by the encrypted chunk
+	std::string_view payload = request.getPayload();
+	size_t offset = 0;
+	std::string filename;
+	uint64_t chunkOffset = 0;
+	uint64_t fileSize = 0;
+	if (!Varint::readString(payload, offset, filename) || offset >= payload.size())
+		throw std::invalid_argument("invalid filename in chunk request");
+	uint8_t codec = (uint8_t)payload[offset++];
+	if (!Varint::read(payload, offset, chunkOffset) || !Varint::read(payload, offset, fileSize))
+		throw std::invalid_argument("invalid offset in chunk request");
+
+	filename = normalizeFilename(filename);
+	std::string chunk = this->decryptContent(request, payload.data() + offset, payload.size() - offset, codec);
+
+	std::string content;
+	if (!this->store.writeChunk(request.getClientId(), filename, chunkOffset, fileSize, chunk, content)) {
+		Response response(this->maxVersion, SERVER_CODE_CHUNK_RECEIVED, request.getClientId(), "");
+		this->sendResponse(request, response);
+		return;
+	}
+
+	this->completeFile(request, filename, std::move(content));
+}
+
+/// <summary>
+/// Handles file digest request - tells the client whether a verified copy of the file is already saved
+/// </summary>
+/// <param name="request"></param>
+void StandInSession::handleFileDigest(Request& request) {
+
+	// the payload is the length prefixed filename, the size of the file (variable length) and its cksum
+	std::string_view payload = request.getPayload();
+	size_t offset = 0;
+	std::string filename;
+	uint64_t size = 0;
+	uint32_t cksum = 0;
+	if (!Varint::readString(payload, offset, filename) || !Varint::read(payload, offset, size)
+		|| payload.size() < offset + sizeof(uint32_t))
+		throw std::invalid_argument("invalid file digest request");
+	std::memcpy(&cksum, payload.data() + offset, sizeof(uint32_t));
+
+	// block signatures are never sent - a changed file is sent again in full
+	uint16_t code = SERVER_CODE_FILE_MISSING;
+	if (this->store.isFilePresent(request.getClientId(), normalizeFilename(filename), size, cksum))
+		code = SERVER_CODE_FILE_PRESENT;
+
+	Response response(this->maxVersion, code, request.getClientId(), "");
+	this->sendResponse(request, response);
+}
+
+/// <summary>
+/// Handles cksum requests - ok, error (not answered) and final error
+/// </summary>
+/// <param name="request"></param>
+void StandInSession::handleCksum(Request& request) {
+
+	std::string filename = this->receiveFilename(request);
+
+	if (request.getCode() == CLIENT_CODE_CKSUM_ERR)
+		return;
+
+	if (request.getCode() == CLIENT_CODE_CKSUM_OK)
+		this->store.verifyFile(request.getClientId(), filename);
+	else
+		this->store.deleteFile(request.getClientId(), filename);
+
+	Response response(this->maxVersion, SERVER_CODE_MESSAGE_RECEIVED, request.getClientId(), "");
+	this->sendResponse(request, response);
+}
+
+/// <summary>
+/// Receives filename of a cksum request
+/// </summary>
+/// <param name="request"></param>
+/// <returns></returns>
+std::string StandInSession::receiveFilename(Request& request) {
+
+	std::string filename;
+	if (request.getVersion() >= VERSION_COMPACT_FRAMING) {
+
+		// the payload is the length prefixed filename
+		size_t offset = 0;
+		if (!Varint::readString(request.getPayload(), offset, filename))
+			throw std::invalid_argument("invalid filename in cksum request");
+	}
+	else {
+
+		// legacy layout - a fixed length filename follows the request
+		filename.resize(FILENAME_LENGTH);
+		this->receiveExact(&filename[0], filename.size());
+	}
+
+	return normalizeFilename(filename);
+}
+
+/// <summary>
+/// Decrypts content sent by the client and decompresses it
+/// </summary>
+/// <param name="request"></param>
+/// <param name="encryptedContent"></param>
+/// <param name="length"></param>
+/// <param name="codec"></param>
+/// <returns>the original content</returns>
+std::string StandInSession::decryptContent(Request& request, const char* encryptedContent, size_t length, uint8_t codec) {
+
+	std::string aesKey;
+	if (!this->store.getAesKey(request.getClientId(), aesKey))
+		throw std::runtime_error("client sent a file before exchanging keys");
+
+	AESWrapper aes((const unsigned char*)aesKey.data(), (unsigned int)aesKey.size());
+	std::string decrypted = aes.decrypt(encryptedContent, (unsigned int)length);
+
+	// decompressing the content, so the cksum is calculated over the original content
+	if (codec == CODEC_NONE)
+		return decrypted;
+	return CompressionWrapper::decompress(decrypted.data(), decrypted.size(), codec);
+}
+
+/// <summary>
+/// Saves a file, calculates its cksum and sends it to the client
+/// </summary>
+/// <param name="request"></param>
+/// <param name="filename"></param>
+/// <param name="content"></param>
+void StandInSession::completeFile(Request& request, const std::string& filename, std::string content) {
+
+	CRC crc;
+	crc.update((unsigned char*)content.data(), (uint32_t)content.size());
+	uint32_t cksum = crc.digest();
+	uint32_t contentSize = (uint32_t)content.size();
+
+	this->stats.files++;
+	this->stats.contentBytes += content.size();
+	this->store.saveFile(request.getClientId(), filename, std::move(content), cksum);
+
+	if (request.getVersion() >= VERSION_COMPACT_FRAMING) {
+
+		// the payload is the content size (variable length), the length prefixed filename and the cksum
+		std::string cksumData;
+		Varint::append(cksumData, contentSize);
+		Varint::appendString(cksumData, filename);
+		cksumData.append((const char*)&cksum, sizeof(uint32_t));
+
+		Response response(this->maxVersion, SERVER_CODE_CKSUM_READY, request.getClientId(), std::move(cksumData));
+		this->sendResponse(request, response);
+		return;
+	}
+
+	// content size, filename padded with null chars and cksum
+	CksumReplyHeader cksumReplyHeader = {};
+	cksumReplyHeader.cksumData.contentSize = contentSize;
+	std::memcpy(cksumReplyHeader.cksumData.filename, filename.data(), std::min(filename.size(), FILENAME_LENGTH));
+	cksumReplyHeader.cksumData.cksum = cksum;
+	std::string cksumData(cksumReplyHeader.buffer, sizeof(CksumData));
+
+	if (request.getVersion() >= VERSION_PIPELINING) {
+		// the cksum details are the payload of the response
+		Response response(this->maxVersion, SERVER_CODE_CKSUM_READY, request.getClientId(), std::move(cksumData));
+		this->sendResponse(request, response);
+	}
+	else {
+		// legacy layout - the cksum details follow a response without payload
+		Response response(this->maxVersion, SERVER_CODE_CKSUM_READY, request.getClientId(), "");
+		this->sendResponse(request, response);
+		this->stats.bytesSent += boost::asio::write(this->socket, boost::asio::buffer(cksumData));
+	}
+}
+
+/// <summary>
+/// Returns a filename with the null chars it was padded with stripped, in lower case like the server saves it
+/// </summary>
+/// <param name="filename"></param>
+/// <returns></returns>
+std::string StandInSession::normalizeFilename(std::string filename) {
+
+	filename.resize(std::min(filename.size(), filename.find('\0')));
+	std::transform(filename.begin(), filename.end(), filename.begin(),
+		[](unsigned char c) { return (char)std::tolower(c); });
+	return filename;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include "request.h"
+#include "response.h"
+#include "MemoryStore.h"
+
+using boost::asio::ip::tcp;
+
+const uint8_t STANDIN_VERSION = VERSION_CHUNKED;
+const size_t CLIENT_NAME_LENGTH = 255;
+const size_t PUBLIC_KEY_SIZE = 160;
+
+/// <summary>
+/// Counts of a session, or of all the sessions of a run
+/// </summary>
+struct SessionStats {
+	uint64_t requests = 0;
+	uint64_t files = 0;
+	uint64_t contentBytes = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t bytesSent = 0;
+	std::chrono::steady_clock::duration handlingTime = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration duration = std::chrono::steady_clock::duration::zero();
+
+	/// <summary>
+	/// Adds the counts of another session - but its duration, since sessions overlap
+	/// </summary>
+	/// <param name="other"></param>
+	void add(const SessionStats& other);
+
+	/// <summary>
+	/// Writes the counts in a line, with the content throughput over the duration
+	/// </summary>
+	/// <param name="out"></param>
+	/// <param name="name"></param>
+	void write(std::ostream& out, const std::string& name) const;
+};
+
+/// <summary>
+/// A connection of a client to the stand-in server - receives its requests and answers them in the wire protocol
+/// of the server, up to a version, keeping clients and files in a store in memory
+/// </summary>
+class StandInSession {
+
+private:
+	// members
+	tcp::socket socket;
+	MemoryStore& store;
+	uint8_t maxVersion;
+	SessionStats stats;
+
+	/// <summary>
+	/// Receives exactly the size of a buffer from the client
+	/// </summary>
+	/// <param name="buffer"></param>
+	/// <param name="size"></param>
+	void receiveExact(char* buffer, size_t size);
+
+	/// <summary>
+	/// Receives a request - header, request id (from the pipelining version on, but registration) and payload
+	/// </summary>
+	/// <param name="request"></param>
+	/// <returns>false if the client closed the connection</returns>
+	bool receiveRequest(Request& request);
+
+	/// <summary>
+	/// Sends response to client, in the layout of the version of the request it answers
+	/// </summary>
+	/// <param name="request"></param>
+	/// <param name="response"></param>
+	void sendResponse(Request& request, Response& response);
+
+	/// <summary>
+	/// Handles request from client
+	/// </summary>
+	/// <param name="request"></param>
+	/// <returns>false if the connection can't go on</returns>
+	bool handleRequest(Request& request);
+
+	/// <summary>
+	/// Handles client registration request
+	/// </summary>
+	/// <param name="request"></param>
+	void handleRegistration(Request& request);
+
+	/// <summary>
+	/// Generates an AES key for the client and sends it encrypted with the public RSA key of the client
+	/// </summary>
+	/// <param name="request"></param>
+	void sendAesKey(Request& request);
+
+	/// <summary>
+	/// Handles file request - the whole content of a file
+	/// </summary>
+	/// <param name="request"></param>
+	void handleFile(Request& request);
+
+	/// <summary>
+	/// Handles a chunk of a file - answers 2108, or the cksum once all the bytes of the file arrived
+	/// </summary>
+	/// <param name="request"></param>
+	void handleChunk(Request& request);
+
+	/// <summary>
+	/// Handles file digest request - tells the client whether a verified copy of the file is already saved
+	/// </summary>
+	/// <param name="request"></param>
+	void handleFileDigest(Request& request);
+
+	/// <summary>
+	/// Handles cksum requests - ok, error (not answered) and final error
+	/// </summary>
+	/// <param name="request"></param>
+	void handleCksum(Request& request);
+
+	/// <summary>
+	/// Receives filename of a cksum request
+	/// </summary>
+	/// <param name="request"></param>
+	/// <returns></returns>
+	std::string receiveFilename(Request& request);
+
+	/// <summary>
+	/// Decrypts content sent by the client and decompresses it
+	/// </summary>
+	/// <param name="request"></param>
+	/// <param name="encryptedContent"></param>
+	/// <param name="length"></param>
+	/// <param name="codec"></param>
+	/// <returns>the original content</returns>
+	std::string decryptContent(Request& request, const char* encryptedContent, size_t length, uint8_t codec);
+
+	/// <summary>
+	/// Saves a file, calculates its cksum and sends it to the client
+	/// </summary>
+	/// <param name="request"></param>
+	/// <param name="filename"></param>
+	/// <param name="content"></param>
+	void completeFile(Request& request, const std::string& filename, std::string content);
+
+	/// <summary>
+	/// Returns a filename with the null chars it was padded with stripped, in lower case like the server saves it
+	/// </summary>
+	/// <param name="filename"></param>
+	/// <returns></returns>
+	static std::string normalizeFilename(std::string filename);
+
+public:
+	/// <summary>
+	/// Ctor
+	/// </summary>
+	/// <param name="socket">connected socket of the client</param>
+	/// <param name="store"></param>
+	/// <param name="maxVersion">highest protocol version to answer with</param>
+	StandInSession(tcp::socket socket, MemoryStore& store, uint8_t maxVersion);
+
+	/// <summary>
+	/// Answers the requests of the client until it closes the connection
+	/// </summary>
+	void run();
+
+	/// <summary>
+	/// Returns the counts of the session
+	/// </summary>
+	/// <returns></returns>
+	const SessionStats& getStats() const;
+};
@@ -0,0 +1,114 @@
+#include "StandInSession.h"
+#include "MemoryStore.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/// <summary>
+/// Options of a stand-in server run
+/// </summary>
+struct StandInOptions {
+	unsigned short port = 1234;
+	uint8_t maxVersion = STANDIN_VERSION;
+	size_t sessions = 0;
+};
+
+/// <summary>
+/// Parses command line arguments into options
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <param name="options"></param>
+/// <returns>true if all the arguments are valid, false otherwise</returns>
+bool parseOptions(int argc, char* argv[], StandInOptions& options) {
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+
+		try {
+			if (arg == "--port" && std::stoul(value) > 0 && std::stoul(value) <= 65535)
+				options.port = (unsigned short)std::stoul(value);
+			else if (arg == "--max-version" && std::stoul(value) >= LEGACY_VERSION && std::stoul(value) <= STANDIN_VERSION)
+				options.maxVersion = (uint8_t)std::stoul(value);
+			else if (arg == "--sessions")
+				options.sessions = std::stoul(value);
+			else
+				return false;
+		}
+		catch (std::exception&) {
+			return false;
+		}
+	}
+
+	// every option is followed by its value
+	return argc % 2 == 1;
+}
+
+/// <summary>
+/// Serves clients in the wire protocol of the server with clients and files kept in memory, so the throughput and
+/// latency of a client can be measured without the cost of the real server. Every session is reported when it ends,
+/// and all of them together once --sessions sessions ended
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int main(int argc, char* argv[])
+{
+	StandInOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		std::cout << "Usage: standin [--port <port>] [--max-version <3-" << (int)STANDIN_VERSION << ">] "
+			"[--sessions <count>]" << std::endl;
+		return 1;
+	}
+
+	MemoryStore store;
+	SessionStats total;
+	size_t endedSessions = 0;
+	std::chrono::steady_clock::time_point firstAccepted;
+	std::chrono::steady_clock::time_point lastEnded;
+	std::mutex statsMutex;
+	std::condition_variable sessionEnded;
+
+	// the sockets of the sessions belong to the context, so it outlives them
+	boost::asio::io_context ioContext;
+	try {
+		tcp::acceptor acceptor(ioContext, tcp::endpoint(tcp::v4(), options.port));
+		std::cout << "Listening on port " << options.port << ", protocol version " << (int)options.maxVersion
+			<< std::endl;
+
+		// a thread per connection, like the server - sessions are joined by counting the ones that ended
+		for (size_t accepted = 0; options.sessions == 0 || accepted < options.sessions; accepted++) {
+			tcp::socket socket(ioContext);
+			acceptor.accept(socket);
+			if (accepted == 0)
+				firstAccepted = std::chrono::steady_clock::now();
+			std::string name = socket.remote_endpoint().address().to_string() + ":"
+				+ std::to_string(socket.remote_endpoint().port());
+
+			std::thread([&, name](tcp::socket socket) {
+				StandInSession session(std::move(socket), store, options.maxVersion);
+				session.run();
+
+				std::lock_guard<std::mutex> lock(statsMutex);
+				session.getStats().write(std::cout, "session " + name);
+				total.add(session.getStats());
+				lastEnded = std::chrono::steady_clock::now();
+				endedSessions++;
+				sessionEnded.notify_all();
+			}, std::move(socket)).detach();
+		}
+	}
+	catch (std::exception& e) {
+		std::cerr << "Exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::unique_lock<std::mutex> lock(statsMutex);
+	sessionEnded.wait(lock, [&]() { return endedSessions == options.sessions; });
+
+	// the throughput of the run is over the time from the first connection to the end of the last session
+	total.duration = lastEnded - firstAccepted;
+	total.write(std::cout, "total of " + std::to_string(endedSessions) + " sessions");
+	return 0;
+}